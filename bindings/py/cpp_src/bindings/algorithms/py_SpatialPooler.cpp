@@ -138,6 +138,8 @@ namespace nupic_ext
         py_SpatialPooler.def("setWrapAround", &SpatialPooler::setWrapAround);
         py_SpatialPooler.def("getUpdatePeriod", &SpatialPooler::getUpdatePeriod);
         py_SpatialPooler.def("setUpdatePeriod", &SpatialPooler::setUpdatePeriod);
+        py_SpatialPooler.def("getNumThreads", &SpatialPooler::getNumThreads);
+        py_SpatialPooler.def("setNumThreads", &SpatialPooler::setNumThreads);
         py_SpatialPooler.def("getSynPermActiveInc", &SpatialPooler::getSynPermActiveInc);
         py_SpatialPooler.def("setSynPermActiveInc", &SpatialPooler::setSynPermActiveInc);
         py_SpatialPooler.def("getSynPermInactiveDec", &SpatialPooler::getSynPermInactiveDec);
@@ -21,7 +21,9 @@
  */
 
 #include <algorithm> // std::generate
+#include <cmath> // sqrt
 #include <iostream>
+#include <thread> // hardware_concurrency
 #include <vector>
 
 #include "HelloSPTP.hpp"
@@ -201,4 +203,65 @@ Real64 BenchmarkHotgym::run(UInt EPOCHS, bool useSPlocal, bool useSPglobal, bool
   } //end for
   return tAll.getElapsed();
 } //end run()
+
+
+Real64 BenchmarkHotgym::runSPScaling(UInt EPOCHS, UInt maxThreads, bool globalInhibition, const UInt COLS, const UInt DIM_INPUT) {
+#ifndef NDEBUG
+  EPOCHS = 2; // make test faster in Debug
+#endif
+  if(maxThreads == 0) {
+    maxThreads = max(1u, std::thread::hardware_concurrency());
+  }
+  // Local inhibition needs a topology, so lay out inputs & columns as squares.
+  const UInt colSide = (UInt)sqrt((Real64)COLS);
+  const UInt inSide  = (UInt)sqrt((Real64)DIM_INPUT);
+  NTA_CHECK(colSide * colSide == COLS && inSide * inSide == DIM_INPUT)
+    << "SP scaling benchmark requires square COLS and DIM_INPUT";
+
+  std::cout << "SP scaling. DIM_INPUT=" << DIM_INPUT << ", DIM=" << COLS
+            << (globalInhibition ? ", global" : ", local") << " inhibition"
+            << ", EPOCHS=" << EPOCHS << ", up to " << maxThreads << " threads" << std::endl;
+
+  // Same inputs for every run.
+  Random rnd(42);
+  vector<SDR> inputs;
+  for(UInt e = 0; e < EPOCHS; e++) {
+    inputs.emplace_back(vector<UInt>{inSide, inSide});
+    inputs.back().randomize(0.02f, rnd);
+  }
+
+  vector<vector<UInt>> expected;
+  Real64 best = 0.0;
+  Real64 serial = 0.0;
+  for(UInt threads = 1u; threads <= maxThreads; threads *= 2u) {
+    SpatialPooler sp(vector<UInt>{inSide, inSide}, vector<UInt>{colSide, colSide},
+                     /*potentialRadius*/ 5u, /*potentialPct*/ 0.5f, globalInhibition,
+                     /*localAreaDensity*/ 0.02f, /*numActiveColumnsPerInhArea*/ -1);
+    sp.setNumThreads(threads);
+    SDR columns({colSide, colSide});
+
+    Timer t;
+    t.start();
+    for(UInt e = 0; e < EPOCHS; e++) {
+      sp.compute(inputs[e], true, columns);
+      if(threads == 1u) {
+        expected.push_back(columns.getSparse());
+      } else {
+        NTA_CHECK(columns.getSparse() == expected[e])
+          << "SP with " << threads << " threads differs from serial, epoch " << e;
+      }
+    }
+    t.stop();
+
+    const Real64 elapsed = t.getElapsed();
+    if(threads == 1u) {
+      serial = elapsed;
+      best = elapsed;
+    }
+    best = min(best, elapsed);
+    cout << "threads=" << threads << "\tSP:\t" << elapsed
+         << "\tspeedup:\t" << serial / elapsed << endl;
+  }
+  return best;
+} //end runSPScaling()
 } //-ns
@@ -24,6 +24,20 @@ public:
     const UInt CELLS = 10 // cells per column in TP
   );
 
+  /**
+   * Runs a large SpatialPooler (64k columns by default) with 1, 2, 4, ...
+   * up to maxThreads threads, prints the time and speedup of each, and checks
+   * that every thread count computes the same columns.
+   * Returns the time of the fastest run.
+   */
+  Real64 runSPScaling(
+    UInt EPOCHS = 100,
+    UInt maxThreads = 0, // 0 = all hardware threads
+    bool globalInhibition = true,
+    const UInt COLS = 256*256,
+    const UInt DIM_INPUT = 100*100
+  );
+
   //timers
   Timer tInit, tAll, tRng, tEnc, tSPloc, tSPglob, tTM,
         tAn, tAnLikelihood;
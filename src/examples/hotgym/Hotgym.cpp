@@ -3,14 +3,26 @@
 #include <string> // stoi
 
 //this runs as executable
+// usage: benchmark_hotgym [EPOCHS]
+//        benchmark_hotgym scaling [EPOCHS [THREADS [local]]]
 int main(int argc, char* argv[]) {
   nupic::UInt EPOCHS = 5000; // number of iterations (calls to SP/TP compute() )
 
+  auto bench = examples::BenchmarkHotgym();
+  if(argc >= 2 && std::string(argv[1]) == "scaling") { // SP thread scaling on 64k columns
+    EPOCHS = 100;
+    nupic::UInt threads = 0; // all
+    if(argc >= 3) EPOCHS  = std::stoi(argv[2]);
+    if(argc >= 4) threads = std::stoi(argv[3]);
+    const bool global = !(argc >= 5 && std::string(argv[4]) == "local");
+    bench.runSPScaling(EPOCHS, threads, global);
+    return 0;
+  }
+
   if(argc == 2) {
     EPOCHS = std::stoi(argv[1]);
   }
 
-  auto bench = examples::BenchmarkHotgym();
   bench.run(EPOCHS);
   return 0;
 }
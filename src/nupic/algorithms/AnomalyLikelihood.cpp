@@ -1,7 +1,7 @@
 #include <nupic/algorithms/AnomalyLikelihood.hpp>
 
+#include <algorithm>
 #include <iostream>
-#include <numeric> //accumulate, inner_product
 
 #include <nupic/utils/Log.hpp> // NTA_CHECK
 
@@ -14,8 +14,6 @@ namespace nupic {
 namespace algorithms {
 namespace anomaly {
 
-static Real compute_mean(const vector<Real>& v); //forward declaration
-static Real compute_var(const vector<Real>& v, Real mean);
 static UInt calcSkipRecords_(UInt numIngested, UInt windowSize, UInt learningPeriod);
 
 
@@ -52,8 +50,21 @@ Real AnomalyLikelihood::anomalyProbability(Real anomalyScore, int timestamp) {
 
     // store into relevant variables
     this->runningRawAnomalyScores_.append(anomalyScore);
-    auto newAvg = this->averagedAnomaly_.compute(anomalyScore);
-    this->runningAverageAnomalies_.append(newAvg);
+    const Real newAvg = this->averagedAnomaly_.compute(anomalyScore);
+    Real droppedAvg;
+    const bool dropped = this->runningAverageAnomalies_.append(newAvg, &droppedAvg);
+    // The rounding errors of adding and dropping values would build up on an
+    // unbounded stream, so the sums are recomputed once per window length.
+    if (++averageAnomaliesUpdates_ >= runningAverageAnomalies_.size()) {
+      resetAverageAnomaliesSums_();
+    } else {
+      if (dropped) {
+        averageAnomaliesSum_   -= droppedAvg;
+        averageAnomaliesSumSq_ -= droppedAvg * droppedAvg;
+      }
+      averageAnomaliesSum_   += newAvg;
+      averageAnomaliesSumSq_ += newAvg * newAvg;
+    }
     this->iteration_++;
 
     // We ignore the first probationaryPeriod data points - as we cannot reliably compute distribution statistics for estimating likelihood
@@ -62,19 +73,14 @@ Real AnomalyLikelihood::anomalyProbability(Real anomalyScore, int timestamp) {
       return DEFAULT_ANOMALY;
     } //else {
 
-    const auto anomalies = this->runningAverageAnomalies_.getData();
-
       // On a rolling basis we re-estimate the distribution
       if ((timeElapsed >= initialTimestamp_ + reestimationPeriod)   || distribution_.name == "unknown" ) {
         auto numSkipRecords = calcSkipRecords_(this->iteration_, (UInt)this->runningAverageAnomalies_.size(), this->learningPeriod); //FIXME this erase (numSkipRecords) is a problem when we use sliding window (as opposed to vector)! - should we skip only once on beginning, or on each call of this fn?
-        estimateAnomalyLikelihoods_(anomalies, numSkipRecords);  // called to update this->distribution_;
+        estimateAnomalyLikelihoods_(numSkipRecords);  // called to update this->distribution_;
         if  (timeElapsed >= initialTimestamp_ + reestimationPeriod)  { initialTimestamp_ = -1; } //reset init T
       }
 
-    const auto likelihoods = updateAnomalyLikelihoods_(anomalies);
-
-      NTA_ASSERT(likelihoods.size() > 0);
-      likelihood = 1.0f - likelihoods[0];
+      likelihood = 1.0f - updateAnomalyLikelihoods_();
       NTA_ASSERT(likelihood >= 0.0 && likelihood <= 1.0);
 
     this->runningLikelihoods_.append(likelihood);
@@ -136,10 +142,8 @@ Real AnomalyLikelihood::tailProbability_(Real x) const {
 }
 
 
-DistributionParams AnomalyLikelihood::estimateNormal_(const vector<Real>& anomalyScores, bool performLowerBoundCheck) {
-    auto mean = compute_mean(anomalyScores);
-    auto var = compute_var(anomalyScores, mean);
-  DistributionParams params = DistributionParams("normal", mean, var, 0.0);
+DistributionParams AnomalyLikelihood::estimateNormal_(Real mean, Real variance, bool performLowerBoundCheck) {
+  DistributionParams params = DistributionParams("normal", mean, variance, 0.0);
 
   if (performLowerBoundCheck) {
     /* Handle edge case of almost no deviations and super low anomaly scores. We
@@ -166,132 +170,78 @@ DistributionParams AnomalyLikelihood::estimateNormal_(const vector<Real>& anomal
   return params;
 }
 
-  /**
-  Filter the list of raw (pre-filtered) likelihoods so that we only preserve
-  sharp increases in likelihood. 'likelihoods' can be a numpy array of floats or
-  a list of floats.
-
-  :returns: A new list of floats likelihoods containing the filtered values.
-  **/
-static vector<Real> filterLikelihoods_(const vector<Real>& likelihoods, Real redThreshold=0.99999, Real yellowThreshold=0.999){ //TODO make the redThreshold params of AnomalyLikelihood constructor()
-  redThreshold    = 1.0f - redThreshold;  //TODO maybe we could use the true meaning already in the parameters
-  yellowThreshold = 1.0f - yellowThreshold;
-
-  NTA_CHECK(redThreshold > 0.0 && redThreshold < 1.0);
-  NTA_CHECK(yellowThreshold > 0.0 && yellowThreshold < 1.0);
-  NTA_CHECK(yellowThreshold >= redThreshold);
-
-  NTA_ASSERT(likelihoods.size() >= 1);
-  // The first value is untouched
-  vector<Real> filteredLikelihoods(likelihoods);
-
-  for (size_t i=1; i< likelihoods.size(); i++) {
-    // value is in the redzone & so was previous
-    if (likelihoods[i] <= redThreshold && filteredLikelihoods[i-1] <= redThreshold) { //TODO review the (original) IFs
-      filteredLikelihoods[i] = yellowThreshold;
-    }
-  }
 
-  NTA_ASSERT(filteredLikelihoods.size()==likelihoods.size());
-  return filteredLikelihoods;
-}
-
-
-vector<Real>  AnomalyLikelihood::updateAnomalyLikelihoods_(const vector<Real>& anomalyScores, UInt verbosity) {
+Real AnomalyLikelihood::updateAnomalyLikelihoods_(UInt verbosity) {
   if (verbosity > 3) {
     cout << "In updateAnomalyLikelihoods."<< endl;
-    cout << "Number of anomaly scores: "<<  anomalyScores.size() << endl;
-//    cout << "First 20:", anomalyScores[0:min(20, len(anomalyScores))])
+    cout << "Number of anomaly scores: "<<  runningAverageAnomalies_.size() << endl;
     cout << "Params: name=" <<  distribution_.name << " mean="<<distribution_.mean <<" var="<<distribution_.variance <<" stdev="<<distribution_.stdev <<endl;
   }
 
- NTA_CHECK(anomalyScores.size() > 0); // "Must have at least one anomalyScore"
-
-  // Compute moving averages of these new scores using the previous values
-  // as well as likelihood for these scores using the old estimator
-  vector<Real> likelihoods;
-  likelihoods.reserve(runningAverageAnomalies_.size());
-  for (size_t i = 0; i < runningAverageAnomalies_.size(); i++) { //TODO we could use transform() here (? or would it be less clear?)
-    auto newAverage = runningAverageAnomalies_[(UInt)i];
-    likelihoods.push_back(tailProbability_(newAverage));
-  }
+  NTA_CHECK(runningAverageAnomalies_.size() > 0); // "Must have at least one anomalyScore"
 
-/*
-  // Filter the likelihood values. First we prepend the historical likelihoods
-  // to the current set. Then we filter the values.  We peel off the likelihoods
-  // to return and the last windowSize values to store for later.
-  UInt toCrop = min((UInt)this->averagedAnomaly_.getMaxWindowSize(), (UInt)runningLikelihoods_.size());
-  this->runningLikelihoods_.insert(runningLikelihoods_.end() - toCrop, likelihoods.begin(),likelihoods.end()); //append & crop //We only update runningLikelihoods in the main loop, not here
-*/
-  auto filteredLikelihoods = filterLikelihoods_(likelihoods);
+  // The filter (which only preserves sharp increases in likelihood, ie.
+  // turns a red value following another red value into yellow) leaves the
+  // first value untouched, so the oldest likelihood is returned unfiltered.
+  const Real likelihood = tailProbability_(runningAverageAnomalies_[0]);
 
   if (verbosity > 3) {
-    cout << "Number of likelihoods:"<< likelihoods.size() << endl;
-//    print("First 20 likelihoods:", likelihoods[0:min(20, len(likelihoods))])
+    cout << "Likelihood: " << likelihood << endl;
     cout << "Leaving updateAnomalyLikelihoods."<< endl;
   }
 
-  return filteredLikelihoods;
+  return likelihood;
 }
 
 
-vector<Real> AnomalyLikelihood::estimateAnomalyLikelihoods_(const vector<Real>& anomalyScores, UInt skipRecords, UInt verbosity) { //FIXME averagingWindow not used, I guess it's not a sliding window, but aggregating window (discrete steps)!
+void AnomalyLikelihood::estimateAnomalyLikelihoods_(UInt skipRecords, UInt verbosity) { //FIXME averagingWindow not used, I guess it's not a sliding window, but aggregating window (discrete steps)!
+  const auto &dataValues = runningAverageAnomalies_.getData(); //FIXME the "data" should be anomaly scores, or raw values?
   if (verbosity > 1) {
     cout << "In estimateAnomalyLikelihoods_."<<endl;
-    cout << "Number of anomaly scores:" <<  anomalyScores.size() << endl;
+    cout << "Number of anomaly scores:" <<  dataValues.size() << endl;
     cout << "Skip records="<<  skipRecords << endl;
-//    print("First 20:", anomalyScores[0:min(20, len(anomalyScores))])
   }
 
-  NTA_CHECK(anomalyScores.size() > 0); // "Must have at least one anomalyScore"
-  auto dataValues = anomalyScores; //FIXME the "data" should be anomaly scores, or raw values?
+  NTA_CHECK(dataValues.size() > 0); // "Must have at least one anomalyScore"
 
   // Estimate the distribution of anomaly scores based on aggregated records
   if (dataValues.size()  <= skipRecords) {
     this->distribution_ =  DistributionParams("normal", 0.5, 1e6, 1e3); //null distribution
   } else {
-    dataValues.erase(dataValues.begin(), dataValues.begin() + skipRecords);// remove first skipRecords
-    this->distribution_ = estimateNormal_(dataValues);
+    // Remove the first skipRecords from the running sums, rather than summing
+    // up all of the remaining records.
+    Real64 sum   = averageAnomaliesSum_;
+    Real64 sumSq = averageAnomaliesSumSq_;
+    for (UInt i = 0; i < skipRecords; i++) {
+      sum   -= dataValues[i];
+      sumSq -= dataValues[i] * dataValues[i];
+    }
+    const size_t count = dataValues.size() - skipRecords;
+    const Real mean = (Real)sum / count;
+    // Cancellation can make a tiny variance come out negative.
+    const Real var  = std::max(0.0f, ((Real)sumSq / count) - (mean * mean));
+    this->distribution_ = estimateNormal_(mean, var);
   }
 
-  // Estimate likelihoods based on this distribution
-  vector<Real> likelihoods;
-  likelihoods.reserve(dataValues.size());
-  for (auto s : dataValues) {
-    likelihoods.push_back(tailProbability_(s));
+  if (verbosity > 1) {
+    cout << "Discovered params: name=" <<  distribution_.name << " mean="<<distribution_.mean <<" var="<<distribution_.variance <<" stdev="<<distribution_.stdev <<endl;
+    cout << "Leaving estimateAnomalyLikelihoods_." << endl;
   }
-  // Filter likelihood values
-  auto filteredLikelihoods = filterLikelihoods_(likelihoods);
-
-
-/*  if verbosity > 1:
-    print("Discovered params=")
-    print(params)
-    print("Number of likelihoods:", len(likelihoods))
-    print("First 20 likelihoods:", (
-      filteredLikelihoods[0:min(20, len(filteredLikelihoods))] ))
-    print("leaving estimateAnomalyLikelihoods_")
-*/
-
-  return filteredLikelihoods;
 }
 
 
-/// HELPER methods (only used internaly in this cpp file)
-static Real compute_mean(const vector<Real>& v)  { //TODO do we have a (more comp. stable) implementation of mean/variance?
-  NTA_ASSERT(v.size() > 0); //avoid division by zero!
-    Real sum = (Real)(std::accumulate(v.begin(), v.end(), 0.0));
-    return sum / v.size();
-}
-
-
-static Real compute_var(const vector<Real>& v, Real mean)  {
-  NTA_ASSERT(v.size() > 0); //avoid division by zero!
-    Real sq_sum = (Real)(std::inner_product(v.begin(), v.end(), v.begin(), 0.0));
-    return (sq_sum / v.size()) - (mean * mean);
+void AnomalyLikelihood::resetAverageAnomaliesSums_() {
+  averageAnomaliesUpdates_ = 0u;
+  averageAnomaliesSum_   = 0.0;
+  averageAnomaliesSumSq_ = 0.0;
+  for (const Real avg : runningAverageAnomalies_.getData()) {
+    averageAnomaliesSum_   += avg;
+    averageAnomaliesSumSq_ += avg * avg;
+  }
 }
 
 
+/// HELPER methods (only used internaly in this cpp file)
 static UInt calcSkipRecords_(UInt numIngested, UInt windowSize, UInt learningPeriod)  {
     /** Return the value of skipRecords for passing to estimateAnomalyLikelihoods
 
@@ -149,6 +149,7 @@ class AnomalyLikelihood : public Serializable {
     ar(CEREAL_NVP(runningRawAnomalyScores_));
     ar(CEREAL_NVP(runningAverageAnomalies_));
     // Note: learningPeriod, reestimationPeriod, probationaryPeriod already set by constructor.
+    resetAverageAnomaliesSums_();
   }
 
 
@@ -179,39 +180,40 @@ class AnomalyLikelihood : public Serializable {
     //methods:
 
   /**
-  Given a series of anomaly scores, compute the likelihood for each score. This
-  function should be called once on a bunch of historical anomaly scores for an
-  initial estimate of the distribution. It should be called again every so often
-  (say every 50 records) to update the estimate.
+  Re-estimate the normal distribution (distribution_) of the running average
+  anomaly scores. This should be called once there are enough historical
+  scores for an initial estimate, and again every so often (say every 50
+  records) to update the estimate.
 
-  :param anomalyScores: a list of anomaly scores
+  The mean and variance are taken from running sums over the historic window,
+  so the cost does not depend on historicWindowSize.
 
-                        For best results, the list should be between 1000
-                        and 10,000 records
-  :param averagingWindow: integer number of records to average over
   :param skipRecords: integer specifying number of records to skip when
                       estimating distributions. If skip records are >=
-                      len(anomalyScores), a very broad distribution is returned
+                      size of the window, a very broad distribution is used
                       that makes everything pretty likely.
   :param verbosity: integer controlling extent of printouts for debugging
 
                       0 = none
                       1 = occasional information
                       2 = print every record
-
-  :returns: vector of lilelihoods: , one for each aggregated point
   **/
-    vector<Real> estimateAnomalyLikelihoods_(const vector<Real>& anomalyScores, UInt skipRecords=0, UInt verbosity=0);
+    void estimateAnomalyLikelihoods_(UInt skipRecords=0, UInt verbosity=0);
 
 
   /**
-  Compute updated probabilities for anomalyScores using the given params.
-  :param anomalyScores: a list of records. Each record is a list with the
+  Compute the (filtered) likelihood reported for the current step, using the
+  current distribution_.
+
+  Only the oldest aggregated point of the window is reported. The filtering of
+  sharp increases in likelihood never modifies the first point of a series, so
+  neither the rest of the window nor the filter has to be evaluated.
+
   :param verbosity: integer controlling extent of printouts for debugging
   :type verbosity: UInt
-  :returns: a vector of likelihoods, one for each aggregated point
+  :returns: the likelihood of the oldest aggregated point
   **/
-    vector<Real>  updateAnomalyLikelihoods_(const vector<Real>& anomalyScores, UInt verbosity=0);
+    Real updateAnomalyLikelihoods_(UInt verbosity=0);
 
 
  /**
@@ -226,12 +228,19 @@ class AnomalyLikelihood : public Serializable {
 
 
   /**
-  :param anomalyScores: vector of (raw) anomaly scores
+  :param mean: mean of the (raw) anomaly scores
+  :param variance: variance of the (raw) anomaly scores
   :param performLowerBoundCheck (bool)
-  :returns: A DistributionParams (struct) containing the parameters of a normal distribution based on
-      the ``anomalyScores``.
+  :returns: A DistributionParams (struct) containing the parameters of a normal
+      distribution with the given moments.
+  **/
+    DistributionParams estimateNormal_(Real mean, Real variance, bool performLowerBoundCheck=true);
+
+
+  /**
+  Recompute the running sums from the contents of runningAverageAnomalies_.
   **/
-    DistributionParams estimateNormal_(const vector<Real>& anomalyScores, bool performLowerBoundCheck=true);
+    void resetAverageAnomaliesSums_();
 
 
     //private variables
@@ -246,6 +255,14 @@ class AnomalyLikelihood : public Serializable {
     nupic::util::SlidingWindow<Real> runningRawAnomalyScores_;
     nupic::util::SlidingWindow<Real> runningAverageAnomalies_; //sliding window of running averages of anomaly scores
 
+    // Running sum and sum of squares of runningAverageAnomalies_, kept in
+    // double precision as values are added and dropped from the window.
+    // They are recomputed from the window after as many updates as the
+    // window holds, counted by averageAnomaliesUpdates_.
+    Real64 averageAnomaliesSum_   = 0.0;
+    Real64 averageAnomaliesSumSq_ = 0.0;
+    size_t averageAnomaliesUpdates_ = 0u;
+
 };
 
 }}} //end-ns
@@ -26,12 +26,16 @@
 
 #include <algorithm> // nth_element
 #include <climits>
+#include <cstring> // memcmp
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <type_traits>
 
 #include <nupic/algorithms/Connections.hpp>
 
 #include <nupic/math/Math.hpp> // nupic::Epsilon
+#include <nupic/math/Simd.hpp>
 
 using std::endl;
 using std::string;
@@ -39,33 +43,169 @@ using std::vector;
 using namespace nupic;
 using namespace nupic::algorithms::connections;
 using nupic::sdr::SDR;
+using nupic::util::Run;
 
-Connections::Connections(CellIdx numCells, Permanence connectedThreshold, bool timeseries) {
-  initialize(numCells, connectedThreshold, timeseries);
+namespace {
+
+// Moves the elements of a run which has moved from the given offset.
+template <typename T>
+void moveRun(vector<T> &arena, UInt32 from, const Run &run) {
+  std::copy_n(arena.begin() + from, run.size, arena.begin() + run.offset);
+}
+
+// Resizes an arena after its RunAllocator was asked to grow a run, and moves
+// the run's elements if the run has moved from the given offset.  Arenas
+// grow by half at a time rather than doubling, since they are large.
+template <typename T>
+void resizeArena(vector<T> &arena, size_t size, UInt32 from, const Run &run) {
+  if (size > arena.capacity()) {
+    arena.reserve(size + size / 2u);
+  }
+  arena.resize(size);
+  if (from != run.offset) {
+    moveRun(arena, from, run);
+  }
+}
+
+// Moves all runs to the front of their arenas, in order of offset, leaving
+// out the released runs in between.  move(from, run) moves the elements of
+// one run to its new offset.  Returns the new length of the arenas.
+template <typename Move>
+size_t packRuns(vector<Run *> &runs, Move move) {
+  std::sort(runs.begin(), runs.end(),
+            [](const Run *a, const Run *b) { return a->offset < b->offset; });
+  size_t end = 0u;
+  for (Run *run : runs) {
+    if (run->capacity == 0u) continue;
+    const UInt32 from = run->offset;
+    run->offset = static_cast<UInt32>(end);
+    if (from != run->offset) {
+      move(from, *run);
+    }
+    end += run->capacity;
+  }
+  return end;
+}
+
+} // namespace
+
+void PresynapticMap::clear(const bool arenas) {
+  arenas_ = arenas;
+  runs_.clear();
+  synapseArena_.clear();
+  segmentArena_.clear();
+  allocator_.clear();
+  synapseLists_.clear();
+  segmentLists_.clear();
+}
+
+void PresynapticMap::reserveCells(const size_t numCells) {
+  if (numCells <= this->numCells()) return;
+  if (arenas_) {
+    runs_.resize(numCells);
+  } else {
+    synapseLists_.resize(numCells);
+    segmentLists_.resize(numCells);
+  }
+}
+
+UInt32 PresynapticMap::add(const CellIdx cell, const Synapse synapse,
+                           const Segment segment) {
+  if (!arenas_) {
+    synapseLists_[cell].push_back(synapse);
+    segmentLists_[cell].push_back(segment);
+    return (UInt32)synapseLists_[cell].size() - 1u;
+  }
+
+  Run &run = runs_[cell];
+  const UInt32 from = allocator_.grow(run);
+  resizeArena(synapseArena_, allocator_.size(), from, run);
+  resizeArena(segmentArena_, allocator_.size(), from, run);
+  if (allocator_.fragmented(runs_.size())) {
+    pack_();
+  }
+
+  synapseArena_[run.offset + run.size] = synapse;
+  segmentArena_[run.offset + run.size] = segment;
+  return run.size++;
+}
+
+Synapse PresynapticMap::remove(const CellIdx cell, const UInt32 index) {
+  NTA_ASSERT( index < size(cell) );
+
+  if (!arenas_) {
+    auto &synapses = synapseLists_[cell];
+    auto &segments = segmentLists_[cell];
+    const Synapse move = synapses.back();
+    synapses[index] = move;
+    segments[index] = segments.back();
+    synapses.pop_back();
+    segments.pop_back();
+    return move;
+  }
+
+  Run &run = runs_[cell];
+  const UInt32 last = run.offset + run.size - 1u;
+  const Synapse move = synapseArena_[last];
+  synapseArena_[run.offset + index] = move;
+  segmentArena_[run.offset + index] = segmentArena_[last];
+  run.size--;
+  return move;
+}
+
+void PresynapticMap::pack_() {
+  // The indexes of the synapses in the lists are relative to the runs, so
+  // they do not change when the runs move.
+  vector<Run *> runs;
+  runs.reserve(runs_.size());
+  for (auto &run : runs_) {
+    runs.push_back(&run);
+  }
+  const size_t size = packRuns(runs, [&](UInt32 from, const Run &run) {
+    moveRun(synapseArena_, from, run);
+    moveRun(segmentArena_, from, run);
+  });
+  synapseArena_.resize(size);
+  segmentArena_.resize(size);
+  allocator_.packed(size);
 }
 
-void Connections::initialize(CellIdx numCells, Permanence connectedThreshold, bool timeseries) {
+Connections::Connections(CellIdx numCells, Permanence connectedThreshold,
+                         bool timeseries, bool presynapticArenas) {
+  initialize(numCells, connectedThreshold, timeseries, presynapticArenas);
+}
+
+void Connections::initialize(CellIdx numCells, Permanence connectedThreshold,
+                             bool timeseries, bool presynapticArenas) {
+  // Every container here is a flat array, so this releases the previous
+  // contents with a fixed number of deallocations.  The one exception is a
+  // presynaptic index without arenas, which has a list per presynaptic cell.
   cells_ = vector<CellData>(numCells);
+  segmentArena_.clear();
+  segmentRuns_.clear();
   segments_.clear();
   destroyedSegments_.clear();
-  synapses_.clear();
+  synapseArena_.clear();
+  presynapticCellArena_.clear();
+  permanenceArena_.clear();
+  synapseRuns_.clear();
+  synapseSegments_.clear();
+  synapseSlots_.clear();
+  presynapticMapIndexes_.clear();
   destroyedSynapses_.clear();
-  potentialSynapsesForPresynapticCell_.clear();
-  connectedSynapsesForPresynapticCell_.clear();
-  potentialSegmentsForPresynapticCell_.clear();
-  connectedSegmentsForPresynapticCell_.clear();
+  potentialMap_.clear(presynapticArenas);
+  connectedMap_.clear(presynapticArenas);
   segmentOrdinals_.clear();
-  synapseOrdinals_.clear();
   eventHandlers_.clear();
   NTA_CHECK(connectedThreshold >= minPermanence);
   NTA_CHECK(connectedThreshold <= maxPermanence);
   connectedThreshold_ = connectedThreshold - nupic::Epsilon;
 
-  // Every time a segment or synapse is created, we assign it an ordinal and
-  // increment the nextOrdinal. Ordinals are never recycled, so they can be used
-  // to order segments or synapses by age.
+  // Every time a segment is created, we assign it an ordinal and increment
+  // the nextOrdinal. Ordinals are never recycled, so they can be used to order
+  // segments by age.  Synapses keep their age order by position in the
+  // segment's run, and find that position through synapseSlots_.
   nextSegmentOrdinal_ = 0;
-  nextSynapseOrdinal_ = 0;
 
   nextEventToken_ = 0;
 
@@ -101,9 +241,15 @@ Segment Connections::createSegment(CellIdx cell) {
   segmentData.numConnected = 0;
   segmentData.cell = cell;
 
-  CellData &cellData = cells_[cell];
+  Run &segments = cells_[cell].segments;
+  const UInt32 from = segmentRuns_.grow(segments);
+  resizeArena(segmentArena_, segmentRuns_.size(), from, segments);
+  if (segmentRuns_.fragmented(cells_.size())) {
+    packSegmentArena_();
+  }
+  segmentArena_[segments.offset + segments.size] = segment;
+  segments.size++;
   segmentOrdinals_[segment] = nextSegmentOrdinal_++;
-  cellData.segments.push_back(segment);
 
   for (auto h : eventHandlers_) {
     h.second->onCreateSegment(segment);
@@ -112,37 +258,110 @@ Segment Connections::createSegment(CellIdx cell) {
   return segment;
 }
 
-Synapse Connections::createSynapse(Segment segment,
-                                   CellIdx presynapticCell,
-                                   Permanence permanence) {
-  // Get an index into the synapses_ list, for the new synapse to reside at.
+Segment Connections::createSegment(CellIdx cell,
+                                   const vector<CellIdx> &presynapticCells,
+                                   const vector<Permanence> &permanences) {
+  const Segment segment = createSegment(cell);
+  createSynapses(segment, presynapticCells, permanences);
+  return segment;
+}
+
+void Connections::packSegmentArena_() {
+  vector<Run *> runs;
+  runs.reserve(cells_.size());
+  for (auto &cell : cells_) {
+    runs.push_back(&cell.segments);
+  }
+  const size_t size = packRuns(runs, [&](UInt32 from, const Run &run) {
+    moveRun(segmentArena_, from, run);
+  });
+  segmentArena_.resize(size);
+  segmentRuns_.packed(size);
+}
+
+void Connections::setSynapseSlots_(const Run &run) {
+  for (UInt32 slot = run.offset; slot < run.offset + run.size; slot++) {
+    synapseSlots_[synapseArena_[slot]] = slot;
+  }
+}
+
+void Connections::packSynapseArenas_() {
+  vector<Run *> runs;
+  runs.reserve(segments_.size());
+  for (auto &segment : segments_) {
+    runs.push_back(&segment.synapses);
+  }
+  const size_t size = packRuns(runs, [&](UInt32 from, const Run &run) {
+    moveRun(synapseArena_, from, run);
+    moveRun(presynapticCellArena_, from, run);
+    moveRun(permanenceArena_, from, run);
+    setSynapseSlots_(run);
+  });
+  synapseArena_.resize(size);
+  presynapticCellArena_.resize(size);
+  permanenceArena_.resize(size);
+  synapseRuns_.packed(size);
+}
+
+void Connections::reserveSynapses_(const Segment segment, const UInt32 capacity) {
+  Run &synapses = segments_[segment].synapses;
+  const UInt32 from = synapseRuns_.reserve(synapses, capacity);
+  resizeArena(synapseArena_, synapseRuns_.size(), from, synapses);
+  resizeArena(presynapticCellArena_, synapseRuns_.size(), from, synapses);
+  resizeArena(permanenceArena_, synapseRuns_.size(), from, synapses);
+  if (from != synapses.offset) {
+    setSynapseSlots_(synapses);
+  }
+  if (synapseRuns_.fragmented(segments_.size())) {
+    packSynapseArenas_();
+  }
+}
+
+void Connections::appendSynapse_(const Segment segment, const Synapse synapse,
+                                 const CellIdx presynapticCell,
+                                 const Permanence permanence) {
+  Run &synapses = segments_[segment].synapses;
+  reserveSynapses_(segment, synapses.size + 1u);
+  const UInt32 slot = synapses.offset + synapses.size;
+  synapses.size++;
+
+  synapseArena_[slot]         = synapse;
+  presynapticCellArena_[slot] = presynapticCell;
+  permanenceArena_[slot]      = permanence;
+  synapseSegments_[synapse]   = segment;
+  synapseSlots_[synapse]      = slot;
+}
+
+Synapse Connections::newSynapse_() {
   Synapse synapse;
   if (!destroyedSynapses_.empty() ) {
     synapse = destroyedSynapses_.back();
     destroyedSynapses_.pop_back();
   } else {
-    NTA_CHECK(synapses_.size() < std::numeric_limits<Synapse>::max()) << "Add synapse failed: Range of Synapse (data-type) insufficient size."
-	    << synapses_.size() << " < " << (size_t)std::numeric_limits<Synapse>::max();
-    synapse = static_cast<Synapse>(synapses_.size());
-    synapses_.push_back(SynapseData());
-    synapseOrdinals_.push_back(0);
-  }
-
-  // Fill in the new synapse's data
-  SynapseData &synapseData    = synapses_[synapse];
-  synapseData.presynapticCell = presynapticCell;
-  synapseData.segment         = segment;
-  synapseOrdinals_[synapse]   = nextSynapseOrdinal_++;
-  // Start in disconnected state.
-  synapseData.permanence           = connectedThreshold_ - 1.0f;
-  synapseData.presynapticMapIndex_ = 
-    (Synapse)potentialSynapsesForPresynapticCell_[presynapticCell].size();
-  potentialSynapsesForPresynapticCell_[presynapticCell].push_back(synapse);
-  potentialSegmentsForPresynapticCell_[presynapticCell].push_back(segment);
+    NTA_CHECK(synapseSegments_.size() < std::numeric_limits<Synapse>::max()) << "Add synapse failed: Range of Synapse (data-type) insufficient size."
+	    << synapseSegments_.size() << " < " << (size_t)std::numeric_limits<Synapse>::max();
+    synapse = static_cast<Synapse>(synapseSegments_.size());
+    synapseSegments_.push_back(0);
+    synapseSlots_.push_back(0);
+    presynapticMapIndexes_.push_back(0);
+  }
+  return synapse;
+}
 
-  SegmentData &segmentData = segments_[segment];
-  segmentData.synapses.push_back(synapse);
+Synapse Connections::createSynapse(Segment segment,
+                                   CellIdx presynapticCell,
+                                   Permanence permanence) {
+  // Get an index into the synapse tables, for the new synapse to reside at.
+  const Synapse synapse = newSynapse_();
 
+  // Fill in the new synapse's data, starting in disconnected state.
+  appendSynapse_(segment, synapse, presynapticCell, connectedThreshold_ - 1.0f);
+
+  // Grow the presynaptic index to cover this cell.
+  const size_t numPresynapticCells = static_cast<size_t>(presynapticCell) + 1u;
+  potentialMap_.reserveCells( numPresynapticCells );
+  connectedMap_.reserveCells( numPresynapticCells );
+  addSynapseToPresynapticMap_(synapse, presynapticCell, false);
 
   for (auto h : eventHandlers_) {
     h.second->onCreateSynapse(synapse);
@@ -153,41 +372,77 @@ Synapse Connections::createSynapse(Segment segment,
   return synapse;
 }
 
+void Connections::createSynapses(Segment segment,
+                                 const vector<CellIdx> &presynapticCells,
+                                 const vector<Permanence> &permanences) {
+  NTA_CHECK(presynapticCells.size() == permanences.size());
+  if (presynapticCells.empty()) {
+    return;
+  }
+
+  // Make room for all of the new synapses on the segment at once.
+  reserveSynapses_(segment, segments_[segment].synapses.size +
+                                static_cast<UInt32>(presynapticCells.size()));
+
+  // Grow the presynaptic index to cover these cells.
+  const CellIdx maxCell =
+      *std::max_element(presynapticCells.begin(), presynapticCells.end());
+  const size_t numPresynapticCells = static_cast<size_t>(maxCell) + 1u;
+  potentialMap_.reserveCells( numPresynapticCells );
+  connectedMap_.reserveCells( numPresynapticCells );
+
+  for (size_t i = 0; i < presynapticCells.size(); i++) {
+    const Synapse synapse = newSynapse_();
+    const CellIdx presynapticCell = presynapticCells[i];
+    Permanence permanence = std::min(permanences[i], maxPermanence);
+    permanence = std::max(permanence, minPermanence);
+    const bool connected = permanence >= connectedThreshold_;
+
+    appendSynapse_(segment, synapse, presynapticCell, permanence);
+    if( connected ) {
+      segments_[segment].numConnected++;
+    }
+    addSynapseToPresynapticMap_(synapse, presynapticCell, connected);
+
+    for (auto h : eventHandlers_) {
+      h.second->onCreateSynapse(synapse);
+      if( connected ) {
+        h.second->onUpdateSynapsePermanence(synapse, permanence);
+      }
+    }
+  }
+}
+
 bool Connections::segmentExists_(Segment segment) const {
   const SegmentData &segmentData = segments_[segment];
-  const vector<Segment> &segmentsOnCell = cells_[segmentData.cell].segments;
+  const SegmentList segmentsOnCell = segmentsForCell(segmentData.cell);
   return (std::find(segmentsOnCell.begin(), segmentsOnCell.end(), segment) !=
           segmentsOnCell.end());
 }
 
 bool Connections::synapseExists_(Synapse synapse) const {
-  const SynapseData &synapseData = synapses_[synapse];
-  const vector<Synapse> &synapsesOnSegment =
-      segments_[synapseData.segment].synapses;
+  const SynapseList synapsesOnSegment = synapsesForSegment(synapseSegments_[synapse]);
   return (std::find(synapsesOnSegment.begin(), synapsesOnSegment.end(),
                     synapse) != synapsesOnSegment.end());
 }
 
-/**
- * Helper method to remove a synapse from a presynaptic map, by moving the
- * last synapse in the list over this synapse.
- */
-void Connections::removeSynapseFromPresynapticMap_(
-    const Synapse index,
-    vector<Synapse> &preSynapses,
-    vector<Segment> &preSegments)
+void Connections::addSynapseToPresynapticMap_(const Synapse synapse,
+                                              const CellIdx presynapticCell,
+                                              const bool connected)
 {
-  NTA_ASSERT( !preSynapses.empty() );
-  NTA_ASSERT( index < preSynapses.size() );
-  NTA_ASSERT( preSynapses.size() == preSegments.size() );
-
-  const auto move = preSynapses.back();
-  synapses_[move].presynapticMapIndex_ = index;
-  preSynapses[index] = move;
-  preSynapses.pop_back();
+  PresynapticMap &map = connected ? connectedMap_ : potentialMap_;
+  presynapticMapIndexes_[synapse] =
+      (Synapse)map.add(presynapticCell, synapse, synapseSegments_[synapse]);
+}
 
-  preSegments[index] = preSegments.back();
-  preSegments.pop_back();
+void Connections::removeSynapseFromPresynapticMap_(const Synapse synapse,
+                                                   const bool connected)
+{
+  PresynapticMap &map = connected ? connectedMap_ : potentialMap_;
+  const Synapse index = presynapticMapIndexes_[synapse];
+  const CellIdx presynapticCell = presynapticCellArena_[synapseSlots_[synapse]];
+  const Synapse moved = map.remove(presynapticCell, index);
+  presynapticMapIndexes_[moved] = index;
 }
 
 void Connections::destroySegment(Segment segment) {
@@ -200,21 +455,25 @@ void Connections::destroySegment(Segment segment) {
 
   // Destroy synapses from the end of the list, so that the index-shifting is
   // easier to do.
-  while( !segmentData.synapses.empty() )
-    destroySynapse(segmentData.synapses.back());
+  while( segmentData.synapses.size > 0 )
+    destroySynapse(synapsesForSegment(segment).back());
+  synapseRuns_.release(segmentData.synapses);
 
-  CellData &cellData = cells_[segmentData.cell];
+  Run &segments = cells_[segmentData.cell].segments;
+  const auto begin = segmentArena_.begin() + segments.offset;
+  const auto end   = begin + segments.size;
 
   const auto segmentOnCell =
-      std::lower_bound(cellData.segments.begin(), cellData.segments.end(),
+      std::lower_bound(begin, end,
                        segment, [&](Segment a, Segment b) {
                          return segmentOrdinals_[a] < segmentOrdinals_[b];
                        });
 
-  NTA_ASSERT(segmentOnCell != cellData.segments.end());
+  NTA_ASSERT(segmentOnCell != end);
   NTA_ASSERT(*segmentOnCell == segment);
 
-  cellData.segments.erase(segmentOnCell);
+  std::copy(segmentOnCell + 1, end, segmentOnCell);
+  segments.size--;
 
   destroyedSegments_.push_back(segment);
 }
@@ -225,94 +484,88 @@ void Connections::destroySynapse(Synapse synapse) {
     h.second->onDestroySynapse(synapse);
   }
 
-  const SynapseData &synapseData = synapses_[synapse];
-        SegmentData &segmentData = segments_[synapseData.segment];
-  const auto         presynCell  = synapseData.presynapticCell;
+  SegmentData &segmentData = segments_[synapseSegments_[synapse]];
+  const UInt32 slot        = synapseSlots_[synapse];
 
-  if( synapseData.permanence >= connectedThreshold_ ) {
+  if( permanenceArena_[slot] >= connectedThreshold_ ) {
     segmentData.numConnected--;
 
-    removeSynapseFromPresynapticMap_(
-      synapseData.presynapticMapIndex_,
-      connectedSynapsesForPresynapticCell_.at( presynCell ),
-      connectedSegmentsForPresynapticCell_.at( presynCell ));
-
-    if( connectedSynapsesForPresynapticCell_.at( presynCell ).empty() ){
-      connectedSynapsesForPresynapticCell_.erase( presynCell );
-      connectedSegmentsForPresynapticCell_.erase( presynCell );
-    }
+    removeSynapseFromPresynapticMap_(synapse, true);
   }
   else {
-    removeSynapseFromPresynapticMap_(
-      synapseData.presynapticMapIndex_,
-      potentialSynapsesForPresynapticCell_.at( presynCell ),
-      potentialSegmentsForPresynapticCell_.at( presynCell ));
-
-    if( potentialSynapsesForPresynapticCell_.at( presynCell ).empty() ){
-      potentialSynapsesForPresynapticCell_.erase( presynCell );
-      potentialSegmentsForPresynapticCell_.erase( presynCell );
-    }
+    removeSynapseFromPresynapticMap_(synapse, false);
   }
 
-  const auto synapseOnSegment =
-      std::lower_bound(segmentData.synapses.begin(), segmentData.synapses.end(),
-                       synapse, [&](Synapse a, Synapse b) {
-                         return synapseOrdinals_[a] < synapseOrdinals_[b];
-                       });
-
-  NTA_ASSERT(synapseOnSegment != segmentData.synapses.end());
-  NTA_ASSERT(*synapseOnSegment == synapse);
-
-  segmentData.synapses.erase(synapseOnSegment);
+  // Close the gap in the segment's run, keeping the synapses in order.
+  Run &synapses    = segmentData.synapses;
+  const UInt32 end = synapses.offset + synapses.size;
+  NTA_ASSERT(slot >= synapses.offset && slot < end);
+  NTA_ASSERT(synapseArena_[slot] == synapse);
+  std::copy(synapseArena_.begin() + slot + 1u, synapseArena_.begin() + end,
+            synapseArena_.begin() + slot);
+  std::copy(presynapticCellArena_.begin() + slot + 1u, presynapticCellArena_.begin() + end,
+            presynapticCellArena_.begin() + slot);
+  std::copy(permanenceArena_.begin() + slot + 1u, permanenceArena_.begin() + end,
+            permanenceArena_.begin() + slot);
+  synapses.size--;
+  for (UInt32 i = slot; i < end - 1u; i++) {
+    synapseSlots_[synapseArena_[i]] = i;
+  }
 
   destroyedSynapses_.push_back(synapse);
 }
 
 void Connections::updateSynapsePermanence(Synapse synapse,
                                           Permanence permanence) {
+  updateSynapsePermanence_(synapse, permanence, nullptr);
+}
+
+void Connections::updateSynapsePermanence_(Synapse synapse,
+                                           Permanence permanence,
+                                           vector<PendingSynapseUpdate> *pending) {
   permanence = std::min(permanence, maxPermanence );
   permanence = std::max(permanence, minPermanence );
 
-  auto &synData = synapses_[synapse];
-  
-  const bool before = synData.permanence >= connectedThreshold_;
-  const bool after  = permanence         >= connectedThreshold_;
-  synData.permanence = permanence;
+  Permanence &current = permanenceArena_[synapseSlots_[synapse]];
+
+  const bool before = current    >= connectedThreshold_;
+  const bool after  = permanence >= connectedThreshold_;
+  current = permanence;
 
   if( before == after ) { //no change
       return;
   }
-    const auto &presyn    = synData.presynapticCell;
-    auto &potentialPresyn = potentialSynapsesForPresynapticCell_[presyn];
-    auto &potentialPreseg = potentialSegmentsForPresynapticCell_[presyn];
-    auto &connectedPresyn = connectedSynapsesForPresynapticCell_[presyn];
-    auto &connectedPreseg = connectedSegmentsForPresynapticCell_[presyn];
-    const auto &segment   = synData.segment;
-    auto &segmentData     = segments_[segment];
-    
-    if( after ) { //connect
-      segmentData.numConnected++;
+  if( after ) {
+    segments_[synapseSegments_[synapse]].numConnected++;
+  }
+  else {
+    segments_[synapseSegments_[synapse]].numConnected--;
+  }
+
+  if( pending != nullptr ) {
+    pending->push_back({ synapse, permanence });
+    return;
+  }
+  updatePresynapticMaps_(synapse, permanence);
+}
 
+void Connections::updatePresynapticMaps_(Synapse synapse,
+                                         Permanence permanence) {
+    const auto presyn = presynapticCellArena_[synapseSlots_[synapse]];
+
+    if( permanence >= connectedThreshold_ ) { //connect
       // Remove this synapse from presynaptic potential synapses.
-      removeSynapseFromPresynapticMap_( synData.presynapticMapIndex_,
-                                        potentialPresyn, potentialPreseg );
+      removeSynapseFromPresynapticMap_( synapse, false );
 
       // Add this synapse to the presynaptic connected synapses.
-      synData.presynapticMapIndex_ = (Synapse)connectedPresyn.size();
-      connectedPresyn.push_back( synapse );
-      connectedPreseg.push_back( segment );
+      addSynapseToPresynapticMap_( synapse, presyn, true );
     }
     else { //disconnected
-      segmentData.numConnected--;
-
       // Remove this synapse from presynaptic connected synapses.
-      removeSynapseFromPresynapticMap_( synData.presynapticMapIndex_,
-                                        connectedPresyn, connectedPreseg );
+      removeSynapseFromPresynapticMap_( synapse, true );
 
-      // Add this synapse to the presynaptic connected synapses.
-      synData.presynapticMapIndex_ = (Synapse)potentialPresyn.size();
-      potentialPresyn.push_back( synapse );
-      potentialPreseg.push_back( segment );
+      // Add this synapse to the presynaptic potential synapses.
+      addSynapseToPresynapticMap_( synapse, presyn, false );
     }
 
     for (auto h : eventHandlers_) { //TODO handle callbacks in performance-critical method only in Debug?
@@ -320,17 +573,24 @@ void Connections::updateSynapsePermanence(Synapse synapse,
     }
 }
 
-const vector<Segment> &Connections::segmentsForCell(CellIdx cell) const {
-  return cells_[cell].segments;
+void Connections::applyPendingUpdates(const vector<PendingSynapseUpdate> &pending) {
+  for( const auto &update : pending ) {
+    updatePresynapticMaps_(update.synapse, update.permanence);
+  }
+}
+
+SegmentList Connections::segmentsForCell(CellIdx cell) const {
+  NTA_ASSERT(cell < cells_.size()) << "Cell out of bounds! " << cell;
+  return SegmentList(*this, cell);
 }
 
 Segment Connections::getSegment(CellIdx cell, SegmentIdx idx) const {
-  return cells_[cell].segments[idx];
+  return segmentsForCell(cell)[idx];
 }
 
-const vector<Synapse> &Connections::synapsesForSegment(Segment segment) const {
+SynapseList Connections::synapsesForSegment(Segment segment) const {
   NTA_ASSERT(segment < segments_.size()) << "Segment out of bounds! " << segment;
-  return segments_[segment].synapses;
+  return SynapseList(*this, segment);
 }
 
 CellIdx Connections::cellForSegment(Segment segment) const {
@@ -338,7 +598,7 @@ CellIdx Connections::cellForSegment(Segment segment) const {
 }
 
 SegmentIdx Connections::idxOnCellForSegment(Segment segment) const {
-  const vector<Segment> &segments = segmentsForCell(cellForSegment(segment));
+  const SegmentList segments = segmentsForCell(cellForSegment(segment));
   const auto it = std::find(segments.begin(), segments.end(), segment);
   NTA_ASSERT(it != segments.end());
   return (SegmentIdx)std::distance(segments.begin(), it);
@@ -357,15 +617,21 @@ void Connections::mapSegmentsToCells(const Segment *segments_begin,
 }
 
 Segment Connections::segmentForSynapse(Synapse synapse) const {
-  return synapses_[synapse].segment;
+  return synapseSegments_[synapse];
 }
 
 const SegmentData &Connections::dataForSegment(Segment segment) const {
   return segments_[segment];
 }
 
-const SynapseData &Connections::dataForSynapse(Synapse synapse) const {
-  return synapses_[synapse];
+SynapseData Connections::dataForSynapse(Synapse synapse) const {
+  const UInt32 slot = synapseSlots_[synapse];
+  SynapseData data;
+  data.presynapticCell      = presynapticCellArena_[slot];
+  data.permanence           = permanenceArena_[slot];
+  data.segment              = synapseSegments_[synapse];
+  data.presynapticMapIndex_ = presynapticMapIndexes_[synapse];
+  return data;
 }
 
 bool Connections::compareSegments(const Segment a, const Segment b) const {
@@ -382,12 +648,13 @@ bool Connections::compareSegments(const Segment a, const Segment b) const {
 
 vector<Synapse>
 Connections::synapsesForPresynapticCell(CellIdx presynapticCell) const {
-  vector<Synapse> all(
-      potentialSynapsesForPresynapticCell_.at(presynapticCell).begin(),
-      potentialSynapsesForPresynapticCell_.at(presynapticCell).end());
-  all.insert( all.end(),
-      connectedSynapsesForPresynapticCell_.at(presynapticCell).begin(),
-      connectedSynapsesForPresynapticCell_.at(presynapticCell).end());
+  if( presynapticCell >= potentialMap_.numCells() )
+    return vector<Synapse>(); // No synapse was ever created on this cell.
+
+  const Synapse *potential = potentialMap_.synapses(presynapticCell);
+  const Synapse *connected = connectedMap_.synapses(presynapticCell);
+  vector<Synapse> all( potential, potential + potentialMap_.size(presynapticCell) );
+  all.insert( all.end(), connected, connected + connectedMap_.size(presynapticCell) );
   return all;
 }
 
@@ -414,11 +681,13 @@ void Connections::computeActivity(
   }
 
   // Iterate through all connected synapses.
+  const size_t indexSize = connectedMap_.numCells();
   for (const auto& cell : activePresynapticCells) {
-    if (connectedSegmentsForPresynapticCell_.count(cell)) {
-      for(const auto& segment : connectedSegmentsForPresynapticCell_.at(cell)) {
-        ++numActiveConnectedSynapsesForSegment[segment];
-      }
+    if (cell >= indexSize) continue; // No synapses on this cell.
+    const Segment *segments = connectedMap_.segments(cell);
+    const UInt32 size = connectedMap_.size(cell);
+    for(UInt32 i = 0; i < size; i++) {
+      ++numActiveConnectedSynapsesForSegment[segments[i]];
     }
   }
 }
@@ -439,10 +708,66 @@ void Connections::computeActivity(
   std::copy( numActiveConnectedSynapsesForSegment.begin(),
              numActiveConnectedSynapsesForSegment.end(),
              numActivePotentialSynapsesForSegment.begin());
+  const size_t indexSize = potentialMap_.numCells();
   for (const auto& cell : activePresynapticCells) {
-    if (potentialSegmentsForPresynapticCell_.count(cell)) {
-      for(const auto& segment : potentialSegmentsForPresynapticCell_.at(cell)) {
-        ++numActivePotentialSynapsesForSegment[segment];
+    if (cell >= indexSize) continue; // No synapses on this cell.
+    const Segment *segments = potentialMap_.segments(cell);
+    const UInt32 size = potentialMap_.size(cell);
+    for(UInt32 i = 0; i < size; i++) {
+      ++numActivePotentialSynapsesForSegment[segments[i]];
+    }
+  }
+}
+
+void Connections::computeActivity(
+    vector<SynapseIdx> &numActiveConnectedSynapsesForSegment,
+    vector<SynapseIdx> &numActivePotentialSynapsesForSegment,
+    vector<Segment> &touchedSegments,
+    const vector<CellIdx> &activePresynapticCells) {
+  // Only the counters touched by the previous call can be nonzero.  The
+  // output vectors may have been resized since, so skip the segments which
+  // fell off the end.
+  const size_t length = numActivePotentialSynapsesForSegment.size();
+  NTA_ASSERT(numActiveConnectedSynapsesForSegment.size() == length);
+  for (const auto &segment : touchedSegments) {
+    if (segment < length) {
+      numActiveConnectedSynapsesForSegment[segment] = 0;
+      numActivePotentialSynapsesForSegment[segment] = 0;
+    }
+  }
+  touchedSegments.clear();
+  NTA_ASSERT(length == segments_.size());
+
+  if( timeseries_ ) {
+    previousUpdates_.swap( currentUpdates_ );
+    currentUpdates_.clear();
+  }
+
+  // Connected synapses count toward both totals.  A segment is touched when
+  // its potential count leaves zero.
+  const size_t connectedIndexSize = connectedMap_.numCells();
+  for (const auto& cell : activePresynapticCells) {
+    if (cell >= connectedIndexSize) continue; // No synapses on this cell.
+    const Segment *segments = connectedMap_.segments(cell);
+    const UInt32 size = connectedMap_.size(cell);
+    for(UInt32 i = 0; i < size; i++) {
+      const Segment segment = segments[i];
+      if (numActivePotentialSynapsesForSegment[segment]++ == 0) {
+        touchedSegments.push_back(segment);
+      }
+      ++numActiveConnectedSynapsesForSegment[segment];
+    }
+  }
+
+  const size_t potentialIndexSize = potentialMap_.numCells();
+  for (const auto& cell : activePresynapticCells) {
+    if (cell >= potentialIndexSize) continue; // No synapses on this cell.
+    const Segment *segments = potentialMap_.segments(cell);
+    const UInt32 size = potentialMap_.size(cell);
+    for(UInt32 i = 0; i < size; i++) {
+      const Segment segment = segments[i];
+      if (numActivePotentialSynapsesForSegment[segment]++ == 0) {
+        touchedSegments.push_back(segment);
       }
     }
   }
@@ -452,16 +777,18 @@ void Connections::computeActivity(
 void Connections::adaptSegment(const Segment segment, 
                                const SDR &inputs,
                                const Permanence increment,
-                               const Permanence decrement)
+                               const Permanence decrement,
+                               vector<PendingSynapseUpdate> *pending)
 {
   const auto &inputArray = inputs.getDense();
 
   if( timeseries_ ) {
-    previousUpdates_.resize( synapses_.size(), 0.0f );
-    currentUpdates_.resize(  synapses_.size(), 0.0f );
+    NTA_CHECK( pending == nullptr ) << "Deferred learning is not supported with timeseries.";
+    previousUpdates_.resize( synapseSegments_.size(), 0.0f );
+    currentUpdates_.resize(  synapseSegments_.size(), 0.0f );
 
     for( const auto synapse : synapsesForSegment(segment) ) {
-      const SynapseData &synapseData = dataForSynapse(synapse);
+      const SynapseData synapseData = dataForSynapse(synapse);
 
       Permanence update;
       if( inputArray[synapseData.presynapticCell] ) {
@@ -477,17 +804,45 @@ void Connections::adaptSegment(const Segment segment,
     }
   }
   else {
-    for( const auto synapse : synapsesForSegment(segment) ) {
-      const SynapseData &synapseData = dataForSynapse(synapse);
+    const Run &synapses       = segments_[segment].synapses;
+    const CellIdx    *presyn  = presynapticCellArena_.data() + synapses.offset;
+    const Permanence *current = permanenceArena_.data()      + synapses.offset;
+    auto &permanences = permanenceScratch_();
+    auto &deltas      = deltaScratch_();
+    permanences.assign(current, current + synapses.size);
+    deltas.resize(synapses.size);
+    for( size_t i = 0; i < synapses.size; i++ ) {
+      deltas[i] = inputArray[presyn[i]] ? increment : -decrement;
+    }
+    math::simd::addClamped(permanences.data(), deltas.data(), synapses.size,
+                           minPermanence, maxPermanence);
+    storePermanences_(segment, permanences, pending);
+  }
+}
 
-      Permanence permanence = synapseData.permanence;
-      if( inputArray[synapseData.presynapticCell] ) {
-        permanence += increment;
-      } else {
-        permanence -= decrement;
-      }
+vector<Permanence> &Connections::permanenceScratch_() {
+  static thread_local vector<Permanence> scratch;
+  return scratch;
+}
+
+vector<Permanence> &Connections::deltaScratch_() {
+  static thread_local vector<Permanence> scratch;
+  return scratch;
+}
 
-      updateSynapsePermanence(synapse, permanence);
+void Connections::storePermanences_(const Segment segment,
+                                    const vector<Permanence> &permanences,
+                                    vector<PendingSynapseUpdate> *pending) {
+  const Run &synapses = segments_[segment].synapses;
+  Permanence *current = permanenceArena_.data() + synapses.offset;
+  for( size_t i = 0; i < synapses.size; i++ ) {
+    const bool before = current[i]     >= connectedThreshold_;
+    const bool after  = permanences[i] >= connectedThreshold_;
+    if( before == after ) {
+      current[i] = permanences[i];
+    }
+    else {
+      updateSynapsePermanence_(synapseArena_[synapses.offset + i], permanences[i], pending);
     }
   }
 }
@@ -499,18 +854,19 @@ void Connections::adaptSegment(const Segment segment,
  */
 void Connections::raisePermanencesToThreshold(
                   const Segment    segment,
-                  const UInt       segmentThreshold)
+                  const UInt       segmentThreshold,
+                  vector<PendingSynapseUpdate> *pending)
 {
   if( segmentThreshold == 0 ) // No synapses requested to be connected, done.
     return;
 
   NTA_ASSERT(segment < segments_.size()) << "Accessing segment out of bounds.";
-  auto &segData = segments_[segment];
+  const auto &segData = segments_[segment];
   if( segData.numConnected >= segmentThreshold )
     return;   // The segment already satisfies the requirement, done.
 
-  vector<Synapse> &synapses = segData.synapses;
-  if( synapses.empty())
+  const Run &synapses = segData.synapses;
+  if( synapses.size == 0u )
     return;   // No synapses to raise permanences to, no work to do.
 
   // Prune empty segment? No. 
@@ -523,36 +879,39 @@ void Connections::raisePermanencesToThreshold(
   // connect as many synapses as it can.
 
   // Keep segmentThreshold within synapses range.
-  const auto threshold = std::min((size_t)segmentThreshold, synapses.size());
+  const auto threshold = std::min((size_t)segmentThreshold, (size_t)synapses.size);
 
-  // Sort the potential pool by permanence values, and look for the synapse with
-  // the N'th greatest permanence, where N is the desired minimum number of
-  // connected synapses.  Then calculate how much to increase the N'th synapses
-  // permance by such that it becomes a connected synapse.  After that there
-  // will be at least N synapses connected.
+  // Look for the N'th greatest permanence, where N is the desired minimum
+  // number of connected synapses.  Then calculate how much to increase the
+  // N'th synapses permance by such that it becomes a connected synapse.
+  // After that there will be at least N synapses connected.
+  const Permanence *current = permanenceArena_.data() + synapses.offset;
+  auto &permanences = permanenceScratch_();
+  permanences.assign(current, current + synapses.size);
 
   // Threshold is ensured to be >=1 by condition at very beginning if(thresh == 0)... 
-  auto minPermSynPtr = synapses.begin() + threshold - 1;
-
-  const auto permanencesGreater = [&](const Synapse &A, const Synapse &B)
-    { return synapses_[A].permanence > synapses_[B].permanence; };
+  auto minPermPtr = permanences.begin() + threshold - 1;
   // Do a partial sort, it's faster than a full sort.
-  std::nth_element(synapses.begin(), minPermSynPtr, synapses.end(), permanencesGreater);
+  std::nth_element(permanences.begin(), minPermPtr, permanences.end(),
+                   std::greater<Permanence>());
 
-  const Real increment = connectedThreshold_ - synapses_[ *minPermSynPtr ].permanence;
-  if( increment <= 0 ) // If minPermSynPtr is already connected then ...
+  const Real increment = connectedThreshold_ - *minPermPtr;
+  if( increment <= 0 ) // If minPermPtr is already connected then ...
     return;            // Enough synapses are already connected.
 
   // Raise the permance of all synapses in the potential pool uniformly.
-  for( const auto &syn : synapses ) //TODO vectorize: vector + const to all members
-    updateSynapsePermanence(syn, synapses_[syn].permanence + increment); //this is performance HOTSPOT
+  permanences.assign(current, current + synapses.size);
+  math::simd::addClamped(permanences.data(), increment, synapses.size,
+                         minPermanence, maxPermanence);
+  storePermanences_(segment, permanences, pending);
 }
 
 
-void Connections::bumpSegment(const Segment segment, const Permanence delta) {
-  const vector<Synapse> &synapses = synapsesForSegment(segment);
-  for( const auto &syn : synapses ) {
-    updateSynapsePermanence(syn, synapses_[syn].permanence + delta);
+void Connections::bumpSegment(const Segment segment, const Permanence delta,
+                              vector<PendingSynapseUpdate> *pending) {
+  const Run &synapses = segments_[segment].synapses;
+  for( UInt32 slot = synapses.offset; slot < synapses.offset + synapses.size; slot++ ) {
+    updateSynapsePermanence_(synapseArena_[slot], permanenceArena_[slot] + delta, pending);
   }
 }
 
@@ -570,18 +929,16 @@ void Connections::save(std::ostream &outStream) const {
   // only for floating point comparisons.
   outStream << connectedThreshold_ + nupic::Epsilon << " " << endl;
 
-  for (CellData cellData : cells_) {
-    const vector<Segment> &segments = cellData.segments;
+  for (CellIdx cell = 0; cell < static_cast<CellIdx>(cells_.size()); cell++) {
+    const SegmentList segments = segmentsForCell(cell);
     outStream << segments.size() << " ";
 
     for (Segment segment : segments) {
-      const SegmentData &segmentData = segments_[segment];
-
-      const vector<Synapse> &synapses = segmentData.synapses;
+      const SynapseList synapses = synapsesForSegment(segment);
       outStream << synapses.size() << " ";
 
       for (Synapse synapse : synapses) {
-        const SynapseData &synapseData = synapses_[synapse];
+        const SynapseData synapseData = dataForSynapse(synapse);
         outStream << synapseData.presynapticCell << " ";
         outStream << synapseData.permanence << " ";
       }
@@ -611,7 +968,8 @@ void Connections::load(std::istream &inStream) {
   Permanence  connectedThreshold;
   inStream >> numCells;
   inStream >> connectedThreshold;
-  initialize(numCells, connectedThreshold);
+  // Keep the presynaptic index storage which the owner chose.
+  initialize(numCells, connectedThreshold, false, potentialMap_.arenas());
 
   for (UInt cell = 0; cell < numCells; cell++) {
 
@@ -640,34 +998,398 @@ void Connections::load(std::istream &inStream) {
 }
 
 
+namespace {
+
+const char CHECKPOINT_MAGIC[8] = {'N', 'T', 'A', 'C', 'O', 'N', 'N', '\0'};
+const UInt32 CHECKPOINT_BYTE_ORDER = 0x01020304u;
+
+template <typename T> void writeValue(std::ostream &out, const T &value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T> void readValue(std::istream &in, T &value) {
+  in.read(reinterpret_cast<char *>(&value), sizeof(T));
+  NTA_CHECK(in.good()) << "Connections checkpoint is truncated.";
+}
+
+// A packed array is its length followed by its elements.
+template <typename T>
+void writeArray(std::ostream &out, const vector<T> &data) {
+  static_assert(std::is_trivially_copyable<T>::value, "not a flat type");
+  writeValue(out, static_cast<UInt64>(data.size()));
+  if (!data.empty()) {
+    out.write(reinterpret_cast<const char *>(data.data()), data.size() * sizeof(T));
+  }
+}
+
+// Checks that the stream holds at least the given number of bytes, when it
+// can tell, so that a corrupt length fails before it is allocated.
+void checkAvailable(std::istream &in, UInt64 bytes) {
+  const std::streampos here = in.tellg();
+  if (here == std::streampos(-1)) return; // Not seekable.
+  in.seekg(0, std::ios::end);
+  const std::streampos end = in.tellg();
+  in.seekg(here);
+  NTA_CHECK(in.good() && end >= here && static_cast<UInt64>(end - here) >= bytes)
+      << "Connections checkpoint is truncated.";
+}
+
+template <typename T> void readArray(std::istream &in, vector<T> &data) {
+  static_assert(std::is_trivially_copyable<T>::value, "not a flat type");
+  UInt64 size;
+  readValue(in, size);
+  NTA_CHECK(size <= std::numeric_limits<UInt64>::max() / sizeof(T))
+      << "Connections checkpoint is corrupt.";
+  checkAvailable(in, size * sizeof(T));
+  data.resize(static_cast<size_t>(size));
+  if (!data.empty()) {
+    in.read(reinterpret_cast<char *>(data.data()), data.size() * sizeof(T));
+    NTA_CHECK(in.good()) << "Connections checkpoint is truncated.";
+  }
+}
+
+// A list of lists is stored as two packed arrays: the offsets of each list
+// into the second array, which holds all lists back to back.
+template <typename T, typename Row, typename Get>
+void writeLists(std::ostream &out, const vector<Row> &rows, Get get) {
+  vector<UInt64> offsets(rows.size() + 1u, 0u);
+  for (size_t i = 0; i < rows.size(); i++) {
+    offsets[i + 1u] = offsets[i] + get(rows[i]).size();
+  }
+  vector<T> flat;
+  flat.reserve(static_cast<size_t>(offsets.back()));
+  for (const auto &row : rows) {
+    const vector<T> &list = get(row);
+    flat.insert(flat.end(), list.begin(), list.end());
+  }
+  writeArray(out, offsets);
+  writeArray(out, flat);
+}
+
+template <typename T, typename Row, typename Get>
+void readLists(std::istream &in, vector<Row> &rows, Get get) {
+  vector<UInt64> offsets;
+  vector<T> flat;
+  readArray(in, offsets);
+  readArray(in, flat);
+  NTA_CHECK(!offsets.empty() && offsets.back() == flat.size())
+      << "Connections checkpoint is corrupt.";
+  rows.resize(offsets.size() - 1u);
+  for (size_t i = 0; i < rows.size(); i++) {
+    NTA_CHECK(offsets[i] <= offsets[i + 1u] && offsets[i + 1u] <= flat.size())
+        << "Connections checkpoint is corrupt.";
+    get(rows[i]).assign(flat.begin() + static_cast<size_t>(offsets[i]),
+                        flat.begin() + static_cast<size_t>(offsets[i + 1u]));
+  }
+}
+
+template <typename T> vector<T> &self(vector<T> &list) { return list; }
+template <typename T> const vector<T> &constSelf(const vector<T> &list) { return list; }
+
+// A RunAllocator is the length of its arena and its free lists.
+void writeRuns(std::ostream &out, const util::RunAllocator &runs) {
+  writeValue(out, static_cast<UInt64>(runs.size()));
+  writeLists<UInt32>(out, runs.freeRuns(), constSelf<UInt32>);
+}
+
+void readRuns(std::istream &in, util::RunAllocator &runs) {
+  UInt64 size;
+  vector<vector<UInt32>> freeRuns;
+  readValue(in, size);
+  readLists<UInt32>(in, freeRuns, self<UInt32>);
+  runs.restore(static_cast<size_t>(size), freeRuns);
+}
+
+} // namespace
+
+void PresynapticMap::save(std::ostream &outStream) const {
+  writeValue(outStream, static_cast<Byte>(arenas_));
+  if (arenas_) {
+    writeArray(outStream, runs_);
+    writeArray(outStream, synapseArena_);
+    writeArray(outStream, segmentArena_);
+    writeRuns(outStream, allocator_);
+  } else {
+    writeLists<Synapse>(outStream, synapseLists_, constSelf<Synapse>);
+    writeLists<Segment>(outStream, segmentLists_, constSelf<Segment>);
+  }
+}
+
+void PresynapticMap::load(std::istream &inStream) {
+  Byte arenas;
+  readValue(inStream, arenas);
+  clear(arenas != 0);
+  if (arenas_) {
+    readArray(inStream, runs_);
+    readArray(inStream, synapseArena_);
+    readArray(inStream, segmentArena_);
+    readRuns(inStream, allocator_);
+    NTA_CHECK(synapseArena_.size() == allocator_.size() &&
+              segmentArena_.size() == allocator_.size())
+        << "Connections checkpoint is corrupt.";
+    allocator_.check(runs_);
+  } else {
+    readLists<Synapse>(inStream, synapseLists_, self<Synapse>);
+    readLists<Segment>(inStream, segmentLists_, self<Segment>);
+    NTA_CHECK(synapseLists_.size() == segmentLists_.size())
+        << "Connections checkpoint is corrupt.";
+    for (size_t cell = 0; cell < synapseLists_.size(); cell++) {
+      NTA_CHECK(synapseLists_[cell].size() == segmentLists_[cell].size())
+          << "Connections checkpoint is corrupt.";
+    }
+  }
+}
+
+const UInt32 Connections::CHECKPOINT_VERSION;
+
+void Connections::saveCheckpoint(std::ostream &outStream) const {
+  outStream.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+  writeValue(outStream, CHECKPOINT_VERSION);
+  writeValue(outStream, CHECKPOINT_BYTE_ORDER);
+  const Byte typeSizes[5] = {sizeof(CellIdx), sizeof(Segment), sizeof(Synapse),
+                              sizeof(SynapseIdx), sizeof(Permanence)};
+  outStream.write(reinterpret_cast<const char *>(typeSizes), sizeof(typeSizes));
+
+  writeValue(outStream, connectedThreshold_);
+  writeValue(outStream, static_cast<Byte>(timeseries_));
+  writeValue(outStream, nextSegmentOrdinal_);
+
+  // Cells
+  writeArray(outStream, cells_);
+  writeArray(outStream, segmentArena_);
+  writeRuns(outStream, segmentRuns_);
+
+  // Segments
+  writeArray(outStream, segments_);
+  writeArray(outStream, synapseArena_);
+  writeArray(outStream, presynapticCellArena_);
+  writeArray(outStream, permanenceArena_);
+  writeRuns(outStream, synapseRuns_);
+  writeArray(outStream, segmentOrdinals_);
+  writeArray(outStream, destroyedSegments_);
+
+  // Synapses
+  writeArray(outStream, synapseSegments_);
+  writeArray(outStream, synapseSlots_);
+  writeArray(outStream, presynapticMapIndexes_);
+  writeArray(outStream, destroyedSynapses_);
+
+  // Presynaptic index
+  potentialMap_.save(outStream);
+  connectedMap_.save(outStream);
+
+  // Timeseries
+  writeArray(outStream, previousUpdates_);
+  writeArray(outStream, currentUpdates_);
+
+  NTA_CHECK(outStream.good()) << "Failed to write Connections checkpoint.";
+}
+
+
+void Connections::loadCheckpoint(std::istream &inStream) {
+  char magic[sizeof(CHECKPOINT_MAGIC)];
+  inStream.read(magic, sizeof(magic));
+  NTA_CHECK(inStream.good() && std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0)
+      << "Not a Connections checkpoint.";
+  UInt32 version, byteOrder;
+  readValue(inStream, version);
+  NTA_CHECK(version == CHECKPOINT_VERSION)
+      << "Unsupported Connections checkpoint version " << version;
+  readValue(inStream, byteOrder);
+  NTA_CHECK(byteOrder == CHECKPOINT_BYTE_ORDER)
+      << "Connections checkpoint was saved with a different byte order.";
+  const Byte expectedSizes[5] = {sizeof(CellIdx), sizeof(Segment), sizeof(Synapse),
+                                  sizeof(SynapseIdx), sizeof(Permanence)};
+  Byte typeSizes[5];
+  inStream.read(reinterpret_cast<char *>(typeSizes), sizeof(typeSizes));
+  NTA_CHECK(inStream.good() && std::memcmp(typeSizes, expectedSizes, sizeof(typeSizes)) == 0)
+      << "Connections checkpoint was saved with different type sizes.";
+
+  // Decode into a separate instance, and replace this one only once the
+  // whole checkpoint has been read and every index in it checked.
+  Connections loaded;
+  Byte timeseries;
+  readValue(inStream, loaded.connectedThreshold_);
+  readValue(inStream, timeseries);
+  loaded.timeseries_ = timeseries != 0;
+  readValue(inStream, loaded.nextSegmentOrdinal_);
+
+  // Cells
+  readArray(inStream, loaded.cells_);
+  readArray(inStream, loaded.segmentArena_);
+  readRuns(inStream, loaded.segmentRuns_);
+
+  // Segments
+  readArray(inStream, loaded.segments_);
+  readArray(inStream, loaded.synapseArena_);
+  readArray(inStream, loaded.presynapticCellArena_);
+  readArray(inStream, loaded.permanenceArena_);
+  readRuns(inStream, loaded.synapseRuns_);
+  readArray(inStream, loaded.segmentOrdinals_);
+  readArray(inStream, loaded.destroyedSegments_);
+
+  // Synapses
+  readArray(inStream, loaded.synapseSegments_);
+  readArray(inStream, loaded.synapseSlots_);
+  readArray(inStream, loaded.presynapticMapIndexes_);
+  readArray(inStream, loaded.destroyedSynapses_);
+
+  // Presynaptic index
+  loaded.potentialMap_.load(inStream);
+  loaded.connectedMap_.load(inStream);
+
+  // Timeseries
+  readArray(inStream, loaded.previousUpdates_);
+  readArray(inStream, loaded.currentUpdates_);
+
+  loaded.nextEventToken_ = 0;
+  loaded.checkIndexes_();
+  *this = std::move(loaded);
+}
+
+
+void Connections::checkIndexes_() const {
+  const size_t numSegments = segments_.size();
+  const size_t numSynapses = synapseSegments_.size();
+  const size_t numPresynapticCells = potentialMap_.numCells();
+
+  NTA_CHECK(segmentArena_.size() == segmentRuns_.size() &&
+            synapseArena_.size() == synapseRuns_.size() &&
+            presynapticCellArena_.size() == synapseRuns_.size() &&
+            permanenceArena_.size() == synapseRuns_.size() &&
+            segmentOrdinals_.size() == numSegments &&
+            synapseSlots_.size() == numSynapses &&
+            presynapticMapIndexes_.size() == numSynapses &&
+            connectedMap_.numCells() == numPresynapticCells)
+      << "Connections checkpoint is corrupt.";
+
+  // No two runs of an arena may overlap, or growing one would overwrite
+  // the other.
+  vector<Run> runs;
+  runs.reserve(cells_.size());
+  for (const auto &cellData : cells_) {
+    runs.push_back(cellData.segments);
+  }
+  segmentRuns_.check(runs);
+  runs.clear();
+  runs.reserve(numSegments);
+  for (const auto &segmentData : segments_) {
+    runs.push_back(segmentData.synapses);
+  }
+  synapseRuns_.check(runs);
+
+  // Each segment is on at most one cell, once, and the segments on a cell
+  // are in order of age, which destroySegment and the TM rely on.
+  vector<bool> listed(numSegments, false);
+  for (CellIdx cell = 0; cell < static_cast<CellIdx>(cells_.size()); cell++) {
+    const SegmentList segments = segmentsForCell(cell);
+    for (size_t i = 0; i < segments.size(); i++) {
+      const Segment segment = segments[i];
+      NTA_CHECK(segment < numSegments && segments_[segment].cell == cell &&
+                !listed[segment] &&
+                segmentOrdinals_[segment] < nextSegmentOrdinal_ &&
+                (i == 0u || segmentOrdinals_[segments[i - 1u]] < segmentOrdinals_[segment]))
+          << "Connections checkpoint is corrupt: segment " << segment
+          << " on cell " << cell << ".";
+      listed[segment] = true;
+    }
+  }
+
+  for (Segment segment = 0; segment < static_cast<Segment>(numSegments); segment++) {
+    NTA_CHECK(segments_[segment].cell < cells_.size())
+        << "Connections checkpoint is corrupt: segment " << segment
+        << " is on cell " << segments_[segment].cell << ".";
+    const Run &synapses = segments_[segment].synapses;
+    SynapseIdx numConnected = 0u;
+    for (UInt32 slot = synapses.offset; slot < synapses.offset + synapses.size; slot++) {
+      const Synapse synapse = synapseArena_[slot];
+      NTA_CHECK(synapse < numSynapses && synapseSegments_[synapse] == segment &&
+                synapseSlots_[synapse] == slot)
+          << "Connections checkpoint is corrupt: synapse " << synapse
+          << " on segment " << segment << ".";
+      const SynapseData synapseData = dataForSynapse(synapse);
+      const PresynapticMap &map = synapseData.permanence >= connectedThreshold_
+                                      ? connectedMap_ : potentialMap_;
+      NTA_CHECK(synapseData.presynapticCell < numPresynapticCells &&
+                synapseData.presynapticMapIndex_ < map.size(synapseData.presynapticCell) &&
+                map.synapses(synapseData.presynapticCell)[synapseData.presynapticMapIndex_] == synapse)
+          << "Connections checkpoint is corrupt: synapse " << synapse
+          << " is missing from the presynaptic index.";
+      if (synapseData.permanence >= connectedThreshold_) {
+        numConnected++;
+      }
+    }
+    NTA_CHECK(segments_[segment].numConnected == numConnected)
+        << "Connections checkpoint is corrupt: segment " << segment
+        << " has " << numConnected << " connected synapses, not "
+        << segments_[segment].numConnected << ".";
+  }
+  for (const Segment segment : destroyedSegments_) {
+    NTA_CHECK(segment < numSegments)
+        << "Connections checkpoint is corrupt: destroyed segment " << segment << ".";
+  }
+
+  for (Synapse synapse = 0; synapse < static_cast<Synapse>(numSynapses); synapse++) {
+    NTA_CHECK(synapseSegments_[synapse] < numSegments)
+        << "Connections checkpoint is corrupt: synapse " << synapse << ".";
+  }
+  for (const Synapse synapse : destroyedSynapses_) {
+    NTA_CHECK(synapse < numSynapses)
+        << "Connections checkpoint is corrupt: destroyed synapse " << synapse << ".";
+  }
+
+  // Every entry of the presynaptic maps must point back at itself.
+  for (const bool connected : {false, true}) {
+    const PresynapticMap &map = connected ? connectedMap_ : potentialMap_;
+    for (CellIdx cell = 0; cell < static_cast<CellIdx>(numPresynapticCells); cell++) {
+      const Synapse *synapses = map.synapses(cell);
+      const Segment *segments = map.segments(cell);
+      for (UInt32 i = 0; i < map.size(cell); i++) {
+        const Synapse synapse = synapses[i];
+        NTA_CHECK(synapse < numSynapses &&
+                  synapseSlots_[synapse] - segments_[synapseSegments_[synapse]].synapses.offset <
+                      segments_[synapseSegments_[synapse]].synapses.size &&
+                  synapseArena_[synapseSlots_[synapse]] == synapse &&
+                  presynapticCellArena_[synapseSlots_[synapse]] == cell &&
+                  presynapticMapIndexes_[synapse] == i &&
+                  synapseSegments_[synapse] == segments[i] &&
+                  (permanenceArena_[synapseSlots_[synapse]] >= connectedThreshold_) == connected)
+            << "Connections checkpoint is corrupt: presynaptic index of cell "
+            << cell << ".";
+      }
+    }
+  }
+}
+
+
 bool Connections::operator==(const Connections &other) const {
   if (cells_.size() != other.cells_.size())
     return false;
 
   for (CellIdx i = 0; i < static_cast<CellIdx>(cells_.size()); i++) {
-    const CellData &cellData = cells_[i];
-    const CellData &otherCellData = other.cells_[i];
+    const SegmentList segments = segmentsForCell(i);
+    const SegmentList otherSegments = other.segmentsForCell(i);
 
-    if (cellData.segments.size() != otherCellData.segments.size()) {
+    if (segments.size() != otherSegments.size()) {
       return false;
     }
 
-    for (SegmentIdx j = 0; j < static_cast<SegmentIdx>(cellData.segments.size()); j++) {
-      const Segment segment = cellData.segments[j];
-      const SegmentData &segmentData = segments_[segment];
-      const Segment otherSegment = otherCellData.segments[j];
-      const SegmentData &otherSegmentData = other.segments_[otherSegment];
+    for (SegmentIdx j = 0; j < static_cast<SegmentIdx>(segments.size()); j++) {
+      const Segment segment = segments[j];
+      const SynapseList synapses = synapsesForSegment(segment);
+      const Segment otherSegment = otherSegments[j];
+      const SynapseList otherSynapses = other.synapsesForSegment(otherSegment);
 
-      if (segmentData.synapses.size() != otherSegmentData.synapses.size() ||
-          segmentData.cell != otherSegmentData.cell) {
+      if (synapses.size() != otherSynapses.size() ||
+          segments_[segment].cell != other.segments_[otherSegment].cell) {
         return false;
       }
 
-      for (SynapseIdx k = 0; k < static_cast<SynapseIdx>(segmentData.synapses.size()); k++) {
-        const Synapse synapse = segmentData.synapses[k];
-        const SynapseData &synapseData = synapses_[synapse];
-        const Synapse otherSynapse = otherSegmentData.synapses[k];
-        const SynapseData &otherSynapseData = other.synapses_[otherSynapse];
+      for (SynapseIdx k = 0; k < static_cast<SynapseIdx>(synapses.size()); k++) {
+        const Synapse synapse = synapses[k];
+        const SynapseData synapseData = dataForSynapse(synapse);
+        const Synapse otherSynapse = otherSynapses[k];
+        const SynapseData otherSynapseData = other.dataForSynapse(otherSynapse);
 
         if (synapseData.presynapticCell != otherSynapseData.presynapticCell ||
             synapseData.permanence != otherSynapseData.permanence) {
@@ -36,6 +36,7 @@
 #include <nupic/types/Types.hpp>
 #include <nupic/types/Serializable.hpp>
 #include <nupic/types/Sdr.hpp>
+#include <nupic/utils/RunAllocator.hpp>
 
 namespace nupic {
 namespace algorithms {
@@ -56,7 +57,9 @@ const Permanence maxPermanence = 1.0f;
  * SynapseData class used in Connections.
  *
  * @b Description
- * The SynapseData contains the underlying data for a synapse.
+ * The SynapseData contains the underlying data for a synapse.  Connections
+ * stores synapses as separate arrays, see Connections, so this is a copy
+ * which is assembled by Connections::dataForSynapse.
  *
  * @param presynapticCellIdx
  * Cell that this synapse gets input from.
@@ -78,13 +81,14 @@ struct SynapseData {
  * The SegmentData contains the underlying data for a Segment.
  *
  * @param synapses
- * Synapses on this segment.
+ * Synapses on this segment, as a run of the synapse arena in Connections.
+ * Use Connections::synapsesForSegment to access them.
  *
  * @param cell
  * The cell that this segment is on.
  */
 struct SegmentData {
-  std::vector<Synapse> synapses;
+  util::Run synapses;
   CellIdx cell;
   SynapseIdx numConnected;
 };
@@ -97,11 +101,179 @@ struct SegmentData {
  * The CellData contains the underlying data for a Cell.
  *
  * @param segments
- * Segments on this cell.
- *
+ * Segments on this cell, as a run of the segment arena in Connections.  Use
+ * Connections::segmentsForCell to access them.
  */
 struct CellData {
-  std::vector<Segment> segments;
+  util::Run segments;
+};
+
+/**
+ * PendingSynapseUpdate class used in Connections.
+ *
+ * @b Description
+ * A synapse which crossed the connected threshold while learning with
+ * deferred presynaptic bookkeeping.  See Connections::applyPendingUpdates.
+ *
+ * @param synapse
+ * The synapse which crossed the threshold.
+ *
+ * @param permanence
+ * Permanence of the synapse right after it crossed.
+ */
+struct PendingSynapseUpdate {
+  Synapse synapse;
+  Permanence permanence;
+};
+
+class Connections;
+
+/**
+ * SynapseList class used in Connections.
+ *
+ * @b Description
+ * Read only view of the synapses on a segment, returned by
+ * Connections::synapsesForSegment.  It behaves like a reference to the
+ * segment's list: it always shows the current synapses of the segment,
+ * including after synapses are created on or destroyed from the segment.
+ * Pointers and iterators into it are invalidated by creating or destroying
+ * synapses.
+ */
+class SynapseList {
+public:
+  typedef Synapse value_type;
+  typedef const Synapse *const_iterator;
+  typedef const Synapse *iterator;
+
+  SynapseList(const Connections &connections, Segment segment)
+      : connections_(&connections), segment_(segment) {}
+
+  const Synapse *begin() const;
+  const Synapse *end() const { return begin() + size(); }
+  size_t size() const;
+  bool empty() const { return size() == 0u; }
+  Synapse operator[](size_t index) const { return begin()[index]; }
+  Synapse front() const { return *begin(); }
+  Synapse back() const { return end()[-1]; }
+
+  /** Copy of the current synapses. */
+  operator std::vector<Synapse>() const { return std::vector<Synapse>(begin(), end()); }
+
+private:
+  const Connections *connections_;
+  Segment segment_;
+};
+
+/**
+ * SegmentList class used in Connections.
+ *
+ * @b Description
+ * Read only view of the segments on a cell, returned by
+ * Connections::segmentsForCell.  Like SynapseList, it always shows the
+ * current segments of the cell, and pointers and iterators into it are
+ * invalidated by creating or destroying segments.
+ */
+class SegmentList {
+public:
+  typedef Segment value_type;
+  typedef const Segment *const_iterator;
+  typedef const Segment *iterator;
+
+  SegmentList(const Connections &connections, CellIdx cell)
+      : connections_(&connections), cell_(cell) {}
+
+  const Segment *begin() const;
+  const Segment *end() const { return begin() + size(); }
+  size_t size() const;
+  bool empty() const { return size() == 0u; }
+  Segment operator[](size_t index) const { return begin()[index]; }
+  Segment front() const { return *begin(); }
+  Segment back() const { return end()[-1]; }
+
+  /** Copy of the current segments. */
+  operator std::vector<Segment>() const { return std::vector<Segment>(begin(), end()); }
+
+private:
+  const Connections *connections_;
+  CellIdx cell_;
+};
+
+/**
+ * PresynapticMap class used in Connections.
+ *
+ * @b Description
+ * For each presynaptic cell, the synapses from it and the segments they are
+ * on, as two parallel lists.  The lists are either a std::vector each, or
+ * runs of two shared arenas, see util::RunAllocator.
+ *
+ * Arenas make clearing and loading cheap when there are many cells with a
+ * few synapses each, as in the TemporalMemory.  When the lists all grow at
+ * the same pace, as when the SpatialPooler builds its potential pools, the
+ * runs they leave behind are rarely reused and the arenas take more memory
+ * than the vectors.
+ */
+class PresynapticMap {
+public:
+  /** Remove all lists, and choose how the next ones are stored. */
+  void clear(bool arenas);
+  bool arenas() const { return arenas_; }
+
+  /** Number of presynaptic cells which have a list. */
+  size_t numCells() const {
+    return arenas_ ? runs_.size() : synapseLists_.size();
+  }
+
+  /** Make room for the presynaptic cells [0, numCells). */
+  void reserveCells(size_t numCells);
+
+  UInt32 size(CellIdx cell) const {
+    return arenas_ ? runs_[cell].size : (UInt32)synapseLists_[cell].size();
+  }
+  const Synapse *synapses(CellIdx cell) const {
+    return arenas_ ? synapseArena_.data() + runs_[cell].offset
+                   : synapseLists_[cell].data();
+  }
+  const Segment *segments(CellIdx cell) const {
+    return arenas_ ? segmentArena_.data() + runs_[cell].offset
+                   : segmentLists_[cell].data();
+  }
+
+  /**
+   * Append a synapse to the list of the cell.
+   *
+   * @returns the index of the synapse in the list.
+   */
+  UInt32 add(CellIdx cell, Synapse synapse, Segment segment);
+
+  /**
+   * Remove the synapse at index from the list of the cell, by moving the
+   * last synapse in the list over it.
+   *
+   * @returns the synapse which is now at index.
+   */
+  Synapse remove(CellIdx cell, UInt32 index);
+
+  void save(std::ostream &outStream) const;
+  void load(std::istream &inStream);
+
+private:
+  /**
+   * Compact the arenas once their RunAllocator is fragmented.
+   */
+  void pack_();
+
+  bool arenas_ = false;
+
+  // With arenas, the list of cell c is the elements
+  // [runs_[c].offset, ... + runs_[c].size) of both arenas.
+  std::vector<util::Run> runs_;
+  std::vector<Synapse>   synapseArena_;
+  std::vector<Segment>   segmentArena_;
+  util::RunAllocator     allocator_;
+
+  // Without arenas.
+  std::vector<std::vector<Synapse>> synapseLists_;
+  std::vector<std::vector<Segment>> segmentLists_;
 };
 
 /**
@@ -168,6 +340,22 @@ public:
  * Create a vector of length `connections.segmentFlatListLength()`,
  * iterate over segments and update the vector at index `segment`.
  *
+ * Synapses are stored as a structure of arrays.  The synapses on each
+ * segment are a contiguous run in three pooled arenas, which hold the
+ * synapse handles, presynaptic cells and permanences.  So learning and
+ * the other loops over a segment read and write unit-stride arrays.  A
+ * synapse handle maps to its current position in the arenas, and stays
+ * valid while its run moves.
+ *
+ * The segments on each cell and the synapses on each segment are stored as
+ * runs of pooled arenas, instead of a std::vector per cell and per
+ * segment.  A run moves to a larger run when it is full, and released runs
+ * are kept in free lists per size class and reused, see util::RunAllocator.
+ * The presynaptic index can be stored the same way, see the
+ * presynapticArenas option.  So Connections makes a few large allocations
+ * instead of several per cell and segment, and initialize or loading frees
+ * them in constant time.
+ *
  */
 class Connections : public Serializable
  {
@@ -194,9 +382,19 @@ public:
    * This change allows it to work with timeseries data which moves very slowly,
    * instead of the usual HTM inputs which reliably change every cycle.  See
    * also (Kropff & Treves, 2007. http://dx.doi.org/10.2976/1.2793335).
+   *
+   * @params presynapticArenas - Optional, default false.  If true the
+   * presynaptic index is stored in arenas instead of a std::vector per
+   * presynaptic cell, see PresynapticMap.  This pays off with many cells and
+   * a few synapses per presynaptic cell, as in the TemporalMemory.
    */
   Connections(CellIdx numCells, Permanence connectedThreshold = 0.5f,
-              bool timeseries = false);
+              bool timeseries = false, bool presynapticArenas = false);
+
+  Connections(const Connections &) = default;
+  Connections(Connections &&) = default;
+  Connections &operator=(const Connections &) = default;
+  Connections &operator=(Connections &&) = default;
 
   virtual ~Connections() {}
 
@@ -207,9 +405,10 @@ public:
    * @param connectedThreshold Permanence threshold for synapses connecting or
    *                           disconnecting.
    * @param timeseries         See constructor.
+   * @param presynapticArenas  See constructor.
    */
   void initialize(CellIdx numCells, Permanence connectedThreshold = 0.5f,
-                  bool timeseries = false);
+                  bool timeseries = false, bool presynapticArenas = false);
 
   /**
    * Creates a segment on the specified cell.
@@ -233,6 +432,30 @@ public:
                         CellIdx presynapticCell,
                         Permanence permanence);
 
+  /**
+   * Creates many synapses on the specified segment.  This is the same as
+   * calling createSynapse for each presynaptic cell in order, except that the
+   * segment's synapse list grows only once and each synapse goes straight
+   * into the presynaptic map which matches its permanence.
+   *
+   * @param segment          Segment to create synapses on.
+   * @param presynapticCells Cells to synapse on.
+   * @param permanences      Initial permanences, one per presynaptic cell.
+   */
+  void createSynapses(Segment segment,
+                      const std::vector<CellIdx> &presynapticCells,
+                      const std::vector<Permanence> &permanences);
+
+  /**
+   * Creates a segment on the specified cell, together with its synapses.
+   * See createSynapses.
+   *
+   * @retval Created segment.
+   */
+  Segment createSegment(CellIdx cell,
+                        const std::vector<CellIdx> &presynapticCells,
+                        const std::vector<Permanence> &permanences);
+
   /**
    * Destroys segment.
    *
@@ -260,18 +483,18 @@ public:
    *
    * @param cell Cell to get segments for.
    *
-   * @retval Segments on cell.
+   * @retval Segments on cell, see SegmentList.
    */
-  const std::vector<Segment> &segmentsForCell(CellIdx cell) const;
+  SegmentList segmentsForCell(CellIdx cell) const;
 
   /**
    * Gets the synapses for a segment.
    *
    * @param segment Segment to get synapses for.
    *
-   * @retval Synapses on segment.
+   * @retval Synapses on segment, see SynapseList.
    */
-  const std::vector<Synapse> &synapsesForSegment(Segment segment) const;
+  SynapseList synapsesForSegment(Segment segment) const;
 
   /**
    * Gets the cell that this segment is on.
@@ -327,9 +550,9 @@ public:
    *
    * @param synapse Synapse to get data for.
    *
-   * @retval Synapse data.
+   * @retval Copy of the synapse data.
    */
-  const SynapseData &dataForSynapse(Synapse synapse) const;
+  SynapseData dataForSynapse(Synapse synapse) const;
 
   /**
    * Get the segment at the specified cell and offset.
@@ -399,6 +622,27 @@ public:
   void computeActivity(std::vector<SynapseIdx> &numActiveConnectedSynapsesForSegment,
                        const std::vector<CellIdx> &activePresynapticCells);
 
+  /**
+   * Compute the segment excitations for a vector of active presynaptic
+   * cells, visiting only the segments with an active synapse.
+   *
+   * Instead of clearing the output vectors, this resets the counters of the
+   * segments in touchedSegments, which must hold the segments touched by
+   * the previous call (or be empty when the vectors are all zeros).  It
+   * then fills touchedSegments with the segments that have at least one
+   * active potential synapse, in no particular order.  All other counters
+   * are left at zero, so callers can threshold touchedSegments instead of
+   * scanning every segment.
+   *
+   * The output vectors must have the length returned by
+   * segmentFlatListLength().  They may be resized between calls, as long as
+   * new elements are zero.
+   */
+  void computeActivity(std::vector<SynapseIdx> &numActiveConnectedSynapsesForSegment,
+                       std::vector<SynapseIdx> &numActivePotentialSynapsesForSegment,
+                       std::vector<Segment> &touchedSegments,
+                       const std::vector<CellIdx> &activePresynapticCells);
+
   /**
    * The primary method in charge of learning.   Adapts the permanence values of
    * the synapses based on the input SDR.  Learning is applied to a single
@@ -411,11 +655,13 @@ public:
    * @param inputVector  An SDR
    * @param increment  Change in permanence for synapses with active presynapses.
    * @param decrement  Change in permanence for synapses with inactive presynapses.
+   * @param pending  Optional, see applyPendingUpdates.
    */
   void adaptSegment(const Segment segment,
                     const sdr::SDR &inputs,
                     const Permanence increment,
-                    const Permanence decrement);
+                    const Permanence decrement,
+                    std::vector<PendingSynapseUpdate> *pending = nullptr);
 
   /**
    * Ensures a minimum number of connected synapses.  This raises permance
@@ -424,17 +670,41 @@ public:
    *
    * @param segment  Index of segment on cell.   Is returned by method getSegment.
    * @param segmentThreshold  Desired number of connected synapses.
+   * @param pending  Optional, see applyPendingUpdates.
    */
   void raisePermanencesToThreshold(const Segment    segment,
-                                   const UInt       segmentThreshold);
+                                   const UInt       segmentThreshold,
+                                   std::vector<PendingSynapseUpdate> *pending = nullptr);
 
   /**
    * Modify all permanence on the given segment, uniformly.
    *
    * @param segment  Index of segment on cell. Is returned by method getSegment.
    * @param delta  Change in permanence value
+   * @param pending  Optional, see applyPendingUpdates.
    */
-  void bumpSegment(const Segment segment, const Permanence delta);
+  void bumpSegment(const Segment segment, const Permanence delta,
+                   std::vector<PendingSynapseUpdate> *pending = nullptr);
+
+  /**
+   * Finishes learning which was done with deferred presynaptic bookkeeping.
+   *
+   * The learning methods above accept an optional "pending" vector.  When it
+   * is given, permanences and the segment's connected count are updated as
+   * usual, but synapses which cross the connected threshold are appended to
+   * "pending" instead of being moved between the presynaptic indexes.  Those
+   * indexes are shared by all segments, while everything else these methods
+   * touch belongs to the one segment.  So different segments can learn
+   * concurrently, each thread with its own pending vector.
+   *
+   * This method then moves the recorded synapses, in order, and notifies the
+   * event handlers.  Applying the vectors in the same order as the segments
+   * would have been adapted serially leaves the Connections in exactly the
+   * same state as the serial updates.  Not supported with timeseries.
+   *
+   * @param pending  Synapse updates recorded by the learning methods.
+   */
+  void applyPendingUpdates(const std::vector<PendingSynapseUpdate> &pending);
 
   // Serialization
 
@@ -449,22 +719,43 @@ public:
    */
   virtual void load(std::istream &inStream) override;
 
+  /**
+   * Checkpoints.
+   *
+   * A checkpoint is a versioned, flat binary image of the Connections: the
+   * cells, segments and synapses as packed arrays, plus the presynaptic
+   * index, the free lists, ordinals and timeseries state.  Every array is
+   * written with one call and read back with one bulk read, so loading does
+   * not rebuild anything synapse by synapse and does not notify the event
+   * handlers.  The loaded Connections is identical to the saved one,
+   * including the indexes of destroyed segments and synapses which are
+   * waiting to be reused.
+   *
+   * Checkpoints use the native byte order and type sizes, and loading checks
+   * that they match.  Open file streams in binary mode.
+   *
+   * Like initialize, loadCheckpoint removes all event handlers.  Every index
+   * in the checkpoint is checked before the Connections is replaced, so a
+   * truncated or corrupt checkpoint throws and leaves it unchanged.
+   */
+  static const UInt32 CHECKPOINT_VERSION = 1u;
+  void saveCheckpoint(std::ostream &outStream) const;
+  void loadCheckpoint(std::istream &inStream);
+
   CerealAdapter;
   template<class Archive>
   void save_ar(Archive & ar) const {
     ar( CEREAL_NVP(connectedThreshold_), cereal::make_size_tag(cells_.size()));
-    for (CellData cellData : cells_) {
-      const std::vector<Segment> &segments = cellData.segments;
+    for (CellIdx cell = 0; cell < static_cast<CellIdx>(cells_.size()); cell++) {
+      const SegmentList segments = segmentsForCell(cell);
       ar(cereal::make_size_tag(segments.size()));
 
       for (Segment segment : segments) {
-        const SegmentData &segmentData = segments_[segment];
-
-        const std::vector<Synapse> &synapses = segmentData.synapses;
+        const SynapseList synapses = synapsesForSegment(segment);
         ar(cereal::make_size_tag(synapses.size()));
 
         for (Synapse synapse : synapses) {
-          const SynapseData &synapseData = synapses_[synapse];
+          const SynapseData synapseData = dataForSynapse(synapse);
           ar(CEREAL_NVP(synapseData.presynapticCell), 
              CEREAL_NVP(synapseData.permanence));
         }
@@ -477,7 +768,8 @@ public:
     cereal::size_type numCells;
     ar(connectedThreshold, cereal::make_size_tag(numCells));
     CellIdx idx = static_cast<CellIdx>(numCells);
-    initialize(idx, connectedThreshold);
+    // Keep the presynaptic index storage which the owner chose.
+    initialize(idx, connectedThreshold, false, potentialMap_.arenas());
 
     for (UInt cell = 0; cell < numCells; cell++) {
 
@@ -524,7 +816,7 @@ public:
    *
    * @retval Number of segments.
    */
-  size_t numSegments(CellIdx cell) const { return cells_[cell].segments.size(); }
+  size_t numSegments(CellIdx cell) const { return cells_[cell].segments.size; }
 
   /**
    * Gets the number of synapses.
@@ -532,8 +824,8 @@ public:
    * @retval Number of synapses.
    */
   size_t numSynapses() const {
-    NTA_ASSERT(synapses_.size() >= destroyedSynapses_.size());
-    return synapses_.size() - destroyedSynapses_.size();
+    NTA_ASSERT(synapseSegments_.size() >= destroyedSynapses_.size());
+    return synapseSegments_.size() - destroyedSynapses_.size();
   }
 
   /**
@@ -541,7 +833,7 @@ public:
    *
    * @retval Number of synapses.
    */
-  size_t numSynapses(Segment segment) const { return segments_[segment].synapses.size(); }
+  size_t numSynapses(Segment segment) const { return segments_[segment].synapses.size; }
 
   /**
    * Comparison operator.
@@ -592,43 +884,121 @@ protected:
    */
   bool synapseExists_(Synapse synapse) const;
 
+  /**
+   * Add a synapse to the potential or connected presynaptic map of its
+   * presynaptic cell.
+   */
+  void addSynapseToPresynapticMap_(Synapse synapse, CellIdx presynapticCell,
+                                   bool connected);
+
   /**
    * Remove a synapse from presynaptic maps.
    *
-   * @param Synapse Index of synapse in presynaptic vector.
-   *
-   * @param vector<Synapse> synapsesForPresynapticCell must a vector from be
-   * either potentialSynapsesForPresynapticCell_ or
-   * connectedSynapsesForPresynapticCell_, depending on whether the synapse is
-   * connected or not.
+   * @param synapse Synapse to remove.
    *
-   * @param vector<Synapse> segmentsForPresynapticCell must be a vector from
-   * either potentialSegmentsForPresynapticCell_ or
-   * connectedSegmentsForPresynapticCell_, depending on whether the synapse is
-   * connected or not.
+   * @param connected Whether the synapse is in the connected or in the
+   * potential presynaptic map.
    */
-  void removeSynapseFromPresynapticMap_(const Synapse index,
-                              std::vector<Synapse> &synapsesForPresynapticCell,
-                              std::vector<Segment> &segmentsForPresynapticCell);
+  void removeSynapseFromPresynapticMap_(Synapse synapse, bool connected);
+
+  /**
+   * Implements updateSynapsePermanence, optionally deferring the presynaptic
+   * bookkeeping, see applyPendingUpdates.
+   */
+  void updateSynapsePermanence_(Synapse synapse, Permanence permanence,
+                                std::vector<PendingSynapseUpdate> *pending);
+
+  /**
+   * Learning updates a segment in two passes.  First the permanences of its
+   * synapses are copied from the arena into a scratch array and updated with
+   * a vectorized kernel.  Then storePermanences_ writes them back, and does
+   * the connected bookkeeping only for the synapses which crossed the
+   * connected threshold.  The scratch arrays are per thread since different
+   * segments may learn concurrently, see applyPendingUpdates.
+   */
+  void storePermanences_(Segment segment,
+                         const std::vector<Permanence> &permanences,
+                         std::vector<PendingSynapseUpdate> *pending);
+  static std::vector<Permanence> &permanenceScratch_();
+  static std::vector<Permanence> &deltaScratch_();
+
+  /**
+   * Moves a synapse which crossed the connected threshold between the
+   * potential and connected presynaptic maps, and notifies event handlers.
+   */
+  void updatePresynapticMaps_(Synapse synapse, Permanence permanence);
 
 private:
+  friend class SynapseList;
+  friend class SegmentList;
+
+  /**
+   * Index for a new synapse, reusing a destroyed one if there is one.
+   */
+  Synapse newSynapse_();
+
+  /**
+   * Makes room for capacity synapses in the run of the segment.
+   */
+  void reserveSynapses_(Segment segment, UInt32 capacity);
+
+  /**
+   * Append a synapse to the run of its segment.
+   */
+  void appendSynapse_(Segment segment, Synapse synapse,
+                      CellIdx presynapticCell, Permanence permanence);
+
+  /**
+   * Points the synapses in a run of the synapse arenas back at it, after
+   * the run moved.
+   */
+  void setSynapseSlots_(const util::Run &run);
+
+  /**
+   * Compact the segment and synapse arenas once their RunAllocator is
+   * fragmented, see util::RunAllocator.
+   */
+  void packSegmentArena_();
+  void packSynapseArenas_();
+
+  /**
+   * Checks that every index in a loaded checkpoint is in range, and that
+   * the segment and presynaptic indexes agree with the segments and
+   * synapses.  Throws if not.
+   */
+  void checkIndexes_() const;
+
   std::vector<CellData>    cells_;
+  // Segment arena: the segments on cell c are the elements
+  // [cells_[c].segments.offset, ... + cells_[c].segments.size), by age.
+  std::vector<Segment>     segmentArena_;
+  util::RunAllocator       segmentRuns_;
   std::vector<SegmentData> segments_;
   std::vector<Segment>     destroyedSegments_;
-  std::vector<SynapseData> synapses_;
-  std::vector<Synapse>     destroyedSynapses_;
   Permanence               connectedThreshold_; //TODO make const
 
+  // Synapse arenas: the synapses on segment s are the elements
+  // [segments_[s].synapses.offset, ... + segments_[s].synapses.size), by age.
+  std::vector<Synapse>     synapseArena_;
+  std::vector<CellIdx>     presynapticCellArena_;
+  std::vector<Permanence>  permanenceArena_;
+  util::RunAllocator       synapseRuns_;
+
+  // Indexed by synapse.
+  std::vector<Segment>     synapseSegments_;
+  std::vector<UInt32>      synapseSlots_; // Position in the synapse arenas.
+  std::vector<Synapse>     presynapticMapIndexes_;
+  std::vector<Synapse>     destroyedSynapses_;
+
   // Extra bookkeeping for faster computing of segment activity.
-  std::map<CellIdx, std::vector<Synapse>> potentialSynapsesForPresynapticCell_;
-  std::map<CellIdx, std::vector<Synapse>> connectedSynapsesForPresynapticCell_;
-  std::map<CellIdx, std::vector<Segment>> potentialSegmentsForPresynapticCell_;
-  std::map<CellIdx, std::vector<Segment>> connectedSegmentsForPresynapticCell_;
+  // These are indexed directly by the presynaptic cell. The presynaptic cells
+  // live in the input space, which may be larger than numCells(), so the
+  // maps grow on demand in createSynapse.
+  PresynapticMap potentialMap_;
+  PresynapticMap connectedMap_;
 
   std::vector<Segment> segmentOrdinals_;
-  std::vector<Synapse> synapseOrdinals_;
   Segment nextSegmentOrdinal_;
-  Synapse nextSynapseOrdinal_;
 
   // These three members should be used when working with highly correlated
   // data. The vectors store the permanence changes made by adaptSegment.
@@ -640,6 +1010,22 @@ private:
   std::map<UInt32, ConnectionsEventHandler *> eventHandlers_;
 }; // end class Connections
 
+inline const Synapse *SynapseList::begin() const {
+  return connections_->synapseArena_.data() + connections_->segments_[segment_].synapses.offset;
+}
+
+inline size_t SynapseList::size() const {
+  return connections_->segments_[segment_].synapses.size;
+}
+
+inline const Segment *SegmentList::begin() const {
+  return connections_->segmentArena_.data() + connections_->cells_[cell_].segments.offset;
+}
+
+inline size_t SegmentList::size() const {
+  return connections_->cells_[cell_].segments.size;
+}
+
 } // end namespace connections
 } // end namespace algorithms
 } // end namespace nupic
@@ -47,12 +47,42 @@ UInt SDRClassifier::getClassification( const PDF & data ) const
   { return static_cast<UInt>(max_element( data.begin(), data.end() ) - data.begin()); }
 
 
-Real64 SDRClassifier::get_(const Matrix& m, const UInt row, const UInt col, const Real64 defaultVal) const {
-  try {
-    return m.at(row).at(col);
-  } catch(std::exception& ex ) {
-    UNUSED(ex);
-    return defaultVal;
+void SDRClassifier::Matrix::resize(const UInt rows, const UInt cols) {
+  if (cols > stride_) {
+    // Re-layout with spare columns, so that new buckets don't move the data
+    // every time.
+    const UInt stride = max(cols, 2u * stride_);
+    vector<Real64> data((size_t)max(rows, rows_) * stride, 0.0);
+    for (UInt r = 0; r < rows_; r++) {
+      copy_n(data_.begin() + (size_t)r * stride_, cols_, data.begin() + (size_t)r * stride);
+    }
+    data_.swap(data);
+    stride_ = stride;
+  } else if (rows > rows_) {
+    data_.resize((size_t)rows * stride_, 0.0);
+  }
+  rows_ = max(rows, rows_);
+  cols_ = max(cols, cols_);
+}
+
+
+void SDRClassifier::growWeights_() {
+  for (auto &w : weightMatrix_) {
+    w.second.resize(maxInputIdx_ + 1u, maxBucketIdx_ + 1u);
+  }
+}
+
+
+void SDRClassifier::accumulate_(const Matrix &w, const vector<UInt> &patternNZ,
+                                vector<Real64> &likelihoods) const {
+  NTA_ASSERT(likelihoods.size() <= w.cols());
+  const size_t numBuckets = likelihoods.size();
+  Real64 *const out = likelihoods.data();
+  for (const auto &bit : patternNZ) {
+    const Real64 *const row = w.row(bit);
+    for (size_t i = 0; i < numBuckets; i++) {
+      out[i] += row[i];
+    }
   }
 }
 
@@ -89,6 +119,7 @@ void SDRClassifier::initialize(const vector<UInt> &steps, Real64 alpha,
 	  Matrix m;
     weightMatrix_.emplace(step, m);
   }
+  growWeights_();
 }
 
 SDRClassifier::SDRClassifier(const vector<UInt> &steps, Real64 alpha, Real64 actValueAlpha,
@@ -124,6 +155,7 @@ void SDRClassifier::compute(UInt recordNum, const vector<UInt> &patternNZ,
     const UInt maxInputIdx = *max_element(patternNZ.begin(), patternNZ.end());
     if (maxInputIdx > maxInputIdx_) {
       maxInputIdx_ = maxInputIdx;
+      growWeights_();
     }
   }
 
@@ -141,6 +173,7 @@ void SDRClassifier::compute(UInt recordNum, const vector<UInt> &patternNZ,
       // matrix with zero-padding
       if (bucketIdx > maxBucketIdx_) {
         maxBucketIdx_ = bucketIdx;
+        growWeights_();
       }
 
       // update rolling averages of bucket values
@@ -171,11 +204,12 @@ void SDRClassifier::compute(UInt recordNum, const vector<UInt> &patternNZ,
         const vector<Real64> error = calculateError_(bucketIdxList, learnPatternNZ, nSteps);
         Matrix& w = weightMatrix_.at(nSteps);
 	      NTA_ASSERT(alpha_ > 0.0);
+        NTA_ASSERT(error.size() <= w.cols());
+        const size_t numBuckets = error.size();
         for (const auto& bit : learnPatternNZ) {
-          for(UInt i = 0; i < error.size(); i++) {
-            const auto val = get_(w, bit, i) + alpha_ * error[i];
-	          if(val == 0) continue;
-	            w[bit][i] = val;
+          Real64 *const row = w.row(bit);
+          for(size_t i = 0; i < numBuckets; i++) {
+            row[i] += alpha_ * error[i];
           }
         }
       }
@@ -213,13 +247,7 @@ void SDRClassifier::infer_(const vector<UInt> &patternNZ,
   {
     vector<Real64> &likelihoods = result[ *nSteps ];
     likelihoods.assign( maxBucketIdx_ + 1, 0.0f );
-
-    for( const auto& bit : patternNZ ) {
-      const Matrix& w = weightMatrix_.at(*nSteps);
-      for( UInt i = 0; i < static_cast<UInt>(likelihoods.size()); i++ ) {
-        likelihoods.at(i) += get_(w, bit, i);
-      }
-    }
+    accumulate_( weightMatrix_.at(*nSteps), patternNZ, likelihoods );
     softmax_( likelihoods.begin(), likelihoods.end() );
   }
 }
@@ -229,13 +257,7 @@ vector<Real64> SDRClassifier::calculateError_(const vector<UInt> &bucketIdxList,
                                               UInt step) {
   // compute predicted likelihoods
   vector<Real64> likelihoods(maxBucketIdx_ + 1, 0);
-
-  for (const auto& bit : patternNZ) {
-    const Matrix& w = weightMatrix_.at(step); //row
-    for(UInt i=0; i< (UInt)likelihoods.size(); i++) {
-      likelihoods[i] += get_(w, bit, i);
-    }
-  }
+  accumulate_(weightMatrix_.at(step), patternNZ, likelihoods);
   softmax_(likelihoods.begin(), likelihoods.end());
 
   // compute target likelihoods
@@ -311,11 +333,10 @@ void SDRClassifier::save(ostream &outStream) const {
   outStream << weightMatrix_.size() << " ";
   for (const auto &elem : weightMatrix_) { // elem = Matrix
     outStream << elem.first << " ";
-    const auto map2d =  elem.second; //2d map: map<int<map<int, double>>
+    const Matrix &w = elem.second;
     for(UInt i=0; i < maxInputIdx_; i++) {
       for(UInt j=0; j< maxBucketIdx_; j++) {
-	const Real64 val = get_(map2d, i, j); //store dense map because indices i,j have to match in load()
-        outStream << val << " "; //map2d[i][j]
+        outStream << w.get(i, j) << " "; //indices i,j have to match in load()
       }
     }
   }
@@ -392,12 +413,11 @@ void SDRClassifier::load(istream &inStream) {
     inStream >> step;
     // Insert the step to initialize the weight matrix
     auto m = Matrix();
+    m.resize(maxInputIdx_ + 1u, maxBucketIdx_ + 1u);
     for (UInt i = 0; i < maxInputIdx_; i++) {
+      Real64 *const row = m.row(i);
       for (UInt j = 0; j < maxBucketIdx_; j++) {
-	Real64 val;
-        inStream >> val;
-	if(val == 0.0) continue; //load sparse map only
-	m[i][j] = val;
+        inStream >> row[j];
       }
     }
     weightMatrix_[step] = m;
@@ -478,11 +498,11 @@ bool SDRClassifier::operator==(const SDRClassifier &other) const {
     return false;
   }
   for (auto it = weightMatrix_.begin(); it != weightMatrix_.end(); it++) {
-    const Matrix thisWeights = it->second;
-    const Matrix otherWeights = other.weightMatrix_.at(it->first);
+    const Matrix &thisWeights = it->second;
+    const Matrix &otherWeights = other.weightMatrix_.at(it->first);
     for (UInt i = 0; i <= maxInputIdx_; ++i) {
       for (UInt j = 0; j <= maxBucketIdx_; ++j) {
-        if (get_(thisWeights, i, j) != get_(otherWeights, i, j)) {
+        if (thisWeights.get(i, j) != otherWeights.get(i, j)) {
           return false;
         }
       }
@@ -36,6 +36,7 @@
 
 #include <nupic/types/Types.hpp>
 #include <nupic/types/Serializable.hpp>
+#include <nupic/utils/Log.hpp>
 
 namespace nupic {
 namespace algorithms {
@@ -65,11 +66,37 @@ class SDRClassifier : public Serializable
   friend class SDRClassifierTest;
 
   /**
-   * 2d map used to store the data.
-   * write with Matrix m; m[i][j] = 1.0; //map will always allocate for new i,j index
-   * access/read with get_(&m, i, j): as it handles missing values i,j and returns 0.0 for them
+   * Dense 2d matrix used to store the weights, one row per input bit and one
+   * column per bucket.  Rows are contiguous, so inference and learning are
+   * plain loops over the rows of the active bits.
+   * The matrix grows on demand; new elements are 0.0.  Spare columns are
+   * reserved when it grows, so that adding buckets is amortized constant.
    */
-  using Matrix = std::map<UInt, std::map<UInt, Real64>>; //Matrix[r][c] = 0.0d
+  class Matrix {
+  public:
+    /**
+     * Grow (never shrink) the matrix to at least rows x cols.
+     */
+    void resize(UInt rows, UInt cols);
+
+    UInt rows() const { return rows_; }
+    UInt cols() const { return cols_; }
+
+    Real64       *row(UInt r)       { NTA_ASSERT(r < rows_); return &data_[(size_t)r * stride_]; }
+    const Real64 *row(UInt r) const { NTA_ASSERT(r < rows_); return &data_[(size_t)r * stride_]; }
+
+    /**
+     * @return value stored at [row][col], or 0.0 if outside of the matrix
+     */
+    Real64 get(UInt r, UInt c) const
+      { return (r < rows_ && c < cols_) ? data_[(size_t)r * stride_ + c] : 0.0; }
+
+  private:
+    UInt rows_   = 0u;
+    UInt cols_   = 0u;
+    UInt stride_ = 0u; // allocated columns per row, >= cols_
+    std::vector<Real64> data_;
+  };
 
 
 public:
@@ -171,11 +198,13 @@ private:
   // softmax function
   void softmax_(std::vector<Real64>::iterator begin, std::vector<Real64>::iterator end);
 
-  /**
-   * get(x,y) accessor interface for Matrix; handles sparse (missing) values
-   * @return return value stored at map[row][col], or defaultVal if such field does not exist
-   **/
-  Real64 get_(const Matrix& m, const UInt row, const UInt col, const Real64 defaultVal=0.0) const;
+  // Sums the weight rows of the active bits into likelihoods (which are not
+  // cleared), one element per bucket.
+  void accumulate_(const Matrix &w, const std::vector<UInt> &patternNZ,
+                   std::vector<Real64> &likelihoods) const;
+
+  // Grow all weight matrices to [maxInputIdx_+1][maxBucketIdx_+1].
+  void growWeights_();
 
   // The list of prediction steps to learn and infer.
   std::vector<UInt> steps_;
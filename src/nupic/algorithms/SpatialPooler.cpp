@@ -28,18 +28,20 @@
 #include <algorithm>
 #include <iterator> //begin()
 #include <cmath> //fmod
+#include <cstring> //memcpy
+#include <type_traits>
 
 #include <nupic/algorithms/SpatialPooler.hpp>
 #include <nupic/math/Topology.hpp>
 #include <nupic/math/Math.hpp> // nupic::Epsilon
-#include <nupic/utils/VectorHelpers.hpp>
+#include <nupic/utils/Trace.hpp>
 
 using namespace std;
 using namespace nupic;
 using namespace nupic::algorithms::spatial_pooler;
 using namespace nupic::math::topology;
+using nupic::util::TraceScope;
 using nupic::sdr::SDR;
-using nupic::utils::VectorHelpers;
 
 class CoordinateConverterND {
 
@@ -210,6 +212,35 @@ void SpatialPooler::setWrapAround(bool wrapAround) { wrapAround_ = wrapAround; }
 
 UInt SpatialPooler::getUpdatePeriod() const { return updatePeriod_; }
 
+UInt SpatialPooler::getNumThreads() const { return numThreads_; }
+
+void SpatialPooler::setNumThreads(UInt numThreads) {
+  NTA_CHECK(numThreads > 0u) << "numThreads must be at least 1.";
+  if (numThreads == numThreads_) return;
+  numThreads_ = numThreads;
+  if (numThreads_ > 1u) {
+    pool_ = make_shared<util::ThreadPool>(numThreads_);
+  } else {
+    pool_.reset();
+  }
+  resizeThreadScratch_();
+}
+
+void SpatialPooler::resizeThreadScratch_() {
+  const UInt numWorkers = pool_ == nullptr ? 0u : numThreads_;
+  threadOverlaps_.assign(numWorkers, vector<SynapseIdx>(numColumns_, 0));
+  threadSlices_.resize(numWorkers);
+}
+
+void SpatialPooler::parallelFor_(size_t n,
+                                 const util::ThreadPool::RangeFunction &fn) const {
+  if (pool_ == nullptr) {
+    if (n > 0u) fn(0u, n, 0u);
+  } else {
+    pool_->parallelFor(n, fn);
+  }
+}
+
 void SpatialPooler::setUpdatePeriod(UInt updatePeriod) {
   updatePeriod_ = updatePeriod;
 }
@@ -310,12 +341,13 @@ void SpatialPooler::setPotential(UInt column, const UInt potential[]) {
     connections_.destroySynapse( synapses[0] );
 
   // Replace with new synapse.
-  vector<UInt> potentialDenseVec( potential, potential + numInputs_ );
-  const auto &perm = initPermanence_( potentialDenseVec, initConnectedPct_ );
+  vector<UInt> potentialSparse;
   for(UInt i = 0; i < numInputs_; i++) {
     if( potential[i] )
-      connections_.createSynapse( column, i, perm[i] );
+      potentialSparse.push_back( i );
   }
+  const auto &perm = initPermanence_( potentialSparse, initConnectedPct_ );
+  connections_.createSynapses( column, potentialSparse, perm );
 }
 
 void SpatialPooler::getPermanence(UInt column, Real permanences[]) const {
@@ -451,20 +483,15 @@ void SpatialPooler::initialize(
   overlaps_.resize(numColumns_);
   overlapsPct_.resize(numColumns_);
   boostedOverlaps_.resize(numColumns_);
+  resizeThreadScratch_();
 
   inhibitionRadius_ = 0;
 
   connections_.initialize(numColumns_, synPermConnected_);
   for (Size i = 0; i < numColumns_; ++i) {
-    connections_.createSegment( (connections::CellIdx)i );
-
-    // Note: initMapPotential_ & initPermanence_ return dense arrays.
-    vector<UInt> potential = initMapPotential_((UInt)i, wrapAround_);
-    vector<Real> perm = initPermanence_(potential, initConnectedPct_);
-    for(UInt presyn = 0; presyn < numInputs_; presyn++) {
-      if( potential[presyn] )
-        connections_.createSynapse( (connections::Segment)i, presyn, perm[presyn] );
-    }
+    const vector<UInt> potential = initMapPotential_((UInt)i, wrapAround_);
+    const vector<Real> perm = initPermanence_(potential, initConnectedPct_);
+    connections_.createSegment( (connections::CellIdx)i, potential, perm );
 
     connections_.raisePermanencesToThreshold( (connections::Segment)i, stimulusThreshold_ );
   }
@@ -495,19 +522,26 @@ void SpatialPooler::compute(const SDR &input, bool learn, SDR &active) {
   NTA_CHECK( input.dimensions  == inputDimensions_ );
   NTA_CHECK( active.dimensions == columnDimensions_ );
   updateBookeepingVars_(learn);
-  calculateOverlap_(input, overlaps_);
-  calculateOverlapPct_(overlaps_, overlapsPct_);
+  {
+    TraceScope trace("spatial_pooler", "overlap");
+    calculateOverlap_(input, overlaps_);
+    calculateOverlapPct_(overlaps_, overlapsPct_);
 
-  boostOverlaps_(overlaps_, boostedOverlaps_);
+    boostOverlaps_(overlaps_, boostedOverlaps_);
+  }
 
-  auto &activeVector = active.getSparse();
-  inhibitColumns_(boostedOverlaps_, activeVector);
-  // Notify the active SDR that its internal data vector has changed.  Always
-  // call SDR's setter methods even if when modifying the SDR's own data
-  // inplace.
-  active.setSparse( activeVector );
+  {
+    TraceScope trace("spatial_pooler", "inhibit");
+    auto &activeVector = active.getSparse();
+    inhibitColumns_(boostedOverlaps_, activeVector);
+    // Notify the active SDR that its internal data vector has changed.  Always
+    // call SDR's setter methods even if when modifying the SDR's own data
+    // inplace.
+    active.setSparse( activeVector );
+  }
 
   if (learn) {
+    TraceScope trace("spatial_pooler", "learn");
     adaptSynapses_(input, active);
     updateDutyCycles_(overlaps_, active);
     bumpUpWeakColumns_();
@@ -522,9 +556,11 @@ void SpatialPooler::compute(const SDR &input, bool learn, SDR &active) {
 
 void SpatialPooler::boostOverlaps_(const vector<SynapseIdx> &overlaps, //TODO use Eigen sparse vector here
                                    vector<Real> &boosted) const {
-  for (UInt i = 0; i < numColumns_; i++) {
-    boosted[i] = overlaps[i] * boostFactors_[i];
-  }
+  parallelFor_(numColumns_, [&](size_t begin, size_t end, UInt) {
+    for (size_t i = begin; i < end; i++) {
+      boosted[i] = overlaps[i] * boostFactors_[i];
+    }
+  });
 }
 
 
@@ -551,21 +587,16 @@ vector<UInt> SpatialPooler::initMapPotential_(UInt column, bool wrapAround) {
   NTA_ASSERT(column < numColumns_);
   const UInt centerInput = initMapColumn_(column);
 
+  inputNeighborhoods_.update(potentialRadius_, inputDimensions_, wrapAround);
   vector<UInt> columnInputs;
-  if (wrapAround) {
-    for (UInt input : WrappingNeighborhood(centerInput, potentialRadius_, inputDimensions_)) {
-      columnInputs.push_back(input);
-    }
-  } else {
-    for (UInt input :
-         Neighborhood(centerInput, potentialRadius_, inputDimensions_)) {
-      columnInputs.push_back(input);
-    }
-  }
+  columnInputs.reserve(inputNeighborhoods_.size(centerInput));
+  inputNeighborhoods_.forEach(centerInput, [&](UInt input) {
+    columnInputs.push_back(input);
+  });
 
   const UInt numPotential = (UInt)round(columnInputs.size() * potentialPct_);
-  const auto selectedInputs = rng_.sample<UInt>(columnInputs, numPotential);
-  const vector<UInt> potential = VectorHelpers::sparseToBinary<UInt>(selectedInputs, numInputs_);
+  auto potential = rng_.sample<UInt>(columnInputs, numPotential);
+  std::sort(potential.begin(), potential.end());
   return potential;
 }
 
@@ -580,14 +611,11 @@ Real SpatialPooler::initPermNonConnected_() {
 }
 
 
-vector<Real> SpatialPooler::initPermanence_(const vector<UInt> &potential, //TODO make potential sparse
+vector<Real> SpatialPooler::initPermanence_(const vector<UInt> &potential,
                                             Real connectedPct) {
-  vector<Real> perm(numInputs_, 0);
-  for (UInt i = 0; i < numInputs_; i++) {
-    if (potential[i] < 1) {
-      continue;
-    }
-
+  vector<Real> perm(potential.size());
+  for (UInt i = 0; i < potential.size(); i++) {
+    NTA_ASSERT(potential[i] < numInputs_);
     if (rng_.getReal64() <= connectedPct) {
       perm[i] = initPermConnected_();
     } else {
@@ -606,9 +634,16 @@ void SpatialPooler::updateInhibitionRadius_() {
     return;
   }
 
+  vector<Real> spans(numColumns_);
+  parallelFor_(numColumns_, [&](size_t begin, size_t end, UInt) {
+    for (size_t i = begin; i < end; i++) {
+      spans[i] = avgConnectedSpanForColumnND_((UInt)i);
+    }
+  });
+  // Sum in column order, so that rounding does not depend on the threads.
   Real connectedSpan = 0.0f;
   for (UInt i = 0; i < numColumns_; i++) {
-    connectedSpan += avgConnectedSpanForColumnND_(i);
+    connectedSpan += spans[i];
   }
   connectedSpan /= numColumns_;
   const Real columnsPerInput = avgColumnsPerInput_();
@@ -640,22 +675,13 @@ void SpatialPooler::updateMinDutyCyclesGlobal_() {
 
 
 void SpatialPooler::updateMinDutyCyclesLocal_() {
+  // The neighborhoods are boxes, so their maxima are computed with sliding
+  // windows along each dimension instead of visiting every neighbor.
+  auto &maxOverlapDuty = neighborhoodDutyCycles_;
+  neighborhoodMax(overlapDutyCycles_, inhibitionRadius_, columnDimensions_,
+                  wrapAround_, maxOverlapDuty);
   for (UInt i = 0; i < numColumns_; i++) {
-    Real maxActiveDuty = 0.0f;
-    Real maxOverlapDuty = 0.0f;
-    if (wrapAround_) {
-     for(auto column : WrappingNeighborhood(i, inhibitionRadius_, columnDimensions_)) {
-      maxActiveDuty = max(maxActiveDuty, activeDutyCycles_[column]);
-      maxOverlapDuty = max(maxOverlapDuty, overlapDutyCycles_[column]);
-     }
-    } else {
-     for(auto column: Neighborhood(i, inhibitionRadius_, columnDimensions_)) {
-      maxActiveDuty = max(maxActiveDuty, activeDutyCycles_[column]);
-      maxOverlapDuty = max(maxOverlapDuty, overlapDutyCycles_[column]);
-      }
-    }
-
-    minOverlapDutyCycles_[i] = maxOverlapDuty * minPctOverlapDutyCycles_;
+    minOverlapDutyCycles_[i] = maxOverlapDuty[i] * minPctOverlapDutyCycles_;
   }
 }
 
@@ -729,19 +755,60 @@ Real SpatialPooler::avgConnectedSpanForColumnND_(UInt column) const {
 
 void SpatialPooler::adaptSynapses_(const SDR &input,
                                    const SDR &active) {
-  for(const auto &column : active.getSparse()) {
-    connections_.adaptSegment(column, input, synPermActiveInc_, synPermInactiveDec_);
-    connections_.raisePermanencesToThreshold( column, stimulusThreshold_ );
+  const auto &activeColumns = active.getSparse();
+  if (pool_ == nullptr) {
+    for(const auto &column : activeColumns) {
+      connections_.adaptSegment(column, input, synPermActiveInc_, synPermInactiveDec_);
+      connections_.raisePermanencesToThreshold( column, stimulusThreshold_ );
+    }
+    return;
+  }
+
+  // Each column is a separate segment, so the columns can learn in parallel.
+  // The presynaptic bookkeeping is shared, it is applied afterwards in the
+  // same order as the serial loop above would.
+  input.getDense(); // Convert once, before the workers read it.
+  threadUpdates_.resize(numThreads_);
+  parallelFor_(activeColumns.size(), [&](size_t begin, size_t end, UInt worker) {
+    auto &pending = threadUpdates_[worker];
+    for (size_t i = begin; i < end; i++) {
+      const auto column = activeColumns[i];
+      connections_.adaptSegment(column, input, synPermActiveInc_, synPermInactiveDec_, &pending);
+      connections_.raisePermanencesToThreshold( column, stimulusThreshold_, &pending );
+    }
+  });
+  for (auto &pending : threadUpdates_) {
+    connections_.applyPendingUpdates(pending);
+    pending.clear();
   }
 }
 
 
 void SpatialPooler::bumpUpWeakColumns_() {
-  for (UInt i = 0; i < numColumns_; i++) {
-    if (overlapDutyCycles_[i] >= minOverlapDutyCycles_[i]) {
-      continue;
+  if (pool_ == nullptr) {
+    for (UInt i = 0; i < numColumns_; i++) {
+      if (overlapDutyCycles_[i] >= minOverlapDutyCycles_[i]) {
+        continue;
+      }
+      connections_.bumpSegment( i, synPermBelowStimulusInc_ );
     }
-    connections_.bumpSegment( i, synPermBelowStimulusInc_ );
+    return;
+  }
+
+  // See adaptSynapses_
+  threadUpdates_.resize(numThreads_);
+  parallelFor_(numColumns_, [&](size_t begin, size_t end, UInt worker) {
+    auto &pending = threadUpdates_[worker];
+    for (UInt i = (UInt)begin; i < end; i++) {
+      if (overlapDutyCycles_[i] >= minOverlapDutyCycles_[i]) {
+        continue;
+      }
+      connections_.bumpSegment( i, synPermBelowStimulusInc_, &pending );
+    }
+  });
+  for (auto &pending : threadUpdates_) {
+    connections_.applyPendingUpdates(pending);
+    pending.clear();
   }
 }
 
@@ -790,33 +857,26 @@ void SpatialPooler::updateBoostFactorsGlobal_() {
     targetDensity = localAreaDensity_;
   }
 
-  for (UInt i = 0; i < numColumns_; ++i) {
-    boostFactors_[i] = exp((targetDensity - activeDutyCycles_[i]) * boostStrength_);
-  }
+  parallelFor_(numColumns_, [&](size_t begin, size_t end, UInt) {
+    for (size_t i = begin; i < end; ++i) {
+      boostFactors_[i] = exp((targetDensity - activeDutyCycles_[i]) * boostStrength_);
+    }
+  });
 }
 
 
 void SpatialPooler::updateBoostFactorsLocal_() {
-  for (UInt i = 0; i < numColumns_; ++i) {
-    UInt numNeighbors = 0u;
-    Real localActivityDensity = 0.0f;
-
-    if (wrapAround_) {
-      for(auto neighbor: WrappingNeighborhood(i, inhibitionRadius_, columnDimensions_)) {
-        localActivityDensity += activeDutyCycles_[neighbor];
-        numNeighbors += 1;
-      }
-    } else {
-      for(auto neighbor: Neighborhood(i, inhibitionRadius_, columnDimensions_)) {
-        localActivityDensity += activeDutyCycles_[neighbor];
-        numNeighbors += 1;
-      }
-    }
-
-    const Real targetDensity = localActivityDensity / numNeighbors;
+  // See updateMinDutyCyclesLocal_
+  auto &localActivityDensity = neighborhoodDutyCycles_;
+  neighborhoodMean(activeDutyCycles_, inhibitionRadius_, columnDimensions_,
+                   wrapAround_, localActivityDensity);
+  parallelFor_(numColumns_, [&](size_t begin, size_t end, UInt) {
+  for (UInt i = (UInt)begin; i < end; ++i) {
+    const Real targetDensity = localActivityDensity[i];
     boostFactors_[i] =
         exp((targetDensity - activeDutyCycles_[i]) * boostStrength_);
   }
+  });
 }
 
 
@@ -831,21 +891,48 @@ void SpatialPooler::updateBookeepingVars_(bool learn) {
 void SpatialPooler::calculateOverlap_(const SDR &input,
                                       vector<SynapseIdx> &overlaps) {
   overlaps.assign( numColumns_, 0 );
-  connections_.computeActivity(overlaps, input.getSparse());
+  const auto &activeInputs = input.getSparse();
+  if (pool_ == nullptr) {
+    connections_.computeActivity(overlaps, activeInputs);
+    return;
+  }
+
+  // Each worker counts the synapses of a slice of the active inputs into its
+  // own buffer, then the buffers are summed up column by column.  Note that
+  // computeActivity only reads the Connections, the SP never uses timeseries.
+  parallelFor_(activeInputs.size(), [&](size_t begin, size_t end, UInt worker) {
+    auto &partial = threadOverlaps_[worker];
+    std::fill( partial.begin(), partial.end(), (SynapseIdx)0 );
+    auto &slice = threadSlices_[worker];
+    slice.assign(activeInputs.begin() + begin, activeInputs.begin() + end);
+    connections_.computeActivity(partial, slice);
+  });
+  parallelFor_(numColumns_, [&](size_t begin, size_t end, UInt) {
+    for (UInt w = 0; w < numThreads_; w++) {
+      size_t first, last;
+      pool_->range(activeInputs.size(), w, first, last);
+      if (first == last) continue; // This worker had no inputs.
+      const auto &partial = threadOverlaps_[w];
+      for (size_t i = begin; i < end; i++) {
+        overlaps[i] = (SynapseIdx)(overlaps[i] + partial[i]);
+      }
+    }
+  });
 }
 
 
 void SpatialPooler::calculateOverlapPct_(const vector<SynapseIdx> &overlaps,
                                          vector<Real> &overlapPct) const {
   overlapPct.assign(numColumns_, 0);
-  vector<UInt> connectedCounts( numColumns_ );
-  getConnectedCounts( connectedCounts.data() );
-
-  for (UInt i = 0; i < numColumns_; i++) {
-    if (connectedCounts[i] != 0) {
-      overlapPct[i] = ((Real)overlaps[i]) / connectedCounts[i];
+  parallelFor_(numColumns_, [&](size_t begin, size_t end, UInt) {
+    for (size_t i = begin; i < end; i++) {
+      const UInt connectedCount =
+          connections_.dataForSegment( (connections::Segment)i ).numConnected;
+      if (connectedCount != 0) {
+        overlapPct[i] = ((Real)overlaps[i]) / connectedCount;
+      }
     }
-  }
+  });
 }
 
 
@@ -870,42 +957,141 @@ void SpatialPooler::inhibitColumns_(const vector<Real> &overlaps,
 }
 
 
+namespace {
+
+// Global inhibition selects the winners by radix, on the bits of the
+// overlaps.  Each pass counts one digit of the columns which are still in
+// the running, finds the digit of the last winner, and keeps only the
+// columns with that digit for the next pass.
+const UInt INHIBITION_RADIX_BITS = 11u;
+const UInt INHIBITION_RADIX      = 1u << INHIBITION_RADIX_BITS;
+
+typedef conditional<sizeof(Real) == 4u, UInt32, UInt64>::type RealBits;
+const UInt REAL_BITS = 8u * sizeof(Real);
+
+// Maps a Real to an unsigned integer with the same order: flip the sign bit
+// of positive numbers, and all bits of negative numbers.
+inline RealBits sortableBits(Real value) {
+  RealBits bits;
+  memcpy(&bits, &value, sizeof(bits));
+  const RealBits sign = (RealBits)1u << (REAL_BITS - 1u);
+  return (bits & sign) ? ~bits : (bits | sign);
+}
+
+inline UInt radixDigit(Real value, UInt shift) {
+  return (UInt)(sortableBits(value) >> shift) & (INHIBITION_RADIX - 1u);
+}
+
+// Returns the digit of the n-th biggest key, and the number of keys with a
+// bigger digit.
+UInt selectDigit(const UInt *histogram, UInt n, UInt &numBigger) {
+  UInt digit = INHIBITION_RADIX - 1u;
+  numBigger = 0u;
+  while (numBigger + histogram[digit] < n) {
+    numBigger += histogram[digit];
+    digit--;
+  }
+  return digit;
+}
+
+} // namespace
+
+
 void SpatialPooler::inhibitColumnsGlobal_(const vector<Real> &overlaps,
                                           Real density,
                                           vector<UInt> &activeColumns) const {
   NTA_ASSERT(!overlaps.empty());
   NTA_ASSERT(density > 0.0f && density <= 1.0f);
 
-  // Add a tiebreaker to the overlaps so that the output is deterministic.
-  vector<Real> overlaps_(overlaps.begin(), overlaps.end());
-  for(UInt i = 0; i < numColumns_; i++)
-    overlaps_[i] += tieBreaker_[i];
-
   activeColumns.clear();
   const UInt numDesired = (UInt)(density * numColumns_);
   NTA_CHECK(numDesired > 0) << "Not enough columns (" << numColumns_ << ") "
                             << "for desired density (" << density << ").";
-  // Sort the columns by the amount of overlap.  First make a list of all of the
-  // column indexes.
-  activeColumns.reserve(numColumns_);
-  for(UInt i = 0; i < numColumns_; i++)
-    activeColumns.push_back(i);
-  // Compare the column indexes by their overlap.
-  auto compare = [&overlaps_](const UInt &a, const UInt &b) -> bool
-    {return overlaps_[a] > overlaps_[b];};
-  // Do a partial sort to divide the winners from the losers.  This sort is
-  // faster than a regular sort because it stops after it partitions the
-  // elements about the Nth element, with all elements on their correct side of
-  // the Nth element.
-  std::nth_element(
-    activeColumns.begin(),
-    activeColumns.begin() + numDesired,
-    activeColumns.end(),
-    compare);
-  // Remove the columns which lost the competition.
-  activeColumns.resize(numDesired);
-  // Finish sorting the winner columns by their overlap.
-  std::sort(activeColumns.begin(), activeColumns.end(), compare);
+
+  // Add a tiebreaker to the overlaps so that the output is deterministic.
+  // Columns with exactly equal sums are ranked by index.
+  auto &keys = tieBrokenOverlaps_;
+  keys.resize(numColumns_);
+
+  // The first pass looks at every column, so count its digits in parallel,
+  // one histogram per thread, and then add them up.
+  UInt shift = REAL_BITS - INHIBITION_RADIX_BITS;
+  inhibitionHistograms_.assign((size_t)numThreads_ * INHIBITION_RADIX, 0u);
+  parallelFor_(numColumns_, [&](size_t begin, size_t end, UInt worker) {
+    UInt *histogram = inhibitionHistograms_.data() + (size_t)worker * INHIBITION_RADIX;
+    for (size_t i = begin; i < end; i++) {
+      keys[i] = overlaps[i] + tieBreaker_[i];
+      histogram[radixDigit(keys[i], shift)]++;
+    }
+  });
+  UInt *histogram = inhibitionHistograms_.data();
+  for (UInt w = 1u; w < numThreads_; w++) {
+    const UInt *partial = histogram + (size_t)w * INHIBITION_RADIX;
+    for (UInt d = 0u; d < INHIBITION_RADIX; d++) {
+      histogram[d] += partial[d];
+    }
+  }
+
+  // Most columns lose on the first digit.  Columns with a bigger digit than
+  // the last winner win, and columns with the same digit stay candidates,
+  // in order of index.
+  UInt numBigger;
+  UInt digit = selectDigit(histogram, numDesired, numBigger);
+  auto &candidates = inhibitionCandidates_;
+  candidates.clear();
+  const RealBits lowest = (RealBits)digit << shift;
+  for (UInt i = 0u; i < numColumns_; i++) {
+    const RealBits bits = sortableBits(keys[i]);
+    if (bits >= lowest) {
+      if ((UInt)(bits >> shift) > digit) {
+        activeColumns.push_back(i);
+      } else {
+        candidates.push_back(i);
+      }
+    }
+  }
+
+  // The remaining passes only look at the candidates.
+  UInt numRemaining = numDesired - numBigger;
+  while (numRemaining < candidates.size() && shift > 0u) {
+    shift = (shift > INHIBITION_RADIX_BITS) ? shift - INHIBITION_RADIX_BITS : 0u;
+    fill(histogram, histogram + INHIBITION_RADIX, 0u);
+    for (const auto &column : candidates) {
+      histogram[radixDigit(keys[column], shift)]++;
+    }
+    digit = selectDigit(histogram, numRemaining, numBigger);
+    size_t numCandidates = 0u;
+    for (const auto &column : candidates) {
+      const UInt d = radixDigit(keys[column], shift);
+      if (d > digit) {
+        activeColumns.push_back(column);
+      } else if (d == digit) {
+        candidates[numCandidates++] = column;
+      }
+    }
+    candidates.resize(numCandidates);
+    numRemaining -= numBigger;
+  }
+  // Any candidates left over have equal keys, the lowest indexes win.
+  activeColumns.insert(activeColumns.end(), candidates.begin(),
+                       candidates.begin() + numRemaining);
+  NTA_ASSERT(activeColumns.size() == numDesired);
+
+  // Sort the winner columns by their overlap.  Sorting the keys along with
+  // the columns keeps the comparisons in cache.
+  auto &winners = inhibitionWinners_;
+  winners.clear();
+  for (const auto &column : activeColumns) {
+    winners.emplace_back(keys[column], column);
+  }
+  std::sort(winners.begin(), winners.end(),
+            [](const pair<Real, UInt> &a, const pair<Real, UInt> &b) -> bool {
+              return a.first > b.first ||
+                     (a.first == b.first && a.second < b.second);
+            });
+  for (UInt i = 0u; i < numDesired; i++) {
+    activeColumns[i] = winners[i].second;
+  }
   // Remove sub-threshold winners
   while( !activeColumns.empty() &&
          overlaps[activeColumns.back()] < stimulusThreshold_)
@@ -913,56 +1099,247 @@ void SpatialPooler::inhibitColumnsGlobal_(const vector<Real> &overlaps,
 }
 
 
-void SpatialPooler::inhibitColumnsLocal_(const vector<Real> &overlaps,
-                                         Real density,
-                                         vector<UInt> &activeColumns) const {
-  activeColumns.clear();
+namespace {
 
-  // Tie-breaking: when overlaps are equal, columns that have already been
-  // selected are treated as "bigger".
-  vector<bool> activeColumnsDense(numColumns_, false);
+// The state of a column during local inhibition.
+enum LocalInhibitionState : Byte { INACTIVE = 0, ACTIVE = 1, UNDECIDED = 2 };
 
-  for (UInt column = 0; column < numColumns_; column++) {
-    if (overlaps[column] < stimulusThreshold_) {
-      continue;
+// Decides a column from the number of its neighbors which are strictly
+// bigger, and which are bigger or tie with a lower index.  Columns which
+// depend on how their tied neighbors turn out are left UNDECIDED.
+inline void classifyColumn(UInt bigger, UInt biggerOrTied, UInt active,
+                           Byte &state, UInt &numBigger, UInt &numActive) {
+  if (biggerOrTied < active) {
+    state = ACTIVE;
+  } else if (bigger < active) {
+    state     = UNDECIDED;
+    numBigger = bigger;
+    numActive = active;
+  }
+}
+
+// Counts a set of ranks, in a Fenwick tree.
+class RankCounter {
+public:
+  explicit RankCounter(size_t numRanks) : tree_(numRanks + 1u, 0) {}
+
+  void add(UInt rank, Int delta) {
+    for (size_t i = rank + 1u; i < tree_.size(); i += i & (~i + 1u)) {
+      tree_[i] += delta;
     }
+  }
 
-    UInt numNeighbors = 0;
-    UInt numBigger = 0;
+  // Number of ranks in the set which are less than rank.
+  UInt countBelow(UInt rank) const {
+    Int count = 0;
+    for (size_t i = rank; i > 0u; i -= i & (~i + 1u)) {
+      count += tree_[i];
+    }
+    return (UInt)count;
+  }
 
+private:
+  vector<Int> tree_;
+};
 
-      if (wrapAround_) {
-        for(auto neighbor: WrappingNeighborhood(column, inhibitionRadius_,columnDimensions_)) {
-          if (neighbor == column) {
-            continue;
-          }
-          numNeighbors++;
+// The coordinates of a neighborhood along one dimension, as the range
+// [begin, end) before wrapping around.  The same coordinates which
+// Neighborhood and WrappingNeighborhood visit.
+inline void neighborhoodRange(UInt center, UInt radius, UInt size, bool wrap,
+                              Int &begin, Int &end) {
+  if (wrap) {
+    const Int length = (Int)min(2u * radius + 1u, size);
+    begin = (length == (Int)size) ? 0 : (Int)center - (Int)radius;
+    end   = begin + length;
+  } else {
+    begin = max((Int)center - (Int)radius, 0);
+    end   = (Int)min(center + radius + 1u, size);
+  }
+}
 
-          const Real difference = overlaps[neighbor] - overlaps[column];
-          if (difference > 0 || (difference == 0 && activeColumnsDense[neighbor])) {
-            numBigger++;
-          }
-	}
-      } else {
-        for(auto neighbor: Neighborhood(column, inhibitionRadius_, columnDimensions_)) {
+inline UInt wrapCoordinate(Int coordinate, UInt size) {
+  const Int wrapped = coordinate % (Int)size;
+  return (UInt)(wrapped < 0 ? wrapped + (Int)size : wrapped);
+}
+
+} // namespace
+
+
+void SpatialPooler::inhibitColumnsLocal_(const vector<Real> &overlaps,
+                                         Real density,
+                                         vector<UInt> &activeColumns,
+                                         LocalInhibition method) const {
+  activeColumns.clear();
+
+  // Tie-breaking: when overlaps are equal, columns that have already been
+  // selected are treated as "bigger".  Only columns with a lower index can
+  // have been selected, so that is the only dependency between columns.
+  //
+  // The first pass looks at each column on its own (in parallel) and counts
+  // the neighbors which are strictly bigger, and the lower neighbors which tie.
+  // That decides most columns no matter how their tied neighbors turn out.
+  // The remaining columns are decided in the second pass, in order, by
+  // counting their tied neighbors which won.
+  vector<Byte> state(numColumns_, INACTIVE);
+  vector<UInt> numBigger(numColumns_, 0u);
+  vector<UInt> numActive(numColumns_, 0u);
+  // Both passes visit neighborhoods, build their table before the threads do.
+  columnNeighborhoods_.update(inhibitionRadius_, columnDimensions_, wrapAround_);
+
+  if (columnDimensions_.size() > 2u) {
+    method = LocalInhibition::Scan;
+  } else if (method == LocalInhibition::Auto) {
+    // Scanning visits the whole neighborhood of each column.  Ranking sorts
+    // the columns, and then moves one row of the neighborhood in and out of
+    // the count for each column, at log(columns) per update.  The weights
+    // are measured costs per column, see ConnectionsPerformanceTest.
+    const UInt diameter  = 2u * inhibitionRadius_ + 1u;
+    const UInt rowLength = columnDimensions_.back();
+    const UInt numRows   = columnDimensions_.size() == 2u ? columnDimensions_[0] : 1u;
+    const UInt64 neighborhoodRows = min(diameter, numRows);
+    const UInt64 scanCost =
+        35u + 2u * (UInt64)min(diameter, rowLength) * neighborhoodRows;
+    const UInt64 rankCost =
+        30u + (2u * neighborhoodRows + 2u) * (UInt64)ceil(log2((Real64)numColumns_ + 1.0));
+    method = rankCost < scanCost ? LocalInhibition::Rank : LocalInhibition::Scan;
+  }
+
+  if (method == LocalInhibition::Rank) {
+    rankColumnsLocal_(overlaps, density, state, numBigger, numActive);
+  } else {
+    parallelFor_(numColumns_, [&](size_t begin, size_t end, UInt) {
+      for (UInt column = (UInt)begin; column < end; column++) {
+        if (overlaps[column] < stimulusThreshold_) {
+          continue;
+        }
+
+        UInt numNeighbors = 0;
+        UInt bigger = 0;
+        UInt tied = 0;
+        const auto visit = [&](UInt neighbor) {
           if (neighbor == column) {
-            continue;
+            return;
           }
           numNeighbors++;
 
           const Real difference = overlaps[neighbor] - overlaps[column];
-          if (difference > 0 || (difference == 0 && activeColumnsDense[neighbor])) {
-            numBigger++;
+          if (difference > 0) {
+            bigger++;
+          } else if (difference == 0 && neighbor < column) {
+            tied++;
           }
-	}
-      }
+        };
+        columnNeighborhoods_.forEach(column, visit);
 
-      const UInt numActive = (UInt)(0.5f + (density * (numNeighbors + 1)));
-      if (numBigger < numActive) {
-        activeColumns.push_back(column);
-        activeColumnsDense[column] = true;
+        const UInt active = (UInt)(0.5f + (density * (numNeighbors + 1)));
+        classifyColumn(bigger, bigger + tied, active, state[column],
+                       numBigger[column], numActive[column]);
       }
+    });
   }
+
+  for (UInt column = 0; column < numColumns_; column++) {
+    if (state[column] == UNDECIDED) {
+      UInt bigger = numBigger[column];
+      const auto visit = [&](UInt neighbor) {
+        if (neighbor < column && state[neighbor] == ACTIVE &&
+            overlaps[neighbor] - overlaps[column] == 0) {
+          bigger++;
+        }
+      };
+      columnNeighborhoods_.forEach(column, visit);
+      state[column] = bigger < numActive[column] ? ACTIVE : INACTIVE;
+    }
+    if (state[column] == ACTIVE) {
+      activeColumns.push_back(column);
+    }
+  }
+}
+
+
+void SpatialPooler::rankColumnsLocal_(const vector<Real> &overlaps,
+                                      Real density, vector<Byte> &state,
+                                      vector<UInt> &numBigger,
+                                      vector<UInt> &numActive) const {
+  NTA_ASSERT(columnDimensions_.size() <= 2u);
+
+  // Rank the columns by decreasing overlap, then by increasing index.  The
+  // neighbors which are bigger or tie with a lower index are then the ones
+  // ranked before a column, and the strictly bigger neighbors are the ones
+  // ranked before the first column with the same overlap.
+  vector<pair<Real, UInt>> order(numColumns_);
+  for (UInt column = 0; column < numColumns_; column++) {
+    order[column] = make_pair(overlaps[column], column);
+  }
+  std::sort(order.begin(), order.end(),
+            [](const pair<Real, UInt> &a, const pair<Real, UInt> &b) -> bool {
+              return a.first > b.first ||
+                     (a.first == b.first && a.second < b.second);
+            });
+  vector<UInt> rank(numColumns_);
+  vector<UInt> firstRank(numColumns_);
+  for (UInt i = 0; i < numColumns_; i++) {
+    const UInt column = order[i].second;
+    rank[column]      = i;
+    firstRank[column] = (i > 0u && order[i - 1u].first == order[i].first)
+                            ? firstRank[order[i - 1u].second] : i;
+  }
+
+  // Slide the neighborhood along each row, keeping count of the ranks in
+  // it.  A 1-D topology is a single row.
+  const UInt rowLength = columnDimensions_.back();
+  const UInt numRows   = columnDimensions_.size() == 2u ? columnDimensions_[0] : 1u;
+  parallelFor_(numColumns_, [&](size_t begin, size_t end, UInt) {
+    RankCounter counter(numColumns_);
+    for (UInt row = (UInt)(begin / rowLength); (size_t)row * rowLength < end; row++) {
+      const size_t rowBegin = (size_t)row * rowLength;
+      const UInt first = (UInt)(max(begin, rowBegin) - rowBegin);
+      const UInt last  = (UInt)(min(end, rowBegin + rowLength) - rowBegin);
+
+      Int rowsBegin, rowsEnd;
+      neighborhoodRange(row, inhibitionRadius_, numRows, wrapAround_,
+                        rowsBegin, rowsEnd);
+      // Adds or removes the neighborhood's columns at coordinate x.
+      const auto update = [&](Int x, Int delta) {
+        const UInt wrappedX = wrapCoordinate(x, rowLength);
+        for (Int y = rowsBegin; y < rowsEnd; y++) {
+          counter.add(rank[wrapCoordinate(y, numRows) * rowLength + wrappedX], delta);
+        }
+      };
+
+      Int windowBegin, windowEnd;
+      neighborhoodRange(first, inhibitionRadius_, rowLength, wrapAround_,
+                        windowBegin, windowEnd);
+      for (Int x = windowBegin; x < windowEnd; x++) {
+        update(x, 1);
+      }
+      for (UInt x = first; x < last; x++) {
+        Int nextBegin, nextEnd;
+        neighborhoodRange(x, inhibitionRadius_, rowLength, wrapAround_,
+                          nextBegin, nextEnd);
+        for (; windowBegin < nextBegin; windowBegin++) {
+          update(windowBegin, -1);
+        }
+        for (; windowEnd < nextEnd; windowEnd++) {
+          update(windowEnd, 1);
+        }
+
+        const UInt column = (UInt)rowBegin + x;
+        if (overlaps[column] < stimulusThreshold_) {
+          continue;
+        }
+        const UInt numNeighbors =
+            (UInt)((rowsEnd - rowsBegin) * (windowEnd - windowBegin)) - 1u;
+        const UInt active = (UInt)(0.5f + (density * (numNeighbors + 1)));
+        classifyColumn(counter.countBelow(firstRank[column]),
+                       counter.countBelow(rank[column]), active,
+                       state[column], numBigger[column], numActive[column]);
+      }
+      for (Int x = windowBegin; x < windowEnd; x++) {
+        update(x, -1);
+      }
+    }
+  });
 }
 
 
@@ -1123,6 +1500,7 @@ void SpatialPooler::load(istream &inStream) {
   overlaps_.resize(numColumns_);
   overlapsPct_.resize(numColumns_);
   boostedOverlaps_.resize(numColumns_);
+  resizeThreadScratch_();
 }
 
 
@@ -30,10 +30,13 @@
 #include <iostream>
 #include <vector>
 #include <iomanip> // std::setprecision
+#include <memory>
 #include <nupic/algorithms/Connections.hpp>
+#include <nupic/math/Topology.hpp>
 #include <nupic/types/Types.hpp>
 #include <nupic/types/Serializable.hpp>
 #include <nupic/types/Sdr.hpp>
+#include <nupic/utils/ThreadPool.hpp>
 
 
 namespace nupic {
@@ -381,6 +384,7 @@ public:
     overlaps_.resize(numColumns_);
     overlapsPct_.resize(numColumns_);
     boostedOverlaps_.resize(numColumns_);
+    resizeThreadScratch_();
   }
 
   /**
@@ -597,6 +601,24 @@ public:
   */
   void setWrapAround(bool wrapAround);
 
+  /**
+  Returns the number of threads used by compute.
+
+  @returns integer number of threads.
+  */
+  UInt getNumThreads() const;
+
+  /**
+  Sets the number of threads used by compute.  With more than one thread the
+  per-column work of compute (overlaps, boosting, local inhibition and
+  learning) is split across a pool of worker threads.  The results are
+  identical to running on a single thread.  This is a run time setting; it is
+  not serialized and copies of the SpatialPooler share the thread pool.
+
+  @param numThreads integer number of threads, at least 1.  Default 1.
+  */
+  void setNumThreads(UInt numThreads);
+
   /**
   Returns the update period.
 
@@ -866,8 +888,8 @@ public:
     This method encapsultes the topology of
     the region. It takes the index of the column as an argument and determines
     what are the indices of the input vector that are located within the
-    column's potential pool. The return value is a list containing the indices
-    of the input bits. The current implementation of the base class only
+    column's potential pool. The return value is a sorted list containing the
+    indices of the input bits. The current implementation of the base class only
     supports a 1 dimensional topology of columns with a 1 dimensional topology
     of inputs. To extend this class to support 2-D topology you will need to
     override this method. Examples of the expected output of this method:
@@ -918,15 +940,12 @@ public:
 
   /**
     Initializes the permanences of a column. The method
-    returns a 1-D array the size of the input, where each entry in the
-    array represents the initial permanence value between the input bit
-    at the particular index in the array, and the column represented by
-    the 'index' parameter.
-
-    @param potential      A int vector specifying the potential pool of the
-    column. Permanence values will only be generated for input bits
+    returns a 1-D array the size of the potential pool, where each entry in
+    the array represents the initial permanence value between the input bit
+    at the same position in potential, and the column.
 
-                    corresponding to indices for which the mask value is 1.
+    @param potential      The indices of the input bits in the potential pool
+    of the column, as returned by initMapPotential_.
     @param connectedPct   A real value between 0 or 1 specifying the percent of
     the input bits that will start off in a connected state.
   */
@@ -986,6 +1005,12 @@ public:
      active. Columns with an overlap score below the 'stimulusThreshold'
      are always inhibited.
 
+     The winners are selected with a radix select on the overlaps plus
+     the tie breakers, which takes time linear in the number of columns
+     and does not allocate once the scratch space has grown.  Columns
+     with exactly equal scores are ranked by index.  The active columns
+     are sorted by decreasing score.
+
      @param overlaps
      a real array containing the overlap score for each column. The
      overlap score for a column is defined as the number of synapses in
@@ -1026,9 +1051,26 @@ public:
 
      @param activeColumns
      an int array containing the indices of the active columns.
-  */
+
+     @param method
+     How to count the neighbors which beat each column, see
+     LocalInhibition.  All methods select the same columns.
+  */
+  enum class LocalInhibition {
+    /** Choose by the size of the neighborhood. */
+    Auto,
+    /** Visit every neighbor of every column, O(columns * (2r+1)^d). */
+    Scan,
+    /**
+     Rank all columns by overlap, and count the ranks in a window which
+     slides along the rows of a 1-D or 2-D topology, O(columns *
+     (2r+1)^(d-1) * log(columns)).  Other topologies fall back to Scan.
+     */
+    Rank
+  };
   void inhibitColumnsLocal_(const vector<Real> &overlaps, Real density,
-                            vector<UInt> &activeColumns) const;
+                            vector<UInt> &activeColumns,
+                            LocalInhibition method = LocalInhibition::Auto) const;
 
   /**
       The primary method in charge of learning.
@@ -1234,7 +1276,7 @@ public:
 
 protected:
   UInt numInputs_;
-  UInt numColumns_;
+  UInt numColumns_ = 0u;
   vector<UInt> columnDimensions_;
   vector<UInt> inputDimensions_;
   UInt potentialRadius_;
@@ -1282,6 +1324,46 @@ protected:
 
   UInt version_;
   Random rng_;
+
+private:
+  /**
+   Calls fn over the range [0, n), split across the thread pool when there is
+   one, see util::ThreadPool::parallelFor.
+   */
+  void parallelFor_(size_t n, const util::ThreadPool::RangeFunction &fn) const;
+
+  /**
+   Sizes the per thread buffers of calculateOverlap_ for the number of
+   threads and columns, so that compute does not allocate them.
+   */
+  void resizeThreadScratch_();
+
+  /**
+   The first pass of local inhibition for LocalInhibition::Rank, see
+   inhibitColumnsLocal_.  Fills in state, numBigger and numActive for the
+   columns with enough overlap.
+   */
+  void rankColumnsLocal_(const vector<Real> &overlaps, Real density,
+                         vector<Byte> &state, vector<UInt> &numBigger,
+                         vector<UInt> &numActive) const;
+
+  UInt numThreads_ = 1u;
+  std::shared_ptr<util::ThreadPool> pool_;
+  // Per thread scratch space.
+  vector<vector<SynapseIdx>> threadOverlaps_;
+  vector<vector<connections::CellIdx>> threadSlices_;
+  vector<vector<connections::PendingSynapseUpdate>> threadUpdates_;
+  // Scratch space for global inhibition.
+  mutable vector<Real> tieBrokenOverlaps_;
+  mutable vector<UInt> inhibitionHistograms_;
+  mutable vector<UInt> inhibitionCandidates_;
+  mutable vector<pair<Real, UInt>> inhibitionWinners_;
+  // Neighborhoods of the columns for local inhibition, and of the inputs for
+  // the potential pools, rebuilt when their radius changes.
+  mutable math::topology::NeighborhoodTable columnNeighborhoods_;
+  math::topology::NeighborhoodTable inputNeighborhoods_;
+  // Scratch space for the local duty cycle and boost factor updates.
+  vector<Real> neighborhoodDutyCycles_;
 };
 
 } // end namespace spatial_pooler
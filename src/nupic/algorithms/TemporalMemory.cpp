@@ -47,10 +47,12 @@
 
 #include <nupic/utils/GroupBy.hpp>
 #include <nupic/math/Math.hpp> // nupic::Epsilon
+#include <nupic/utils/Trace.hpp>
 
 using namespace std;
 using namespace nupic;
 using nupic::sdr::SDR;
+using nupic::util::TraceScope;
 using namespace nupic::algorithms::temporal_memory;
 
 
@@ -138,7 +140,10 @@ void TemporalMemory::initialize(
   extra_ = extra;
 
   // Initialize member variables
-  connections = Connections(static_cast<CellIdx>(numberOfColumns() * cellsPerColumn_), connectedPermanence_);
+  // Many cells with a few synapses each, so the presynaptic index goes in
+  // arenas.
+  connections = Connections(static_cast<CellIdx>(numberOfColumns() * cellsPerColumn_),
+                            connectedPermanence_, false, true);
   rng_ = Random(seed);
 
   maxSegmentsPerCell_ = maxSegmentsPerCell;
@@ -186,7 +191,7 @@ static void adaptSegment(Connections &connections, Segment segment,
                          const vector<bool> &prevActiveCellsDense,
                          Permanence permanenceIncrement,
                          Permanence permanenceDecrement) {
-  const vector<Synapse> &synapses = connections.synapsesForSegment(segment);
+  const SynapseList synapses = connections.synapsesForSegment(segment);
 
   for (SynapseIdx i = 0; i < synapses.size();) {
     const SynapseData &synapseData = connections.dataForSynapse(synapses[i]);
@@ -344,7 +349,7 @@ static Segment createSegment(Connections &connections,  //TODO remove, use TM::c
                              CellIdx cell, UInt64 iteration,
                              UInt maxSegmentsPerCell) {
   while (connections.numSegments(cell) >= maxSegmentsPerCell) {
-    const vector<Segment> &destroyCandidates =
+    const auto destroyCandidates =
         connections.segmentsForCell(cell);
 
     auto leastRecentlyUsedSegment =
@@ -460,9 +465,10 @@ void TemporalMemory::activateCells(const SDR &activeColumns, bool learn) {
     for(size_t i=0; i< columnDimensions_.size(); i++) {
       NTA_CHECK(static_cast<size_t>(activeColumns.dimensions[i]) == static_cast<size_t>(columnDimensions_[i])) << "Dimensions must be the same.";
     }
-    auto &sparse = activeColumns.getSparse();
-    std::sort(sparse.begin(), sparse.end()); //TODO remove sorted requirement? iterGroupBy depends on it
-    activateCells(sparse.size(), sparse.data(), learn);
+    // iterGroupBy needs the columns in order.  The SDR knows whether they
+    // already are, so they are neither checked nor sorted again.
+    const auto &sparse = activeColumns.getSparseSorted();
+    activateSortedCells_(sparse.size(), sparse.data(), learn);
 }
 
 void TemporalMemory::activateCells(const size_t activeColumnsSize,
@@ -471,6 +477,13 @@ void TemporalMemory::activateCells(const size_t activeColumnsSize,
     NTA_CHECK(std::is_sorted(activeColumns, activeColumns + activeColumnsSize-1))
         << "The activeColumns must be a sorted list of indices without duplicates.";
   }
+  activateSortedCells_(activeColumnsSize, activeColumns, learn);
+}
+
+void TemporalMemory::activateSortedCells_(const size_t activeColumnsSize,
+                                          const UInt activeColumns[],
+                                          bool learn) {
+  TraceScope trace("temporal_memory", "activateCells");
 
   vector<bool> prevActiveCellsDense(numberOfCells() + extra_, false);
   for (CellIdx cell : activeCells_) {
@@ -555,6 +568,7 @@ void TemporalMemory::activateDendrites(bool learn,
 {
   if( segmentsValid_ )
     return;
+  TraceScope trace("temporal_memory", "activateDendrites");
 
   // Handle external predictive inputs.  extraActive & extraWinners default
   // values are `vector({ SENTINEL })`
@@ -582,26 +596,37 @@ void TemporalMemory::activateDendrites(bool learn,
         << "External predictive inputs must be declared to TM constructor!";
   }
 
+  // Segments created since the last call start out with zero counts.
   const size_t length = connections.segmentFlatListLength();
-
-  numActiveConnectedSynapsesForSegment_.assign(length, 0);
-  numActivePotentialSynapsesForSegment_.assign(length, 0);
+  numActiveConnectedSynapsesForSegment_.resize(length, 0);
+  numActivePotentialSynapsesForSegment_.resize(length, 0);
   connections.computeActivity(numActiveConnectedSynapsesForSegment_,
                               numActivePotentialSynapsesForSegment_,
+                              touchedSegments_,
                               activeCells_);
 
-  // Active segments, connected synapses.
+  // Only the touched segments have any active synapses, so threshold those
+  // instead of every segment.
   activeSegments_.clear();
-  for (Segment segment = 0;
-       segment < numActiveConnectedSynapsesForSegment_.size(); segment++) {
+  matchingSegments_.clear();
+  for (const auto &segment : touchedSegments_) {
+    // Active segments, connected synapses.
     if (numActiveConnectedSynapsesForSegment_[segment] >=
         activationThreshold_) {
       activeSegments_.push_back(segment);
     }
+    // Matching segments, potential synapses.
+    if (numActivePotentialSynapsesForSegment_[segment] >= minThreshold_) {
+      matchingSegments_.push_back(segment);
+    }
   }
   std::sort(
       activeSegments_.begin(), activeSegments_.end(),
       [&](Segment a, Segment b) { return connections.compareSegments(a, b); });
+  std::sort(
+      matchingSegments_.begin(), matchingSegments_.end(),
+      [&](Segment a, Segment b) { return connections.compareSegments(a, b); });
+
   // Update segment bookkeeping.
   if (learn) {
     for (const auto &segment : activeSegments_) {
@@ -610,18 +635,6 @@ void TemporalMemory::activateDendrites(bool learn,
     iteration_++;
   }
 
-  // Matching segments, potential synapses.
-  matchingSegments_.clear();
-  for (Segment segment = 0;
-       segment < numActivePotentialSynapsesForSegment_.size(); segment++) {
-    if (numActivePotentialSynapsesForSegment_[segment] >= minThreshold_) {
-      matchingSegments_.push_back(segment);
-    }
-  }
-  std::sort(
-      matchingSegments_.begin(), matchingSegments_.end(),
-      [&](Segment a, Segment b) { return connections.compareSegments(a, b); });
-
   segmentsValid_ = true;
 }
 
@@ -813,6 +826,10 @@ SynapseIdx TemporalMemory::getMaxSynapsesPerSegment() const {
   return maxSynapsesPerSegment_;
 }
 
+UInt64 TemporalMemory::getSeed() const { return rng_.getSeed(); }
+
+void TemporalMemory::setSeed(UInt64 seed) { rng_ = Random(seed); }
+
 UInt TemporalMemory::version() const { return TM_VERSION; }
 
 
@@ -873,7 +890,7 @@ void TemporalMemory::save(ostream &outStream) const {
   outStream << activeSegments_.size() << " ";
   for (Segment segment : activeSegments_) {
     const CellIdx cell = connections.cellForSegment(segment);
-    const vector<Segment> &segments = connections.segmentsForCell(cell);
+    const auto segments = connections.segmentsForCell(cell);
 
     SegmentIdx idx = (SegmentIdx)std::distance(
         segments.begin(), std::find(segments.begin(), segments.end(), segment));
@@ -887,7 +904,7 @@ void TemporalMemory::save(ostream &outStream) const {
   outStream << matchingSegments_.size() << " ";
   for (Segment segment : matchingSegments_) {
     const CellIdx cell = connections.cellForSegment(segment);
-    const vector<Segment> &segments = connections.segmentsForCell(cell);
+    const auto segments = connections.segmentsForCell(cell);
 
     SegmentIdx idx = (SegmentIdx)std::distance(
         segments.begin(), std::find(segments.begin(), segments.end(), segment));
@@ -1003,6 +1020,9 @@ void TemporalMemory::load(istream &inStream) {
       inStream >> numActivePotentialSynapsesForSegment_[segment];
     }
   }
+  touchedSegments_ = activeSegments_;
+  touchedSegments_.insert(touchedSegments_.end(), matchingSegments_.begin(),
+                          matchingSegments_.end());
 
   if (version < 2) {
     UInt numMatchingCells;
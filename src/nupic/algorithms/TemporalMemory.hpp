@@ -434,6 +434,15 @@ public:
    */
   SynapseIdx getMaxSynapsesPerSegment() const;
 
+  /**
+   * Returns the seed of the random number generator.  setSeed restarts the
+   * generator from a new seed.
+   *
+   * @returns Random seed
+   */
+  UInt64 getSeed() const;
+  void setSeed(UInt64 seed);
+
   /**
    * Save (serialize) the current state of the spatial pooler to the
    * specified file.
@@ -479,7 +488,7 @@ public:
     ar( cereal::make_size_tag(activeSegments_.size()));
     for (Segment segment : activeSegments_) {
       const CellIdx cell = connections.cellForSegment(segment);
-      const vector<Segment> &segments = connections.segmentsForCell(cell);
+      const auto segments = connections.segmentsForCell(cell);
 
       SegmentIdx idx = (SegmentIdx)std::distance(
                           segments.begin(), 
@@ -491,7 +500,7 @@ public:
     ar(cereal::make_size_tag(matchingSegments_.size()));
     for (Segment segment : matchingSegments_) {
       const CellIdx cell = connections.cellForSegment(segment);
-      const vector<Segment> &segments = connections.segmentsForCell(cell);
+      const auto segments = connections.segmentsForCell(cell);
 
       SegmentIdx idx = (SegmentIdx)std::distance(
                           segments.begin(), 
@@ -552,6 +561,9 @@ public:
       matchingSegments_[i] = segment;
       numActivePotentialSynapsesForSegment_[segment] = syn;
     }
+    touchedSegments_ = activeSegments_;
+    touchedSegments_.insert(touchedSegments_.end(), matchingSegments_.begin(),
+                            matchingSegments_.end());
 
     lastUsedIterationForSegment_.resize(connections.segmentFlatListLength());
 
@@ -580,6 +592,13 @@ public:
   UInt columnForCell(const CellIdx cell) const; //TODO rm, incorrect
 
 protected:
+  /**
+   * Implements activateCells, for active columns which are already known to
+   * be sorted.
+   */
+  void activateSortedCells_(const size_t activeColumnsSize,
+                            const UInt activeColumns[], bool learn);
+
   CellIdx numColumns_;
   vector<CellIdx> columnDimensions_;
   CellIdx cellsPerColumn_;
@@ -601,6 +620,7 @@ protected:
   vector<Segment> matchingSegments_;
   vector<SynapseIdx> numActiveConnectedSynapsesForSegment_;
   vector<SynapseIdx> numActivePotentialSynapsesForSegment_;
+  vector<Segment> touchedSegments_; // Segments with nonzero counts above.
 
   SegmentIdx maxSegmentsPerCell_;
   SynapseIdx maxSynapsesPerSegment_;
@@ -0,0 +1,87 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2019, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ----------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of TemporalMemoryBatch
+ */
+
+#include <nupic/algorithms/TemporalMemoryBatch.hpp>
+#include <nupic/utils/Log.hpp>
+
+using namespace std;
+using namespace nupic;
+using nupic::sdr::SDR;
+using namespace nupic::algorithms::temporal_memory;
+
+
+TemporalMemoryBatch::TemporalMemoryBatch(UInt numStreams,
+                                         const TemporalMemory &prototype,
+                                         UInt numThreads)
+    : streams_(numStreams, prototype),
+      pool_(new util::ThreadPool(numThreads)) {
+  NTA_CHECK(numStreams > 0u) << "TemporalMemoryBatch needs at least one stream.";
+  // Stream 0 keeps the prototype's random state as is.
+  const UInt64 seed = prototype.getSeed();
+  for (UInt i = 1u; i < numStreams; i++) {
+    streams_[i].setSeed(seed + i);
+  }
+}
+
+
+void TemporalMemoryBatch::computeBatch(const vector<SDR> &activeColumns, bool learn) {
+  NTA_CHECK(activeColumns.size() == streams_.size())
+      << "Expected one SDR per stream (" << streams_.size() << "), got "
+      << activeColumns.size() << ".";
+
+  pool_->parallelFor(streams_.size(), [&](size_t begin, size_t end, UInt) {
+    for (size_t i = begin; i < end; i++) {
+      streams_[i].compute(activeColumns[i], learn);
+    }
+  });
+}
+
+
+void TemporalMemoryBatch::reset() {
+  for (auto &tm : streams_) {
+    tm.reset();
+  }
+}
+
+
+TemporalMemory &TemporalMemoryBatch::stream(UInt index) {
+  NTA_CHECK(index < streams_.size()) << "Stream index out of range: " << index;
+  return streams_[index];
+}
+
+
+const TemporalMemory &TemporalMemoryBatch::stream(UInt index) const {
+  NTA_CHECK(index < streams_.size()) << "Stream index out of range: " << index;
+  return streams_[index];
+}
+
+
+void TemporalMemoryBatch::setNumThreads(UInt numThreads) {
+  NTA_CHECK(numThreads > 0u) << "numThreads must be at least 1.";
+  if (numThreads != pool_->size()) {
+    pool_.reset(new util::ThreadPool(numThreads));
+  }
+}
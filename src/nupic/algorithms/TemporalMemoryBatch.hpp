@@ -0,0 +1,119 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2019, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ----------------------------------------------------------------------
+ */
+
+/** @file
+ * Definitions for the TemporalMemoryBatch
+ */
+
+#ifndef NTA_TEMPORAL_MEMORY_BATCH_HPP
+#define NTA_TEMPORAL_MEMORY_BATCH_HPP
+
+#include <memory>
+#include <vector>
+
+#include <nupic/algorithms/TemporalMemory.hpp>
+#include <nupic/types/Sdr.hpp>
+#include <nupic/types/Types.hpp>
+#include <nupic/utils/ThreadPool.hpp>
+
+namespace nupic {
+namespace algorithms {
+namespace temporal_memory {
+
+/**
+ * A batch of independent TemporalMemory instances ("streams") which share the
+ * same parameters, for running many models side by side, e.g. one per metric.
+ *
+ * Example usage:
+ *
+ *     TemporalMemory prototype(columnDimensions, <parameters>);
+ *     TemporalMemoryBatch batch(numStreams, prototype, numThreads);
+ *
+ *     vector<SDR> activeColumns(numStreams, SDR(columnDimensions));
+ *     while (true) {
+ *        <set activeColumns[i] for each stream>
+ *        batch.computeBatch(activeColumns, learn);
+ *        <read batch.stream(i).getActiveCells(), etc.>
+ *     }
+ *
+ * All streams are stored in one contiguous container and advanced together by
+ * computeBatch, split across a pool of worker threads.  Streams never share
+ * any state, so the result of each stream is exactly what the same
+ * TemporalMemory, with the same seed, would compute on its own, regardless
+ * of the number of threads.
+ */
+class TemporalMemoryBatch {
+public:
+  /**
+   * @param numStreams Number of TemporalMemory instances in the batch.
+   * @param prototype Every stream starts as a copy of this TemporalMemory,
+   *        including its parameters and any learned state.  Stream 0 is an
+   *        exact copy, random generator included, so it continues where the
+   *        prototype left off.  Streams 1..numStreams-1 restart their random
+   *        generator from the prototype's seed + i, so that streams given
+   *        the same input still grow different synapses.
+   * @param numThreads Number of threads which run computeBatch.  Default 1.
+   */
+  TemporalMemoryBatch(UInt numStreams, const TemporalMemory &prototype,
+                      UInt numThreads = 1u);
+
+  /**
+   * Advances every stream by one time step, like calling
+   * stream(i).compute(activeColumns[i], learn) for each stream.
+   *
+   * @param activeColumns One SDR of active columns per stream.
+   * @param learn Whether or not learning is enabled.
+   */
+  void computeBatch(const std::vector<sdr::SDR> &activeColumns, bool learn = true);
+
+  /**
+   * Resets the sequence state of every stream, see TemporalMemory::reset.
+   */
+  void reset();
+
+  /**
+   * @returns the number of streams in the batch.
+   */
+  UInt size() const { return (UInt)streams_.size(); }
+
+  /**
+   * Access to a single stream, for reading its outputs or changing it alone.
+   */
+  TemporalMemory &stream(UInt index);
+  const TemporalMemory &stream(UInt index) const;
+
+  /**
+   * Number of threads used by computeBatch.
+   */
+  UInt getNumThreads() const { return pool_->size(); }
+  void setNumThreads(UInt numThreads);
+
+private:
+  std::vector<TemporalMemory> streams_;
+  std::unique_ptr<util::ThreadPool> pool_;
+};
+
+} // end namespace temporal_memory
+} // end namespace algorithms
+} // namespace nupic
+
+#endif // NTA_TEMPORAL_MEMORY_BATCH_HPP
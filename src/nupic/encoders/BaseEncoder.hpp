@@ -63,6 +63,23 @@ public:
 
     virtual void encode(DataType input, sdr::SDR &output) = 0;
 
+    /**
+     * Encode a contiguous array of values, inputs[i] into outputs[i].  The
+     * result is the same as calling encode for each value.  Subclasses can
+     * override this to share work between the values, the default encodes
+     * them one at a time.
+     *
+     * @param inputs  Array of count values.
+     * @param count   Number of values to encode.
+     * @param outputs Array of count SDRs, with the encoder's dimensions.
+     */
+    virtual void encodeBatch(const DataType inputs[], size_t count,
+                             sdr::SDR outputs[]) {
+        for(size_t i = 0; i < count; i++) {
+            encode( inputs[i], outputs[i] );
+        }
+    }
+
     virtual ~BaseEncoder() {}
 
 protected:
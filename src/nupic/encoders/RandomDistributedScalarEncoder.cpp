@@ -22,7 +22,7 @@
 #include <nupic/encoders/RandomDistributedScalarEncoder.hpp>
 #include <nupic/utils/MurmurHash3.hpp>
 #include <nupic/utils/Random.hpp>
-#include <algorithm> // fill
+#include <algorithm> // sort, unique
 
 using namespace std;
 using namespace nupic;
@@ -84,6 +84,33 @@ void RandomDistributedScalarEncoder::initialize( const RDSE_Parameters &paramete
   }
 }
 
+void RandomDistributedScalarEncoder::encodeBucket_(UInt bucket,
+                                                   sdr::SDR_sparse_t &sparse)
+{
+  // Hash all of the offsets from this bucket in one pass.
+  hashes_.resize( args_.activeBits );
+  MurmurHash3_x86_32_sequence( bucket, args_.activeBits, args_.seed, hashes_.data() );
+
+  sparse.resize( args_.activeBits );
+  for(auto offset = 0u; offset < args_.activeBits; ++offset) {
+    sparse[offset] = hashes_[offset] % size;
+  }
+
+  // Don't worry about hash collisions.  Instead measure the critical
+  // properties of the encoder in unit tests and quantify how significant
+  // the hash collisions are.  This encoder can not fix the collisions
+  // because it does not record past encodings.  Collisions cause small
+  // deviations in the sparsity or semantic similarity, depending on how
+  // they're handled.
+
+  // Exercise for the reader: Calculate the probability of a hash collision
+  // and account for it in the sparsity.
+
+  // Colliding bits are only set once.
+  sort( sparse.begin(), sparse.end() );
+  sparse.erase( unique( sparse.begin(), sparse.end() ), sparse.end() );
+}
+
 void RandomDistributedScalarEncoder::encode(Real64 input, sdr::SDR &output)
 {
   // Check inputs
@@ -93,29 +120,39 @@ void RandomDistributedScalarEncoder::encode(Real64 input, sdr::SDR &output)
     return;
   }
 
-  auto &data = output.getDense();
-  fill( data.begin(), data.end(), 0u );
-
-  const UInt index = (UInt) (input / args_.resolution);
-  for(auto offset = 0u; offset < args_.activeBits; ++offset)
-  {
-    UInt hash_buffer = index + offset;
-    UInt32 bucket = MurmurHash3_x86_32(&hash_buffer, sizeof(hash_buffer), args_.seed);
-    bucket = bucket % size;
-
-    // Don't worry about hash collisions.  Instead measure the critical
-    // properties of the encoder in unit tests and quantify how significant
-    // the hash collisions are.  This encoder can not fix the collisions
-    // because it does not record past encodings.  Collisions cause small
-    // deviations in the sparsity or semantic similarity, depending on how
-    // they're handled.
-
-    // Exercise for the reader: Calculate the probability of a hash collision
-    // and account for it in the sparsity.
+  auto &sparse = output.getSparse();
+  encodeBucket_( (UInt) (input / args_.resolution), sparse );
+  output.setSparseSorted( sparse );
+}
 
-    data[bucket] = 1u;
+void RandomDistributedScalarEncoder::encodeBatch(const Real64 inputs[],
+                                                 size_t count,
+                                                 sdr::SDR outputs[])
+{
+  const sdr::SDR *previous = nullptr;
+  UInt previousBucket = 0u;
+  for(size_t i = 0; i < count; i++) {
+    auto &output = outputs[i];
+    NTA_CHECK( output.size == size );
+    if( isnan(inputs[i]) ) {
+      output.zero();
+      previous = nullptr;
+      continue;
+    }
+
+    const UInt bucket = (UInt) (inputs[i] / args_.resolution);
+    auto &sparse = output.getSparse();
+    if( previous != nullptr && bucket == previousBucket ) {
+      const auto &data = previous->getSparse();
+      sparse.assign( data.begin(), data.end() );
+    }
+    else {
+      encodeBucket_( bucket, sparse );
+    }
+    output.setSparseSorted( sparse );
+    previous       = &output;
+    previousBucket = bucket;
   }
-  output.setDense( data );
 }
 
 void RandomDistributedScalarEncoder::save(std::ostream &stream) const
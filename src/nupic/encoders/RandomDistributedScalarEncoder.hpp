@@ -115,6 +115,13 @@ public:
 
   void encode(Real64 input, sdr::SDR &output) override;
 
+  /**
+   * Encodes many values.  Consecutive values which fall into the same bucket
+   * share one encoding, which is copied instead of hashed again.
+   */
+  void encodeBatch(const Real64 inputs[], size_t count,
+                   sdr::SDR outputs[]) override;
+
   void save(std::ostream &stream) const override;
   void load(std::istream &stream) override;
 
@@ -122,6 +129,10 @@ public:
 
 private:
   RDSE_Parameters args_;
+
+  // Writes the sorted active bits for the given bucket into sparse.
+  void encodeBucket_(UInt bucket, sdr::SDR_sparse_t &sparse);
+  std::vector<UInt32> hashes_;
 };
 
 typedef RandomDistributedScalarEncoder RDSE;
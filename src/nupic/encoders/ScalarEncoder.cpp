@@ -26,7 +26,7 @@
  * Implementation of the ScalarEncoder
  */
 
-#include <algorithm> // std::min
+#include <algorithm> // std::min, std::rotate
 #include <numeric>   // std::iota
 #include <cmath>     // std::isnan
 #include <nupic/encoders/ScalarEncoder.hpp>
@@ -152,13 +152,16 @@ void ScalarEncoder::encode(Real64 input, SDR &output)
 
   std::iota( sparse.begin(), sparse.end(), start );
 
-  if( parameters.periodic ) {
-    for(UInt wrap = output.size - start; wrap < parameters.activeBits; ++wrap) {
+  if( parameters.periodic && output.size - start < parameters.activeBits ) {
+    const UInt firstWrapped = output.size - start;
+    for(UInt wrap = firstWrapped; wrap < parameters.activeBits; ++wrap) {
       sparse[wrap] -= output.size;
     }
+    // Move the bits which wrapped around to the front, to keep them sorted.
+    std::rotate( sparse.begin(), sparse.begin() + firstWrapped, sparse.end() );
   }
 
-  output.setSparse( sparse );
+  output.setSparseSorted( sparse );
 }
 
 void ScalarEncoder::save(std::ostream &stream) const
@@ -26,6 +26,7 @@
  */
 
 #include <algorithm> //find
+#include <cstring>   // memcpy
 
 #include <nupic/engine/Input.hpp>
 #include <nupic/engine/Link.hpp>
@@ -321,6 +322,26 @@ void Input::initialize() {
   initialized_ = true;
 }
 
+void Input::aliasSources() {
+  if (!initialized_ || links_.size() < 2u || data_.getType() == NTA_BasicType_SDR)
+    return;
+  for (const auto &link : links_) {
+    Output &out = link->getSrc();
+    Array &outData = out.getData();
+    if (link->getPropagationDelay() != 0 || out.getNumLinks() != 1u ||
+        outData.getType() != data_.getType())
+      continue;
+    // Keep whatever the Output holds, for example after loading a network.
+    Array slice(data_.getType());
+    slice.setBuffer(data_, link->getDestOffset(), outData.getCount());
+    if (outData.getCount() > 0u && !slice.isInstance(outData)) {
+      std::memcpy(slice.getBuffer(), outData.getBuffer(),
+                  outData.getCount() * BasicType::getSize(outData.getType()));
+    }
+    outData = slice;
+  }
+}
+
 void Input::uninitialize() {
   if (!initialized_)
     return;
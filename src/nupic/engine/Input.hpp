@@ -189,6 +189,17 @@ public:
    */
   void initialize();
 
+  /**
+   * Called by Network.initialize() after initialize(), when fan-in aliasing
+   * is enabled.
+   *
+   * For fan-in, the buffers of the source Outputs become slices of this
+   * Input's buffer, so the source regions write their results in place and
+   * the links have nothing to copy.  Only done for links without delay,
+   * of the same type which is not SDR, from an Output with no other links.
+   */
+  void aliasSources();
+
   /**
    * Tells whether the Input is initialized.
    *
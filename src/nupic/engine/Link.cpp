@@ -23,6 +23,7 @@
 /** @file
  * Implementation of the Link class
  */
+#include <algorithm> // remove_if
 #include <cstring> // memcpy,memset
 #include <nupic/engine/Input.hpp>
 #include <nupic/engine/Link.hpp>
@@ -31,6 +32,7 @@
 #include <nupic/ntypes/Array.hpp>
 #include <nupic/ntypes/BasicType.hpp>
 #include <nupic/utils/Log.hpp>
+#include <nupic/utils/Trace.hpp>
 
 // By calling  LogItem::setLogLevel(LogLevel_Verbose)
 // you can enable the NTA_DEBUG macros below.
@@ -59,6 +61,7 @@ Link::Link(const std::string &linkType, const std::string &linkParams,
 
 Link::Link() {  // needed for deserialization
   destOffset_ = 0;
+  delayHead_ = 0;
   src_ = nullptr;
   dest_ = nullptr;
   initialized_ = false;
@@ -79,6 +82,7 @@ void Link::commonConstructorInit_(const std::string &linkType,
   destInputName_ = destInputName;
   propagationDelay_ = propagationDelay;
   destOffset_ = 0;
+  delayHead_ = 0;
   is_FanIn_ = false;
   src_ = nullptr;
   dest_ = nullptr;
@@ -114,12 +118,18 @@ void Link::initialize(size_t destinationOffset, bool is_FanIn) {
     // because the buffer size is not known prior to then.
     // front of queue will be the next value to be copied to the dest Input buffer.
     // back of queue will be the same as the current contents of source Output.
-    Array &output_buffer = src_->getData();
+    const Array &output_buffer = src_->getData();
+    propagationDelayBuffer_.reserve(propagationDelay_);
     for (size_t i = 0; i < (propagationDelay_); i++) {
-      Array delayedbuffer = output_buffer.copy();
+      Array delayedbuffer(output_buffer.getType());
+      if (output_buffer.getType() == NTA_BasicType_SDR)
+        delayedbuffer.allocateBuffer(output_buffer.getSDR().dimensions);
+      else
+        delayedbuffer.allocateBuffer(output_buffer.getCount());
       delayedbuffer.zeroBuffer();
       propagationDelayBuffer_.push_back(delayedbuffer);
     }
+    delayHead_ = 0;
   }
 
   initialized_ = true;
@@ -185,6 +195,7 @@ Input &Link::getDest() const {
 
 void Link::compute() {
   NTA_CHECK(initialized_);
+  util::TraceScope trace("link", "compute");
 
   if (propagationDelay_) {
     // A delayed link's queue buffer size should always be number of delays.
@@ -193,7 +204,7 @@ void Link::compute() {
 
   // Copy data from source to destination. For delayed links, will copy from
   // head of circular queue; otherwise directly from source.
-  const Array &src = propagationDelay_ ? propagationDelayBuffer_.front() : src_->getData();
+  const Array &src = propagationDelay_ ? propagationDelayBuffer_[delayHead_] : src_->getData();
   Array &dest = dest_->getData();
 
   NTA_DEBUG << "Link::compute: " << getMoniker() << "; copying to dest input"
@@ -207,6 +218,34 @@ void Link::compute() {
 
   if (src.getType() == dest.getType() && !is_FanIn_ && propagationDelay_==0) {
     dest = src;   // Performs a shallow copy. Data not copied but passed in shared_ptr.
+  } else if (src.getType() == dest.getType() && src.getType() != NTA_BasicType_SDR &&
+             src.getBuffer() == static_cast<const char *>(dest.getBuffer()) +
+                                    destOffset_ * BasicType::getSize(dest.getType())) {
+    // The source Output buffer is part of the destination Input buffer, see
+    // Input::aliasSources().  The data is already in place.
+  } else if (src.getType() == NTA_BasicType_SDR && dest.getType() == NTA_BasicType_SDR) {
+    // Only the active bits are copied.  The dense form of the destination is
+    // built later if the region asks for it.
+    const sdr::SDR_sparse_t &from = src.getSDR().getSparse();
+    sdr::SDR &to = dest.getSDR();
+    if (!is_FanIn_) {
+      to.setSparse(from);
+    } else {
+      // Replace the active bits in this link's slice of the destination.  The
+      // other slices may have been written by links of any type, so only the
+      // bits in [begin, end) belong to this link.
+      sdr::SDR_sparse_t &indices = to.getSparse();
+      const UInt begin = (UInt)destOffset_;
+      const UInt end = begin + (UInt)src.getCount();
+      indices.erase(std::remove_if(indices.begin(), indices.end(),
+                                   [begin, end](UInt index) {
+                                     return index >= begin && index < end;
+                                   }),
+                    indices.end());
+      for (const auto index : from)
+        indices.push_back(index + (UInt)destOffset_);
+      to.setSparse(indices);
+    }
   } else {
     // we must perform a deep copy with possible type conversion.
     // It is copied into the destination Input
@@ -218,17 +257,28 @@ void Link::compute() {
 
 void Link::shiftBufferedData() {
   if (propagationDelay_) {   // Source buffering is not used in 0-delay links
-    Array& from = src_->getData();
+    util::TraceScope trace("link", "shiftBufferedData");
+    const Array& from = src_->getData();
     NTA_CHECK(propagationDelayBuffer_.size() == (propagationDelay_));
 
-    // push a copy of the source Output buffer on the back of the queue.
-    // This must be a deep copy.
-    Array a = from.copy();
-    propagationDelayBuffer_.push_back(a);
+    // The head of the queue has been copied to the destination already, so
+    // its slot takes a deep copy of the source Output buffer, which is the
+    // back of the queue.
+    Array &slot = propagationDelayBuffer_[delayHead_];
+    if (from.getType() == NTA_BasicType_SDR && slot.getType() == NTA_BasicType_SDR &&
+        slot.getCount() == from.getCount()) {
+      // Copies only the active bits.
+      const sdr::SDR_sparse_t &sparse = from.getSDR().getSparse();
+      slot.getSDR().setSparse(sparse);
+    } else if (slot.getType() == from.getType() && slot.getCount() == from.getCount()) {
+      std::memcpy(slot.getBuffer(), from.getBuffer(),
+                  from.getCount() * BasicType::getSize(from.getType()));
+    } else {
+      slot = from.copy();
+    }
 
-    // Pop the head of the queue
-    // The top of the queue now becomes the value to copy to destination.
-    propagationDelayBuffer_.pop_front();
+    // The next slot now becomes the value to copy to destination.
+    delayHead_ = (delayHead_ + 1) % propagationDelay_;
   }
 }
 
@@ -257,12 +307,11 @@ void Link::serialize(std::ostream &f) {
     Array a = dest_->getData().subset(destOffset_, srcCount);
     a.save(f); // our part of the current Dest Input buffer.
 
-    std::deque<Array>::iterator itr;
-    for (auto itr = propagationDelayBuffer_.begin();
-         itr != propagationDelayBuffer_.end(); itr++) {
-      if (itr + 1 == propagationDelayBuffer_.end())
-        break; // skip the last buffer. Its the current output.
-      Array &buf = *itr;
+    // Walk the ring from the head, and skip the last buffer. Its the
+    // current output.
+    for (size_t i = 0; i + 1 < propagationDelayBuffer_.size(); i++) {
+      const Array &buf =
+          propagationDelayBuffer_[(delayHead_ + i) % propagationDelayBuffer_.size()];
       buf.save(f);
     } // end for
   }
@@ -354,11 +403,13 @@ void Link::deserialize(std::istream &f) {
             "link has " << count << " buffers in 'propagationDelayBuffer'. "
             << "Expecting " << propagationDelay << ".";
   Size idx = 0;
+  propagationDelayBuffer_.clear();
   for (; idx < count; idx++) {
     Array a;
     a.load(f);
     propagationDelayBuffer_.push_back(a);
   }
+  delayHead_ = 0;
   // To complete the restore, call r->prepareInputs() and then shiftBufferedData();
   // This is performed in Network class at the end of the load().
   f >> tag;
@@ -406,8 +457,9 @@ std::ostream &operator<<(std::ostream &f, const Link &link) {
     << "</propagationDelay>\n";
   if (link.getPropagationDelay() > 0) {
   	f <<   "   <propagationDelayBuffer>\n";
-	for (auto buf : link.propagationDelayBuffer_) {
-		f << buf << "\n";
+	const size_t slots = link.propagationDelayBuffer_.size();
+	for (size_t i = 0; i < slots; i++) {
+		f << link.propagationDelayBuffer_[(link.delayHead_ + i) % slots] << "\n";
 	}
 	f <<   "   </propagationDelayBuffer>\n";
   }
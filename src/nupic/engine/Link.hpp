@@ -28,7 +28,7 @@
 #define NTA_LINK_HPP
 
 #include <string>
-#include <deque>
+#include <vector>
 
 #include <nupic/ntypes/Array.hpp>
 #include <nupic/ntypes/Dimensions.hpp>
@@ -385,6 +385,15 @@ public:
    */
   size_t getPropagationDelay() const { return propagationDelay_; }
 
+  /**
+   * Get the offset into the destination Input buffer.  Non-zero only for
+   * fan-in, where the Input is the concatenation of its sources.
+   *
+   * @returns
+   *         The offset, in elements.
+   */
+  size_t getDestOffset() const { return destOffset_; }
+
   /**
    * @}
    *
@@ -435,6 +444,8 @@ public:
   /*
    * No-op for links without delay; for delayed links, remove head element of
    * the propagation delay buffer and push back the current value from source.
+   * The buffer is a ring, so this overwrites the head slot in place and
+   * advances the head, without allocating.
    *
    * NOTE It's intended that this method be called exactly once on all links
    * within a network at the end of every time step. Network::run calls it
@@ -517,8 +528,12 @@ private:
   size_t destOffset_;
   bool is_FanIn_;
 
-  // Queue buffer for delayed source data buffering
-  std::deque<Array> propagationDelayBuffer_;
+  // Ring buffer for delayed source data buffering, one slot per delay.
+  // The slot at delayHead_ is the next value to copy to the destination,
+  // the slot before it holds the most recent source value.  SDR slots only
+  // carry the sparse indices of the source.
+  std::vector<Array> propagationDelayBuffer_;
+  size_t delayHead_;
   // Number of delay slots
   size_t propagationDelay_;
 
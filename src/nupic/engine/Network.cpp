@@ -24,8 +24,12 @@
 Implementation of the Network class
 */
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
 #include <limits>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 
@@ -43,11 +47,78 @@ Implementation of the Network class
 #include <nupic/ntypes/BasicType.hpp>
 #include <nupic/utils/Log.hpp>
 #include <nupic/utils/StringUtils.hpp>
+#include <nupic/utils/Trace.hpp>
 
 namespace nupic {
 
 class RegisteredRegionImpl;
 
+namespace {
+
+// A region and its incoming links, in the order Region::prepareInputs()
+// computes them.
+struct Step {
+  Region *region;
+  std::string name; // of the region, for tracing
+  std::vector<Link *> links;
+};
+
+// The regions of one phase in serial order, and the pairs of regions which
+// must run in that order.  Used by the parallel executor in Network::run.
+struct PhaseSchedule {
+  std::vector<Step> steps;
+  std::vector<std::vector<size_t>> successors;
+  std::vector<size_t> numPredecessors;
+};
+
+Step buildStep(Region *r) {
+  Step step;
+  step.region = r;
+  step.name = r->getName();
+  for (const auto &inputTuple : r->getInputs()) {
+    for (const auto &pLink : inputTuple.second->getLinks()) {
+      step.links.push_back(pLink.get());
+    }
+  }
+  return step;
+}
+
+// Same as Region::prepareInputs() followed by Region::compute(), through
+// the links resolved in the plan.
+void runStep(const Step &step) {
+  {
+    util::TraceScope trace("region", "prepareInputs", step.name);
+    for (const auto pLink : step.links) {
+      pLink->compute();
+    }
+  }
+  step.region->compute();
+}
+
+} // namespace
+
+/*
+ * Everything run() needs, resolved once: no maps, sets or names are looked
+ * at while running.
+ */
+struct Network::ExecutionPlan {
+  // The plan is for these enabled phases and executor.
+  UInt32 minPhase;
+  UInt32 maxPhase;
+  bool parallel;
+
+  // Serial executor: the enabled regions in phase order.
+  std::vector<Step> steps;
+  // Serial executor: the links with a propagation delay.
+  std::vector<Link *> delayedLinks;
+
+  // Parallel executor: the dependencies within each phase, and the delayed
+  // links grouped by source output since copying an output may convert it in
+  // place.
+  std::vector<PhaseSchedule> schedules;
+  std::vector<std::vector<Link *>> delayedLinksBySource;
+};
+
 Network::Network() {
   commonInit();
   NuPIC::registerNetwork(this);
@@ -62,6 +133,7 @@ Network::Network(const std::string& filename) {
 
 void Network::commonInit() {
   initialized_ = false;
+  fanInAliasing_ = false;
   iteration_ = 0;
   minEnabledPhase_ = 0;
   maxEnabledPhase_ = 0;
@@ -193,6 +265,7 @@ void Network::setPhases_(Region *r, std::set<UInt32> &phases) {
   r->setPhases(phases);
 
   resetEnabledPhases_();
+  invalidatePlan_();
 }
 
 void Network::resetEnabledPhases_() {
@@ -262,6 +335,7 @@ void Network::removeRegion(const std::string &name) {
 
   // Region is deleted when the Shared_ptr goes out of scope.
   regions_.remove(name);
+  invalidatePlan_();
 
   return;
 }
@@ -311,6 +385,7 @@ void Network::link(const std::string &srcRegionName,
   // Create the link itself
   auto link = std::make_shared<Link>(linkType, linkParams, srcOutput, destInput, propagationDelay);
   destInput->addLink(link, srcOutput);
+  invalidatePlan_();
 }
 
 void Network::removeLink(const std::string &srcRegionName,
@@ -355,6 +430,124 @@ void Network::removeLink(const std::string &srcRegionName,
 
   // Finally, remove the link
   destInput->removeLink(link);
+  invalidatePlan_();
+}
+
+namespace {
+
+PhaseSchedule buildPhaseSchedule(const std::set<Region *> &phase) {
+  PhaseSchedule schedule;
+  for (auto r : phase) {
+    schedule.steps.push_back(buildStep(r));
+  }
+  const size_t numRegions = schedule.steps.size();
+
+  std::map<const Region *, size_t> index;
+  for (size_t i = 0; i < numRegions; i++) {
+    index[schedule.steps[i].region] = i;
+  }
+
+  // Region pairs (earlier, later) which may not run concurrently:
+  //  - a link without delay between them, since the destination reads the
+  //    output while the source computes it.
+  //  - links without delay from the same output into both, since reading an
+  //    output may convert it in place (e.g. an SDR filling its caches).
+  std::set<std::pair<size_t, size_t>> edges;
+  std::map<const Output *, std::vector<size_t>> readers;
+  for (size_t dst = 0; dst < numRegions; dst++) {
+    for (const auto pLink : schedule.steps[dst].links) {
+      if (pLink->getPropagationDelay() > 0)
+        continue;
+      const Output &src = pLink->getSrc();
+      readers[&src].push_back(dst);
+
+      const auto found = index.find(src.getRegion());
+      if (found != index.end() && found->second != dst) {
+        edges.insert(std::make_pair(std::min(found->second, dst),
+                                    std::max(found->second, dst)));
+      }
+    }
+  }
+  for (auto &outputReaders : readers) {
+    std::vector<size_t> &order = outputReaders.second;
+    std::sort(order.begin(), order.end());
+    order.erase(std::unique(order.begin(), order.end()), order.end());
+    for (size_t i = 1; i < order.size(); i++) {
+      edges.insert(std::make_pair(order[i - 1], order[i]));
+    }
+  }
+
+  schedule.successors.resize(numRegions);
+  schedule.numPredecessors.assign(numRegions, 0u);
+  for (const auto &edge : edges) {
+    schedule.successors[edge.first].push_back(edge.second);
+    schedule.numPredecessors[edge.second]++;
+  }
+  return schedule;
+}
+
+// Each thread takes the next region whose predecessors are all done from a
+// shared queue, until the whole phase is done or a region has thrown.
+void runPhaseSchedule(const PhaseSchedule &schedule, util::ThreadPool &pool) {
+  const size_t numRegions = schedule.steps.size();
+  std::vector<size_t> waitingFor(schedule.numPredecessors);
+  std::deque<size_t> ready;
+  for (size_t i = 0; i < numRegions; i++) {
+    if (waitingFor[i] == 0u)
+      ready.push_back(i);
+  }
+  size_t numDone = 0u;
+  bool failed = false;
+  std::mutex mutex;
+  std::condition_variable changed;
+
+  pool.parallelFor(pool.size(), [&](size_t, size_t, UInt) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      changed.wait(lock, [&] {
+        return !ready.empty() || numDone == numRegions || failed;
+      });
+      if (numDone == numRegions || failed)
+        return;
+      const size_t next = ready.front();
+      ready.pop_front();
+      lock.unlock();
+
+      try {
+        runStep(schedule.steps[next]);
+      } catch (...) {
+        lock.lock();
+        failed = true;
+        changed.notify_all();
+        throw;
+      }
+
+      lock.lock();
+      numDone++;
+      for (const size_t successor : schedule.successors[next]) {
+        if (--waitingFor[successor] == 0u)
+          ready.push_back(successor);
+      }
+      changed.notify_all();
+    }
+  });
+}
+
+} // namespace
+
+void Network::setNumThreads(UInt32 numThreads) {
+  NTA_CHECK(numThreads > 0u) << "numThreads must be at least 1.";
+  if (numThreads == getNumThreads())
+    return;
+  pool_.reset(numThreads > 1u ? new util::ThreadPool(numThreads) : nullptr);
+}
+
+UInt32 Network::getNumThreads() const {
+  return pool_ ? pool_->size() : 1u;
+}
+
+void Network::setFanInAliasing(bool enable) {
+  fanInAliasing_ = enable;
 }
 
 void Network::run(int n) {
@@ -368,14 +561,25 @@ void Network::run(int n) {
   NTA_CHECK(maxEnabledPhase_ < phaseInfo_.size())
       << "maxphase: " << maxEnabledPhase_ << " size: " << phaseInfo_.size();
 
+  compilePlan_();
+  const ExecutionPlan &plan = *plan_;
+
   for (int iter = 0; iter < n; iter++) {
+    util::TraceScope trace("network", "iteration");
     iteration_++;
 
     // compute on all enabled regions in phase order
-    for (UInt32 phase = minEnabledPhase_; phase <= maxEnabledPhase_; phase++) {
-      for (auto r : phaseInfo_[phase]) {
-        r->prepareInputs();
-        r->compute();
+    if (plan.parallel) {
+      for (const auto &schedule : plan.schedules) {
+        if (schedule.steps.size() == 1u) {
+          runStep(schedule.steps[0]);
+        } else {
+          runPhaseSchedule(schedule, *pool_);
+        }
+      }
+    } else {
+      for (const auto &step : plan.steps) {
+        runStep(step);
       }
     }
 
@@ -387,13 +591,18 @@ void Network::run(int n) {
 
     // Refresh all links in the network at the end of every timestamp so that
     // data in delayed links appears to change atomically between iterations
-    for (size_t i = 0; i < regions_.getCount(); i++) {
-      const std::shared_ptr<Region> r = regions_.getByIndex(i).second;
-
-      for (const auto &inputTuple : r->getInputs()) {
-        for (const auto pLink : inputTuple.second->getLinks()) {
-          pLink->shiftBufferedData();
+    if (plan.parallel) {
+      const auto &delayedLinks = plan.delayedLinksBySource;
+      pool_->parallelFor(delayedLinks.size(), [&](size_t begin, size_t end, UInt) {
+        for (size_t i = begin; i < end; i++) {
+          for (auto pLink : delayedLinks[i]) {
+            pLink->shiftBufferedData();
+          }
         }
+      });
+    } else {
+      for (const auto pLink : plan.delayedLinks) {
+        pLink->shiftBufferedData();
       }
     }
 
@@ -402,6 +611,55 @@ void Network::run(int n) {
   return;
 }
 
+void Network::compilePlan_() {
+  if (plan_ && plan_->minPhase == minEnabledPhase_ &&
+      plan_->maxPhase == maxEnabledPhase_ && plan_->parallel == (pool_ != nullptr))
+    return;
+
+  std::unique_ptr<ExecutionPlan> plan(new ExecutionPlan);
+  plan->minPhase = minEnabledPhase_;
+  plan->maxPhase = maxEnabledPhase_;
+  plan->parallel = (pool_ != nullptr);
+
+  if (phaseInfo_.empty()) {
+    // No regions, so nothing to run.
+  } else if (plan->parallel) {
+    for (UInt32 phase = minEnabledPhase_; phase <= maxEnabledPhase_; phase++) {
+      plan->schedules.push_back(buildPhaseSchedule(phaseInfo_[phase]));
+    }
+  } else {
+    for (UInt32 phase = minEnabledPhase_; phase <= maxEnabledPhase_; phase++) {
+      for (auto r : phaseInfo_[phase]) {
+        plan->steps.push_back(buildStep(r));
+      }
+    }
+  }
+
+  std::map<const Output *, std::vector<Link *>> linksBySource;
+  for (size_t i = 0; i < regions_.getCount(); i++) {
+    const std::shared_ptr<Region> r = regions_.getByIndex(i).second;
+    for (const auto &inputTuple : r->getInputs()) {
+      for (const auto &pLink : inputTuple.second->getLinks()) {
+        if (pLink->getPropagationDelay() == 0)
+          continue;
+        if (plan->parallel)
+          linksBySource[&pLink->getSrc()].push_back(pLink.get());
+        else
+          plan->delayedLinks.push_back(pLink.get());
+      }
+    }
+  }
+  for (auto &source : linksBySource) {
+    plan->delayedLinksBySource.push_back(std::move(source.second));
+  }
+
+  plan_ = std::move(plan);
+}
+
+void Network::invalidatePlan_() {
+  plan_.reset();
+}
+
 void Network::initialize() {
 
   /*
@@ -425,6 +683,19 @@ void Network::initialize() {
     r->evaluateLinks();
   }
 
+  /*
+   * 1b. Optionally let fan-in sources write directly into their inputs,
+   *     before the regions see their output buffers.
+   */
+  if (fanInAliasing_) {
+    for (size_t i = 0; i < regions_.getCount(); i++) {
+      std::shared_ptr<Region> r = regions_.getByIndex(i).second;
+      for (const auto &inputTuple : r->getInputs()) {
+        inputTuple.second->aliasSources();
+      }
+    }
+  }
+
 
   /*
    * 2. initialize region/impl
@@ -439,6 +710,12 @@ void Network::initialize() {
    */
   resetEnabledPhases_();
 
+  /*
+   * 4. Compile the execution plan for run()
+   */
+  invalidatePlan_();
+  compilePlan_();
+
   /*
    * Mark network as initialized.
    */
@@ -29,6 +29,7 @@
 
 #include <iostream>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -39,6 +40,7 @@
 
 #include <nupic/types/Serializable.hpp>
 #include <nupic/types/Types.hpp>
+#include <nupic/utils/ThreadPool.hpp>
 
 namespace nupic {
 
@@ -332,6 +334,50 @@ public:
    */
   void run(int n);
 
+  /**
+   * Set the number of threads used by run().  Default is 1.
+   *
+   * With more than one thread, regions of the same phase which do not depend
+   * on each other are computed concurrently.  Two regions of a phase are run
+   * one after the other, in the same order as with a single thread, when a
+   * link without propagation delay connects them, or when both read the same
+   * output through links without delay.  The buffers of delayed links are
+   * also shifted in parallel at the end of each iteration.  The results are
+   * identical to a single threaded run.
+   *
+   * All regions of the network must be safe to compute concurrently with
+   * other regions.  The built in C++ regions are; regions implemented in
+   * other languages should keep the default of 1 thread.
+   *
+   * @param numThreads Number of threads, including the calling thread.
+   */
+  void setNumThreads(UInt32 numThreads);
+
+  /**
+   * @returns the number of threads used by run().
+   */
+  UInt32 getNumThreads() const;
+
+  /**
+   * Let the sources of fan-in inputs write their outputs directly into the
+   * input buffer, so that no data is copied for those links.  Default is
+   * false.  Takes effect when the network is initialized.
+   *
+   * Only links without propagation delay, whose output and input have the
+   * same type which is not SDR, and whose output has no other links are
+   * aliased.  The source regions must write their results into the output
+   * buffer they were given, not replace it; links from outputs which were
+   * replaced fall back to copying.
+   *
+   * @param enable Whether to alias fan-in sources.
+   */
+  void setFanInAliasing(bool enable);
+
+  /**
+   * @returns whether fan-in sources are aliased into their inputs.
+   */
+  bool getFanInAliasing() const { return fanInAliasing_; }
+
   /**
    * The type of run callback function.
    *
@@ -366,6 +412,9 @@ public:
 
   /**
    * Start profiling for all regions of this network.
+   *
+   * The profile totals the time of each region.  For a timeline of every
+   * step, see util::Trace.
    */
   void enableProfiling();
 
@@ -422,6 +471,15 @@ private:
   // the network
   void resetEnabledPhases_();
 
+  // The flattened form of phaseInfo_ and of the links, which run() executes.
+  struct ExecutionPlan;
+
+  // Build plan_ for the enabled phases, unless it is up to date.
+  void compilePlan_();
+
+  // Whenever regions, links or phases change the plan is rebuilt.
+  void invalidatePlan_();
+
   bool initialized_;
   Collection<std::shared_ptr<Region>> regions_;
 
@@ -437,6 +495,14 @@ private:
 
   // number of elapsed iterations
   UInt64 iteration_;
+
+  // threads used by run(), or nullptr when running serially
+  std::unique_ptr<util::ThreadPool> pool_;
+
+  std::unique_ptr<ExecutionPlan> plan_;
+
+  // whether initialize() aliases fan-in sources into their inputs
+  bool fanInAliasing_;
 };
 
 } // namespace nupic
@@ -125,6 +125,12 @@ public:
    */
   bool hasOutgoingLinks();
 
+  /**
+   * @returns
+   *         The number of outgoing links
+   */
+  size_t getNumLinks() const { return links_.size(); }
+
   /**
    * Get the data of the output.
    * @returns
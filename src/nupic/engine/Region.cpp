@@ -41,6 +41,7 @@ Methods related to inputs and outputs are in Region_io.cpp
 #include <nupic/engine/RegionImplFactory.hpp>
 #include <nupic/engine/Spec.hpp>
 #include <nupic/utils/Log.hpp>
+#include <nupic/utils/Trace.hpp>
 #include <nupic/ntypes/BundleIO.hpp>
 #include <nupic/ntypes/Array.hpp>
 #include <nupic/ntypes/BasicType.hpp>
@@ -184,6 +185,7 @@ void Region::compute() {
   if (profilingEnabled_)
     computeTimer_.start();
 
+  util::TraceScope trace("region", "compute", name_);
   impl_->compute();
 
   if (profilingEnabled_)
@@ -553,6 +555,7 @@ const Array& Region::getInputData(const std::string &inputName) const {
 }
 
 void Region::prepareInputs() {
+  util::TraceScope trace("region", "prepareInputs", name_);
   // Ask each input to prepare itself
   for (InputMap::const_iterator i = inputs_.begin(); i != inputs_.end(); i++) {
     i->second->prepare();
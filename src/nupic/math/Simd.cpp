@@ -0,0 +1,429 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2019, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ----------------------------------------------------------------------
+ */
+
+
+/** @file
+ * Vectorized kernels with an instruction set chosen at runtime
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include <nupic/math/Simd.hpp>
+#include <nupic/utils/Log.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define NTA_SIMD_SSE2
+  #include <immintrin.h>
+  #if defined(__GNUC__) || defined(__clang__)
+    #define NTA_SIMD_AVX
+    #define NTA_TARGET_AVX __attribute__((target("avx")))
+  #elif defined(_MSC_VER)
+    #include <intrin.h>
+    #define NTA_SIMD_AVX
+    #define NTA_TARGET_AVX
+  #endif
+#endif
+
+using namespace nupic;
+using namespace nupic::math::simd;
+
+// The vector kernels compute min(hi, x) and max(lo, x) in this argument order
+// so that ties resolve exactly like std::min(x, hi) and std::max(x, lo).
+
+namespace {
+
+void addClampedScalar(Real32 *values, const Real32 *deltas, size_t n, Real32 lo, Real32 hi) {
+  for (size_t i = 0; i < n; i++) {
+    values[i] = std::max(std::min(values[i] + deltas[i], hi), lo);
+  }
+}
+
+void addClampedScalar(Real32 *values, Real32 delta, size_t n, Real32 lo, Real32 hi) {
+  for (size_t i = 0; i < n; i++) {
+    values[i] = std::max(std::min(values[i] + delta, hi), lo);
+  }
+}
+
+#ifdef NTA_SIMD_SSE2
+void addClampedSse2(Real32 *values, const Real32 *deltas, size_t n, Real32 lo, Real32 hi) {
+  const __m128 vlo = _mm_set1_ps(lo);
+  const __m128 vhi = _mm_set1_ps(hi);
+  size_t i = 0;
+  for (; i + 4u <= n; i += 4u) {
+    const __m128 sum = _mm_add_ps(_mm_loadu_ps(values + i), _mm_loadu_ps(deltas + i));
+    _mm_storeu_ps(values + i, _mm_max_ps(vlo, _mm_min_ps(vhi, sum)));
+  }
+  addClampedScalar(values + i, deltas + i, n - i, lo, hi);
+}
+
+void addClampedSse2(Real32 *values, Real32 delta, size_t n, Real32 lo, Real32 hi) {
+  const __m128 vlo = _mm_set1_ps(lo);
+  const __m128 vhi = _mm_set1_ps(hi);
+  const __m128 vdelta = _mm_set1_ps(delta);
+  size_t i = 0;
+  for (; i + 4u <= n; i += 4u) {
+    const __m128 sum = _mm_add_ps(_mm_loadu_ps(values + i), vdelta);
+    _mm_storeu_ps(values + i, _mm_max_ps(vlo, _mm_min_ps(vhi, sum)));
+  }
+  addClampedScalar(values + i, delta, n - i, lo, hi);
+}
+
+// Widen 16 Bytes into 8 Int16, with the sign of Byte, which depends on the
+// compiler.
+inline __m128i widenBytesLo(__m128i x) {
+  return std::numeric_limits<Byte>::is_signed
+      ? _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8)
+      : _mm_unpacklo_epi8(x, _mm_setzero_si128());
+}
+
+inline __m128i widenBytesHi(__m128i x) {
+  return std::numeric_limits<Byte>::is_signed
+      ? _mm_srai_epi16(_mm_unpackhi_epi8(x, x), 8)
+      : _mm_unpackhi_epi8(x, _mm_setzero_si128());
+}
+
+inline __m128 int16LoToReal32(__m128i x) {
+  return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+}
+
+inline __m128 int16HiToReal32(__m128i x) {
+  return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16));
+}
+
+void convertSse2(Real32 *to, const Byte *from, size_t n) {
+  size_t i = 0;
+  for (; i + 16u <= n; i += 16u) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(from + i));
+    const __m128i lo = widenBytesLo(bytes);
+    const __m128i hi = widenBytesHi(bytes);
+    _mm_storeu_ps(to + i,       int16LoToReal32(lo));
+    _mm_storeu_ps(to + i + 4u,  int16HiToReal32(lo));
+    _mm_storeu_ps(to + i + 8u,  int16LoToReal32(hi));
+    _mm_storeu_ps(to + i + 12u, int16HiToReal32(hi));
+  }
+  convertScalar(to + i, from + i, n - i);
+}
+
+void convertSse2(Real32 *to, const Int32 *from, size_t n) {
+  size_t i = 0;
+  for (; i + 4u <= n; i += 4u) {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(from + i));
+    _mm_storeu_ps(to + i, _mm_cvtepi32_ps(x));
+  }
+  convertScalar(to + i, from + i, n - i);
+}
+
+void convertSse2(Real64 *to, const Real32 *from, size_t n) {
+  size_t i = 0;
+  for (; i + 4u <= n; i += 4u) {
+    const __m128 x = _mm_loadu_ps(from + i);
+    _mm_storeu_pd(to + i,      _mm_cvtps_pd(x));
+    _mm_storeu_pd(to + i + 2u, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+  }
+  convertScalar(to + i, from + i, n - i);
+}
+
+void convertSse2(Real32 *to, const Real64 *from, size_t n) {
+  size_t i = 0;
+  for (; i + 4u <= n; i += 4u) {
+    const __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(from + i));
+    const __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(from + i + 2u));
+    _mm_storeu_ps(to + i, _mm_movelh_ps(lo, hi));
+  }
+  convertScalar(to + i, from + i, n - i);
+}
+
+bool inRangeSse2(const Real32 *values, size_t n, Real32 lo, Real32 hi) {
+  const __m128 vlo = _mm_set1_ps(lo);
+  const __m128 vhi = _mm_set1_ps(hi);
+  __m128 ok = _mm_cmpeq_ps(vlo, vlo);
+  size_t i = 0;
+  for (; i + 4u <= n; i += 4u) {
+    const __m128 x = _mm_loadu_ps(values + i);
+    ok = _mm_and_ps(ok, _mm_and_ps(_mm_cmpge_ps(x, vlo), _mm_cmple_ps(x, vhi)));
+  }
+  return _mm_movemask_ps(ok) == 0xF && inRangeScalar(values + i, n - i, lo, hi);
+}
+
+bool inRangeSse2(const Real64 *values, size_t n, Real64 lo, Real64 hi) {
+  const __m128d vlo = _mm_set1_pd(lo);
+  const __m128d vhi = _mm_set1_pd(hi);
+  __m128d ok = _mm_cmpeq_pd(vlo, vlo);
+  size_t i = 0;
+  for (; i + 2u <= n; i += 2u) {
+    const __m128d x = _mm_loadu_pd(values + i);
+    ok = _mm_and_pd(ok, _mm_and_pd(_mm_cmpge_pd(x, vlo), _mm_cmple_pd(x, vhi)));
+  }
+  return _mm_movemask_pd(ok) == 0x3 && inRangeScalar(values + i, n - i, lo, hi);
+}
+#endif
+
+#ifdef NTA_SIMD_AVX
+NTA_TARGET_AVX
+void addClampedAvx(Real32 *values, const Real32 *deltas, size_t n, Real32 lo, Real32 hi) {
+  const __m256 vlo = _mm256_set1_ps(lo);
+  const __m256 vhi = _mm256_set1_ps(hi);
+  size_t i = 0;
+  for (; i + 8u <= n; i += 8u) {
+    const __m256 sum = _mm256_add_ps(_mm256_loadu_ps(values + i), _mm256_loadu_ps(deltas + i));
+    _mm256_storeu_ps(values + i, _mm256_max_ps(vlo, _mm256_min_ps(vhi, sum)));
+  }
+  addClampedScalar(values + i, deltas + i, n - i, lo, hi);
+}
+
+NTA_TARGET_AVX
+void addClampedAvx(Real32 *values, Real32 delta, size_t n, Real32 lo, Real32 hi) {
+  const __m256 vlo = _mm256_set1_ps(lo);
+  const __m256 vhi = _mm256_set1_ps(hi);
+  const __m256 vdelta = _mm256_set1_ps(delta);
+  size_t i = 0;
+  for (; i + 8u <= n; i += 8u) {
+    const __m256 sum = _mm256_add_ps(_mm256_loadu_ps(values + i), vdelta);
+    _mm256_storeu_ps(values + i, _mm256_max_ps(vlo, _mm256_min_ps(vhi, sum)));
+  }
+  addClampedScalar(values + i, delta, n - i, lo, hi);
+}
+
+// AVX has no 256 bit integer instructions, Byte conversion uses SSE2.
+
+NTA_TARGET_AVX
+void convertAvx(Real32 *to, const Int32 *from, size_t n) {
+  size_t i = 0;
+  for (; i + 8u <= n; i += 8u) {
+    const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(from + i));
+    _mm256_storeu_ps(to + i, _mm256_cvtepi32_ps(x));
+  }
+  convertScalar(to + i, from + i, n - i);
+}
+
+NTA_TARGET_AVX
+void convertAvx(Real64 *to, const Real32 *from, size_t n) {
+  size_t i = 0;
+  for (; i + 8u <= n; i += 8u) {
+    _mm256_storeu_pd(to + i,      _mm256_cvtps_pd(_mm_loadu_ps(from + i)));
+    _mm256_storeu_pd(to + i + 4u, _mm256_cvtps_pd(_mm_loadu_ps(from + i + 4u)));
+  }
+  convertScalar(to + i, from + i, n - i);
+}
+
+NTA_TARGET_AVX
+void convertAvx(Real32 *to, const Real64 *from, size_t n) {
+  size_t i = 0;
+  for (; i + 8u <= n; i += 8u) {
+    _mm_storeu_ps(to + i,      _mm256_cvtpd_ps(_mm256_loadu_pd(from + i)));
+    _mm_storeu_ps(to + i + 4u, _mm256_cvtpd_ps(_mm256_loadu_pd(from + i + 4u)));
+  }
+  convertScalar(to + i, from + i, n - i);
+}
+
+NTA_TARGET_AVX
+bool inRangeAvx(const Real32 *values, size_t n, Real32 lo, Real32 hi) {
+  const __m256 vlo = _mm256_set1_ps(lo);
+  const __m256 vhi = _mm256_set1_ps(hi);
+  __m256 ok = _mm256_cmp_ps(vlo, vlo, _CMP_EQ_OQ);
+  size_t i = 0;
+  for (; i + 8u <= n; i += 8u) {
+    const __m256 x = _mm256_loadu_ps(values + i);
+    ok = _mm256_and_ps(ok, _mm256_and_ps(_mm256_cmp_ps(x, vlo, _CMP_GE_OQ),
+                                         _mm256_cmp_ps(x, vhi, _CMP_LE_OQ)));
+  }
+  return _mm256_movemask_ps(ok) == 0xFF && inRangeScalar(values + i, n - i, lo, hi);
+}
+
+NTA_TARGET_AVX
+bool inRangeAvx(const Real64 *values, size_t n, Real64 lo, Real64 hi) {
+  const __m256d vlo = _mm256_set1_pd(lo);
+  const __m256d vhi = _mm256_set1_pd(hi);
+  __m256d ok = _mm256_cmp_pd(vlo, vlo, _CMP_EQ_OQ);
+  size_t i = 0;
+  for (; i + 4u <= n; i += 4u) {
+    const __m256d x = _mm256_loadu_pd(values + i);
+    ok = _mm256_and_pd(ok, _mm256_and_pd(_mm256_cmp_pd(x, vlo, _CMP_GE_OQ),
+                                         _mm256_cmp_pd(x, vhi, _CMP_LE_OQ)));
+  }
+  return _mm256_movemask_pd(ok) == 0xF && inRangeScalar(values + i, n - i, lo, hi);
+}
+
+bool cpuHasAvx() {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx");
+#else
+  // CPUID.1:ECX.AVX[bit 28] and OSXSAVE[bit 27], and the OS saves YMM state.
+  int info[4];
+  __cpuid(info, 1);
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  const bool avx     = (info[2] & (1 << 28)) != 0;
+  return osxsave && avx && (_xgetbv(0) & 0x6u) == 0x6u;
+#endif
+}
+#endif
+
+Isa detect() {
+#ifdef NTA_SIMD_AVX
+  if (cpuHasAvx())
+    return Isa::AVX;
+#endif
+#ifdef NTA_SIMD_SSE2
+  return Isa::SSE2;
+#else
+  return Isa::SCALAR;
+#endif
+}
+
+} // namespace
+
+
+Isa nupic::math::simd::best() {
+  static const Isa isa = detect();
+  return isa;
+}
+
+
+bool nupic::math::simd::supported(Isa isa) {
+  return static_cast<int>(isa) <= static_cast<int>(best());
+}
+
+
+const char *nupic::math::simd::name(Isa isa) {
+  switch (isa) {
+    case Isa::SCALAR: return "scalar";
+    case Isa::SSE2:   return "sse2";
+    case Isa::AVX:    return "avx";
+  }
+  return "unknown";
+}
+
+
+void nupic::math::simd::addClamped(Real32 *values, const Real32 *deltas, size_t n,
+                                   Real32 lo, Real32 hi, Isa isa) {
+  NTA_ASSERT(supported(isa)) << "Instruction set not supported: " << name(isa);
+  switch (isa) {
+#ifdef NTA_SIMD_AVX
+    case Isa::AVX:  addClampedAvx(values, deltas, n, lo, hi);  return;
+#endif
+#ifdef NTA_SIMD_SSE2
+    case Isa::SSE2: addClampedSse2(values, deltas, n, lo, hi); return;
+#endif
+    default:        addClampedScalar(values, deltas, n, lo, hi);
+  }
+}
+
+
+void nupic::math::simd::addClamped(Real32 *values, Real32 delta, size_t n,
+                                   Real32 lo, Real32 hi, Isa isa) {
+  NTA_ASSERT(supported(isa)) << "Instruction set not supported: " << name(isa);
+  switch (isa) {
+#ifdef NTA_SIMD_AVX
+    case Isa::AVX:  addClampedAvx(values, delta, n, lo, hi);  return;
+#endif
+#ifdef NTA_SIMD_SSE2
+    case Isa::SSE2: addClampedSse2(values, delta, n, lo, hi); return;
+#endif
+    default:        addClampedScalar(values, delta, n, lo, hi);
+  }
+}
+
+
+void nupic::math::simd::convert(Real32 *to, const Byte *from, size_t n, Isa isa) {
+  NTA_ASSERT(supported(isa)) << "Instruction set not supported: " << name(isa);
+  switch (isa) {
+#ifdef NTA_SIMD_SSE2
+    case Isa::AVX:
+    case Isa::SSE2: convertSse2(to, from, n); return;
+#endif
+    default:        convertScalar(to, from, n);
+  }
+}
+
+
+void nupic::math::simd::convert(Real32 *to, const Int32 *from, size_t n, Isa isa) {
+  NTA_ASSERT(supported(isa)) << "Instruction set not supported: " << name(isa);
+  switch (isa) {
+#ifdef NTA_SIMD_AVX
+    case Isa::AVX:  convertAvx(to, from, n);  return;
+#endif
+#ifdef NTA_SIMD_SSE2
+    case Isa::SSE2: convertSse2(to, from, n); return;
+#endif
+    default:        convertScalar(to, from, n);
+  }
+}
+
+
+void nupic::math::simd::convert(Real64 *to, const Real32 *from, size_t n, Isa isa) {
+  NTA_ASSERT(supported(isa)) << "Instruction set not supported: " << name(isa);
+  switch (isa) {
+#ifdef NTA_SIMD_AVX
+    case Isa::AVX:  convertAvx(to, from, n);  return;
+#endif
+#ifdef NTA_SIMD_SSE2
+    case Isa::SSE2: convertSse2(to, from, n); return;
+#endif
+    default:        convertScalar(to, from, n);
+  }
+}
+
+
+void nupic::math::simd::convert(Real32 *to, const Real64 *from, size_t n, Isa isa) {
+  NTA_ASSERT(supported(isa)) << "Instruction set not supported: " << name(isa);
+  switch (isa) {
+#ifdef NTA_SIMD_AVX
+    case Isa::AVX:  convertAvx(to, from, n);  return;
+#endif
+#ifdef NTA_SIMD_SSE2
+    case Isa::SSE2: convertSse2(to, from, n); return;
+#endif
+    default:        convertScalar(to, from, n);
+  }
+}
+
+
+bool nupic::math::simd::inRange(const Real32 *values, size_t n, Real32 lo, Real32 hi,
+                                Isa isa) {
+  NTA_ASSERT(supported(isa)) << "Instruction set not supported: " << name(isa);
+  switch (isa) {
+#ifdef NTA_SIMD_AVX
+    case Isa::AVX:  return inRangeAvx(values, n, lo, hi);
+#endif
+#ifdef NTA_SIMD_SSE2
+    case Isa::SSE2: return inRangeSse2(values, n, lo, hi);
+#endif
+    default:        return inRangeScalar(values, n, lo, hi);
+  }
+}
+
+
+bool nupic::math::simd::inRange(const Real64 *values, size_t n, Real64 lo, Real64 hi,
+                                Isa isa) {
+  NTA_ASSERT(supported(isa)) << "Instruction set not supported: " << name(isa);
+  switch (isa) {
+#ifdef NTA_SIMD_AVX
+    case Isa::AVX:  return inRangeAvx(values, n, lo, hi);
+#endif
+#ifdef NTA_SIMD_SSE2
+    case Isa::SSE2: return inRangeSse2(values, n, lo, hi);
+#endif
+    default:        return inRangeScalar(values, n, lo, hi);
+  }
+}
@@ -0,0 +1,126 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2019, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ----------------------------------------------------------------------
+ */
+
+
+/** @file
+ * Vectorized kernels with an instruction set chosen at runtime
+ */
+
+#ifndef NTA_SIMD_HPP
+#define NTA_SIMD_HPP
+
+#include <cstddef>
+
+#include <nupic/types/Types.hpp>
+
+namespace nupic {
+namespace math {
+namespace simd {
+
+/**
+ * Instruction sets the kernels are implemented for.  The best one supported
+ * by both the build and the CPU is detected once and used by default.  All
+ * implementations give bit identical results.
+ */
+enum class Isa { SCALAR, SSE2, AVX };
+
+/**
+ * @returns the best instruction set supported by this build and CPU.
+ */
+Isa best();
+
+/**
+ * @returns whether this build and CPU support the instruction set.
+ */
+bool supported(Isa isa);
+
+/**
+ * @returns the name of the instruction set, e.g. "avx".
+ */
+const char *name(Isa isa);
+
+/**
+ * For i in [0, n): values[i] = max(min(values[i] + deltas[i], hi), lo)
+ */
+void addClamped(Real32 *values, const Real32 *deltas, size_t n,
+                Real32 lo, Real32 hi, Isa isa = best());
+
+/**
+ * For i in [0, n): values[i] = max(min(values[i] + delta, hi), lo)
+ */
+void addClamped(Real32 *values, Real32 delta, size_t n,
+                Real32 lo, Real32 hi, Isa isa = best());
+
+/**
+ * Plain loops, used by the kernels for their tails and by convert and
+ * inRange for the types which have no kernel.
+ */
+template <typename To, typename From>
+void convertScalar(To *to, const From *from, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    to[i] = static_cast<To>(from[i]);
+  }
+}
+
+template <typename T>
+bool inRangeScalar(const T *values, size_t n, T lo, T hi) {
+  // No early exit, so that the loop has no branches.
+  bool ok = true;
+  for (size_t i = 0; i < n; i++) {
+    ok &= (values[i] >= lo) & (values[i] <= hi);
+  }
+  return ok;
+}
+
+/**
+ * For i in [0, n): to[i] = static_cast<To>(from[i])
+ *
+ * Real64 to Real32 rounds to nearest.  Values are not range checked, see
+ * inRange.  The overloads below have kernels, other types use convertScalar.
+ */
+template <typename To, typename From>
+void convert(To *to, const From *from, size_t n, Isa = best()) {
+  convertScalar(to, from, n);
+}
+void convert(Real32 *to, const Byte *from, size_t n, Isa isa = best());
+void convert(Real32 *to, const Int32 *from, size_t n, Isa isa = best());
+void convert(Real64 *to, const Real32 *from, size_t n, Isa isa = best());
+void convert(Real32 *to, const Real64 *from, size_t n, Isa isa = best());
+
+/**
+ * @returns whether lo <= values[i] <= hi for all i in [0, n).  NaN is out of
+ * range.  The Real32 and Real64 overloads have kernels.
+ */
+template <typename T>
+bool inRange(const T *values, size_t n, T lo, T hi, Isa = best()) {
+  return inRangeScalar(values, n, lo, hi);
+}
+bool inRange(const Real32 *values, size_t n, Real32 lo, Real32 hi,
+             Isa isa = best());
+bool inRange(const Real64 *values, size_t n, Real64 lo, Real64 hi,
+             Isa isa = best());
+
+} // end namespace simd
+} // end namespace math
+} // end namespace nupic
+
+#endif // NTA_SIMD_HPP
@@ -65,6 +65,177 @@ UInt indexFromCoordinates(const vector<UInt> &coordinates,
   return index;
 }
 
+NeighborhoodTable::NeighborhoodTable(UInt radius,
+                                     const vector<UInt> &dimensions,
+                                     bool wrapAround) {
+  update(radius, dimensions, wrapAround);
+}
+
+void NeighborhoodTable::update(UInt radius, const vector<UInt> &dimensions,
+                               bool wrapAround) {
+  if (!begin_.empty() && radius == radius_ && dimensions == dimensions_ &&
+      wrapAround == wrapAround_) {
+    return;
+  }
+  radius_ = radius;
+  dimensions_ = dimensions;
+  wrapAround_ = wrapAround;
+
+  start_.clear();
+  begin_.clear();
+  neighbors_.clear();
+  UInt stride = 1u;
+  for (const auto dim : dimensions) {
+    stride *= dim;
+  }
+  for (const UInt n : dimensions) {
+    NTA_ASSERT(n > 0u);
+    stride /= n;
+    start_.push_back((UInt)begin_.size());
+    // The same offsets as the Neighborhood iterators walk, in the same order.
+    for (UInt c = 0; c < n; c++) {
+      begin_.push_back((UInt)neighbors_.size());
+      if (wrapAround) {
+        const UInt width = (UInt)std::min<UInt64>(2ull * radius + 1u, n);
+        const UInt first = (c + n - radius % n) % n;
+        for (UInt k = 0; k < width; k++) {
+          neighbors_.push_back(((first + k) % n) * stride);
+        }
+      } else {
+        const UInt first = c > radius ? c - radius : 0u;
+        const UInt last = (UInt)std::min<UInt64>((UInt64)c + radius, n - 1u);
+        for (UInt k = first; k <= last; k++) {
+          neighbors_.push_back(k * stride);
+        }
+      }
+    }
+  }
+  begin_.push_back((UInt)neighbors_.size());
+}
+
+UInt NeighborhoodTable::size(UInt centerIndex) const {
+  UInt count = 1u;
+  for (size_t d = dimensions_.size(); d-- > 0u;) {
+    const UInt entry = start_[d] + centerIndex % dimensions_[d];
+    centerIndex /= dimensions_[d];
+    count *= begin_[entry + 1u] - begin_[entry];
+  }
+  return count;
+}
+
+namespace {
+
+// Reduces the neighborhood of every point, one dimension at a time. Along a
+// dimension each line of points is copied into a buffer, where the window of
+// position c is [first[c], last[c]]. When wrapping, the line is padded with
+// its own start so that every window is contiguous. The reduction is given
+// the buffer and the windows, and must fill one output per position.
+template <typename Reduction>
+void reduceNeighborhoods_(const vector<Real> &values, UInt radius,
+                          const vector<UInt> &dimensions, bool wrapAround,
+                          vector<Real> &result, Reduction reduce) {
+  size_t size = 1;
+  for (const auto dim : dimensions) {
+    size *= dim;
+  }
+  NTA_ASSERT(values.size() == size);
+
+  vector<Real64> data(values.begin(), values.end());
+  vector<Real64> line;
+  vector<Real64> out;
+  vector<UInt> first;
+  vector<UInt> last;
+  size_t stride = size;
+  for (const UInt n : dimensions) {
+    stride /= n;
+    const UInt width = (UInt)std::min<UInt64>(2ull * radius + 1u, n);
+    const UInt pad = wrapAround ? width - 1u : 0u;
+    const UInt shift = n - radius % n; // Padded position 0 is coordinate -radius.
+    first.resize(n);
+    last.resize(n);
+    for (UInt c = 0; c < n; c++) {
+      if (wrapAround) {
+        first[c] = c;
+        last[c] = c + width - 1u;
+      } else {
+        first[c] = c > radius ? c - radius : 0u;
+        last[c] = (UInt)std::min<UInt64>((UInt64)c + radius, n - 1u);
+      }
+    }
+    line.resize(n + pad);
+    out.resize(n);
+
+    for (size_t outer = 0; outer < size; outer += n * stride) {
+      for (size_t inner = 0; inner < stride; inner++) {
+        Real64 *x = data.data() + outer + inner;
+        for (UInt k = 0; k < n + pad; k++) {
+          line[k] = x[(wrapAround ? (k + shift) % n : k) * stride];
+        }
+        reduce(line, first, last, out);
+        for (UInt c = 0; c < n; c++) {
+          x[c * stride] = out[c];
+        }
+      }
+    }
+  }
+
+  result.resize(size);
+  for (size_t i = 0; i < size; i++) {
+    result[i] = (Real)data[i];
+  }
+}
+
+} // end anonymous namespace
+
+void neighborhoodMax(const vector<Real> &values, UInt radius,
+                     const vector<UInt> &dimensions, bool wrapAround,
+                     vector<Real> &result) {
+  // Monotonic queue: the positions in the window whose values are decreasing,
+  // so the front of the queue is the max of the window.
+  vector<UInt> queue;
+  reduceNeighborhoods_(values, radius, dimensions, wrapAround, result,
+    [&](const vector<Real64> &line, const vector<UInt> &first,
+        const vector<UInt> &last, vector<Real64> &out) {
+      queue.resize(line.size());
+      size_t head = 0;
+      size_t tail = 0;
+      UInt next = 0;
+      for (size_t c = 0; c < out.size(); c++) {
+        for (; next <= last[c]; next++) {
+          while (tail > head && line[queue[tail - 1]] <= line[next]) {
+            tail--;
+          }
+          queue[tail++] = next;
+        }
+        while (queue[head] < first[c]) {
+          head++;
+        }
+        out[c] = line[queue[head]];
+      }
+    });
+}
+
+void neighborhoodMean(const vector<Real> &values, UInt radius,
+                      const vector<UInt> &dimensions, bool wrapAround,
+                      vector<Real> &result) {
+  // The neighborhoods are boxes, so the mean over a box is the mean along the
+  // first dimension of the means along the others.
+  vector<Real64> prefix;
+  reduceNeighborhoods_(values, radius, dimensions, wrapAround, result,
+    [&](const vector<Real64> &line, const vector<UInt> &first,
+        const vector<UInt> &last, vector<Real64> &out) {
+      prefix.resize(line.size() + 1u);
+      prefix[0] = 0.0;
+      for (size_t k = 0; k < line.size(); k++) {
+        prefix[k + 1] = prefix[k] + line[k];
+      }
+      for (size_t c = 0; c < out.size(); c++) {
+        out[c] = (prefix[last[c] + 1u] - prefix[first[c]]) /
+                 (last[c] - first[c] + 1u);
+      }
+    });
+}
+
 } // end namespace topology
 } // namespace math
 } // end namespace nupic
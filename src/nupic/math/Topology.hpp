@@ -203,6 +203,172 @@ private:
   const UInt radius_;
 };
 
+/**
+ * Precomputed neighborhoods for a fixed radius, coordinate system and
+ * wrap-around.
+ *
+ * Usage:
+ *   NeighborhoodTable table(10, {100, 100}, false);
+ *   table.forEach(42, [&](UInt neighbor) {
+ *     // Same points, in the same order, as Neighborhood(42, 10, {100, 100})
+ *   });
+ *
+ * A neighborhood is the product of one range of coordinates per dimension.
+ * The table stores, for every coordinate along every dimension, the list of
+ * neighboring coordinates already truncated or wrapped and multiplied by the
+ * dimension's stride. Visiting a neighborhood is then a nested loop which adds
+ * up one entry per dimension. For 1, 2 and 3 dimensions the loops are
+ * unrolled at compile time and use no heap memory.
+ *
+ * The table takes O(sum(dimensions) * (2 * radius + 1)) memory.
+ */
+class NeighborhoodTable {
+public:
+  NeighborhoodTable() = default;
+  NeighborhoodTable(UInt radius, const std::vector<UInt> &dimensions,
+                    bool wrapAround);
+
+  /**
+   * Rebuild the table, unless it was already built with these arguments.
+   */
+  void update(UInt radius, const std::vector<UInt> &dimensions,
+              bool wrapAround);
+
+  /**
+   * Call visit(UInt neighbor) for every point in the neighborhood of
+   * centerIndex, including centerIndex itself.  Safe to call from several
+   * threads at once.
+   */
+  template <typename Visitor>
+  void forEach(UInt centerIndex, Visitor &&visit) const {
+    switch (dimensions_.size()) {
+    case 1: forEachFixed_<1>(centerIndex, visit); break;
+    case 2: forEachFixed_<2>(centerIndex, visit); break;
+    case 3: forEachFixed_<3>(centerIndex, visit); break;
+    default: forEachND_(centerIndex, visit); break;
+    }
+  }
+
+  /**
+   * The number of points in the neighborhood of centerIndex.
+   */
+  UInt size(UInt centerIndex) const;
+
+private:
+  // Nested loop over the dimensions [Dim, D).
+  template <UInt Dim, UInt D> struct Walk {
+    template <typename Visitor>
+    static void run(const UInt *const *first, const UInt *const *last,
+                    UInt base, Visitor &visit) {
+      for (const UInt *p = first[Dim]; p != last[Dim]; ++p) {
+        Walk<Dim + 1u, D>::run(first, last, base + *p, visit);
+      }
+    }
+  };
+  template <UInt D> struct Walk<D, D> {
+    template <typename Visitor>
+    static void run(const UInt *const *, const UInt *const *, UInt base,
+                    Visitor &visit) {
+      visit(base);
+    }
+  };
+
+  template <UInt D, typename Visitor>
+  void forEachFixed_(UInt centerIndex, Visitor &visit) const {
+    const UInt *first[D];
+    const UInt *last[D];
+    for (UInt d = D; d-- > 0u;) {
+      const UInt coordinate = centerIndex % dimensions_[d];
+      centerIndex /= dimensions_[d];
+      const UInt entry = start_[d] + coordinate;
+      first[d] = neighbors_.data() + begin_[entry];
+      last[d] = neighbors_.data() + begin_[entry + 1u];
+    }
+    Walk<0u, D>::run(first, last, 0u, visit);
+  }
+
+  template <typename Visitor>
+  void forEachND_(UInt centerIndex, Visitor &visit) const {
+    const size_t numDimensions = dimensions_.size();
+    std::vector<const UInt *> first(numDimensions);
+    std::vector<const UInt *> last(numDimensions);
+    for (size_t d = numDimensions; d-- > 0u;) {
+      const UInt coordinate = centerIndex % dimensions_[d];
+      centerIndex /= dimensions_[d];
+      const UInt entry = start_[d] + coordinate;
+      first[d] = neighbors_.data() + begin_[entry];
+      last[d] = neighbors_.data() + begin_[entry + 1u];
+    }
+    // Count like an odometer, the last dimension moves fastest.
+    std::vector<const UInt *> position(first);
+    while (true) {
+      UInt index = 0u;
+      for (size_t d = 0; d < numDimensions; d++) {
+        index += *position[d];
+      }
+      visit(index);
+      size_t d = numDimensions;
+      while (d-- > 0u) {
+        if (++position[d] != last[d]) {
+          break;
+        }
+        position[d] = first[d];
+      }
+      if (d == (size_t)-1) {
+        return;
+      }
+    }
+  }
+
+  UInt radius_ = 0u;
+  std::vector<UInt> dimensions_;
+  bool wrapAround_ = false;
+  // The entries of dimension d start at start_[d]. Entry e, for a coordinate
+  // along that dimension, lists neighbors_[begin_[e] .. begin_[e + 1]).
+  std::vector<UInt> start_;
+  std::vector<UInt> begin_;
+  std::vector<UInt> neighbors_;
+};
+
+/**
+ * Compute the maximum value within the neighborhood of every point.
+ *
+ * This gives the same result as taking the max over a Neighborhood (or a
+ * WrappingNeighborhood) of each point, but the neighborhood is a box, so the
+ * max is taken one dimension at a time with a sliding window. The cost is
+ * O(values.size() * dimensions.size()), independent of the radius.
+ *
+ * @param values
+ * One value per point, indexed the same way as the Neighborhood indices.
+ *
+ * @param radius
+ * The radius of the neighborhoods.
+ *
+ * @param dimensions
+ * The coordinate system.
+ *
+ * @param wrapAround
+ * Whether the neighborhoods wrap around the edges, like
+ * WrappingNeighborhood, or are truncated, like Neighborhood.
+ *
+ * @param result
+ * Output vector, it is resized to values.size().
+ */
+void neighborhoodMax(const std::vector<Real> &values, UInt radius,
+                     const std::vector<UInt> &dimensions, bool wrapAround,
+                     std::vector<Real> &result);
+
+/**
+ * Compute the mean value within the neighborhood of every point.
+ *
+ * Like neighborhoodMax, except that the neighborhoods are averaged using
+ * prefix sums along each dimension. Truncated neighborhoods near an edge are
+ * averaged over the points which they contain.
+ */
+void neighborhoodMean(const std::vector<Real> &values, UInt radius,
+                      const std::vector<UInt> &dimensions, bool wrapAround,
+                      std::vector<Real> &result);
+
 } // end namespace topology
 } // namespace math
 } // end namespace nupic
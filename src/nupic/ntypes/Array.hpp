@@ -107,6 +107,7 @@
 // A.getBuffer()                     -- returns a void* pointer to beginning of buffer.
 // A.setBuffer(ptr, count)           -- set un-owned buffer
 // A.setBuffer(sdr)                  -- set un-owned SDR
+// A.setBuffer(B, offset, count)     -- share a range of B's buffer  (not SDR)
 // A.zeroBuffer()                    -- fills A with 0's, A retains type and size.
 // A.releaseBuffer()                 -- free everything (if owned)
 // A.getSDR()                        -- get reference to enclosed SDR
@@ -153,6 +153,22 @@ void ArrayBase::setBuffer(sdr::SDR &sdr) {
   count_ = sdr.size;
 }
 
+/**
+ * Internal function
+ * Share a range of another buffer.  The shared_ptr aliasing constructor
+ * keeps the whole buffer alive while this points into the middle of it.
+ */
+void ArrayBase::setBuffer(const ArrayBase &other, size_t offset, size_t count) {
+  NTA_CHECK(type_ != NTA_BasicType_SDR && other.type_ == type_)
+      << "A shared buffer must have the same type, which is not SDR.";
+  NTA_CHECK(offset + count <= other.count_)
+      << "Shared range " << offset << "+" << count << " is outside of the buffer ("
+      << other.count_ << ").";
+  buffer_ = std::shared_ptr<char>(other.buffer_,
+                                  other.buffer_.get() + offset * BasicType::getSize(type_));
+  count_ = count;
+}
+
 
 
 void ArrayBase::releaseBuffer() {
@@ -261,10 +277,28 @@ void ArrayBase::convertInto(ArrayBase &a, size_t offset, size_t maxsize) const {
   //}
   NTA_CHECK(getCount() + offset <= maxsize);
   char *toPtr =  reinterpret_cast<char *>(a.getBuffer()); // char* so it has size
+  const size_t elementSize = BasicType::getSize(a.getType());
   if (offset)
-    toPtr += (offset * BasicType::getSize(a.getType()));
-  const void *fromPtr = getBuffer();
-  BasicType::convertArray(toPtr, a.type_, fromPtr, type_, getCount());
+    toPtr += (offset * elementSize);
+  if (type_ == NTA_BasicType_SDR && a.type_ != NTA_BasicType_SDR) {
+    // Only the active bits need converting, without building the dense form
+    // of the source.
+    std::memset(toPtr, 0, getCount() * elementSize);
+    const Byte one = 1;
+    for (const auto index : getSDR().getSparse()) {
+      BasicType::convertArray(toPtr + index * elementSize, a.type_, &one,
+                              NTA_BasicType_SDR, 1u);
+    }
+  } else {
+    const void *fromPtr = getBuffer();
+    BasicType::convertArray(toPtr, a.type_, fromPtr, type_, getCount());
+  }
+  if (a.type_ == NTA_BasicType_SDR) {
+    // The dense buffer was written directly, the SDR's other formats are
+    // now out of date.
+    sdr::SDR &sdr = a.getSDR();
+    sdr.setDense(sdr.getDense());
+  }
 }
 
 bool ArrayBase::isInstance(const ArrayBase &a) const {
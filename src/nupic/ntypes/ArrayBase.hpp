@@ -153,6 +153,13 @@ namespace nupic
     virtual void setBuffer(void *buffer, size_t count);
     virtual void setBuffer(sdr::SDR &sdr);
 
+    /**
+     * Use count elements of another ArrayBase's buffer, starting at offset,
+     * without copying them.  Writing to either one changes the other.  The
+     * buffer is freed when neither uses it anymore.  Not valid for SDR.
+     */
+    void setBuffer(const ArrayBase &other, size_t offset, size_t count);
+
 
     /**
      * Return the type of data contained in the ArrayBase object.
@@ -20,8 +20,11 @@
  * ---------------------------------------------------------------------
  */
 
+#include <cstring>  // for memcpy
 #include <limits>
+#include <type_traits>
 
+#include <nupic/math/Simd.hpp>
 #include <nupic/ntypes/BasicType.hpp>
 
 #include <nupic/types/Exception.hpp>
@@ -203,24 +206,29 @@ template <typename T, typename F>
 static void cpyarray(void *toPtr, const void *fromPtr, size_t count) {
   T *ptr1 = static_cast<T *>(toPtr);
   const F *ptr2 = reinterpret_cast<const F *>(fromPtr);
-  for (size_t i = 0; i < count; i++) {
-    *ptr1++ = static_cast<T>(*ptr2++);
+  if (std::is_same<T, F>::value) {
+    std::memcpy(ptr1, ptr2, count * sizeof(T));
+  } else {
+    math::simd::convert(ptr1, ptr2, count);
   }
 }
 
 /**
  * source type larger than source or sign different.
- * Range checks needed
+ * Range checks needed.  The whole source is checked first, so that nothing
+ * is written if a value is out of range.
  */
 template <typename T, typename F>
 static void cpyarray(void *toPtr, const void *fromPtr, size_t count, F minVal, F maxVal) {
   T *ptr1 = static_cast<T *>(toPtr);
   const F *ptr2 = reinterpret_cast<const F *>(fromPtr);
-  for (size_t i = 0; i < count; i++) {
-    NTA_CHECK(*ptr2 >= minVal && *ptr2 <= maxVal)
-          << "Value Out of range. Value: " << *ptr2 << " ";
-    *ptr1++ = static_cast<T>(*ptr2++);
+  if (!math::simd::inRange(ptr2, count, minVal, maxVal)) {
+    for (size_t i = 0; i < count; i++) {
+      NTA_CHECK(ptr2[i] >= minVal && ptr2[i] <= maxVal)
+            << "Value Out of range. Value: " << ptr2[i] << " ";
+    }
   }
+  math::simd::convert(ptr1, ptr2, count);
 }
 
 template <typename T>
@@ -70,6 +70,7 @@ SPRegion::SPRegion(const ValueMap &values, Region *region)
 
   // variables used by this class and not passed on to the SpatialPooler class
   args_.learningMode = (1 == values.getScalarT<UInt32>("learningMode", true));
+  numThreads_ = values.getScalarT<UInt32>("numThreads", 1);
 
     // declare dimensions for bottomUpOut
   // specify dimensions using variable dim; syntax: "{dim: [2,3]}"
@@ -139,6 +140,9 @@ void SPRegion::initialize() {
   if (args_.potentialRadius == 0)
     args_.potentialRadius = args_.inputWidth;
 
+  bottomUpIn_ = in;
+  bottomUpOut_ = out;
+
   // instantiate a SpatialPooler.
   sp_ = std::unique_ptr<algorithms::spatial_pooler::SpatialPooler>(
           new algorithms::spatial_pooler::SpatialPooler(
@@ -148,6 +152,7 @@ void SPRegion::initialize() {
       args_.synPermInactiveDec, args_.synPermActiveInc, args_.synPermConnected,
       args_.minPctOverlapDutyCycles, args_.dutyCyclePeriod, args_.boostStrength,
       args_.seed, args_.spVerbosity, args_.wrapAround));
+  sp_->setNumThreads(numThreads_);
 }
 
 
@@ -160,16 +165,16 @@ void SPRegion::compute() {
 
 
   // prepare the input
-  Array &inputBuffer  = getInput("bottomUpIn")->getData();
-  Array &outputBuffer = getOutput("bottomUpOut")->getData();
-  NTA_DEBUG  << "compute " << *getInput("bottomUpIn") << "\n";
+  Array &inputBuffer  = bottomUpIn_->getData();
+  Array &outputBuffer = bottomUpOut_->getData();
+  NTA_DEBUG  << "compute " << *bottomUpIn_ << "\n";
 
 
   // Call SpatialPooler compute
   sp_->compute(inputBuffer.getSDR(), args_.learningMode, outputBuffer.getSDR());
 
 
-  NTA_DEBUG << "compute " << *getOutput("bottomUpOut") << "\n";
+  NTA_DEBUG << "compute " << *bottomUpOut_ << "\n";
 
 }
 
@@ -522,6 +527,16 @@ Spec *SPRegion::createSpec() {
           ParameterSpec::ReadWriteAccess)); // access
 
 
+  ns->parameters.add("numThreads",
+      ParameterSpec("(uint)\n"
+          "Number of threads used by the spatial pooler's compute. Results "
+          "do not depend on the number of threads. Default ``1``.",
+          NTA_BasicType_UInt32, // type
+          1,                    // elementCount
+          "",                   // constraints
+          "1",                  // defaultValue
+          ParameterSpec::ReadWriteAccess)); // access
+
   ns->parameters.add(
       "activeOutputCount",
       ParameterSpec("Number of active elements in bottomUpOut output.",
@@ -624,6 +639,9 @@ UInt32 SPRegion::getParameterUInt32(const std::string &name, Int64 index) {
       else
         return args_.numActiveColumnsPerInhArea;
     }
+    if (name == "numThreads") {
+      return numThreads_;
+    }
     break;
   case 'p':
     if (name == "potentialRadius") {
@@ -802,6 +820,12 @@ void SPRegion::setParameterUInt32(const std::string &name, Int64 index,
       args_.numActiveColumnsPerInhArea = value;
       return;
     }
+    if (name == "numThreads") {
+      if (sp_)
+        sp_->setNumThreads(value);
+      numThreads_ = value;
+      return;
+    }
     break;
   case 'p':
     if (name == "potentialRadius") {
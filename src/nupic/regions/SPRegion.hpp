@@ -128,6 +128,12 @@ private:
     computeCallbackFunc computeCallback_;
 
     std::string spatialImp_;         // SP variation selector. Currently not used.
+    UInt32 numThreads_ = 1u;         // Run time setting, not part of args_ so
+                                     // that the serialized args_ are unchanged.
+
+    // Resolved by initialize(), so that compute() looks up no names.
+    Input *bottomUpIn_ = nullptr;
+    Output *bottomUpOut_ = nullptr;
 
     std::unique_ptr<algorithms::spatial_pooler::SpatialPooler> sp_;
 
@@ -189,11 +189,16 @@ void TMRegion::initialize() {
   args_.sequencePos = 0;
   args_.init = true;
 
+  resetIn_ = getInput("resetIn");
+  bottomUpIn_ = getInput("bottomUpIn");
+  extraActiveIn_ = getInput("extraActive");
+  extraWinnersIn_ = getInput("extraWinners");
+  bottomUpOut_ = getOutput("bottomUpOut");
+  activeCellsOut_ = getOutput("activeCells");
+  predictedActiveCellsOut_ = getOutput("predictedActiveCells");
 }
 
 void TMRegion::compute() {
-
-  std::cerr << "compute 0 " << std::endl;
   NTA_ASSERT(tm_) << "TM not initialized";
 
   if (computeCallback_ != nullptr)
@@ -201,8 +206,8 @@ void TMRegion::compute() {
   args_.iter++;
 
   // Handle reset signal
-  if (getInput("resetIn")->hasIncomingLinks()) {
-    Array &reset = getInput("resetIn")->getData();
+  if (resetIn_->hasIncomingLinks()) {
+    Array &reset = resetIn_->getData();
     NTA_ASSERT(reset.getType() == NTA_BasicType_Real32);
     if (reset.getCount() == 1 && ((Real32 *)(reset.getBuffer()))[0] != 0) {
       tm_->reset();
@@ -212,17 +217,17 @@ void TMRegion::compute() {
 
   // Check the input buffer
   // The buffer width is the number of columns.
-  Input *in = getInput("bottomUpIn");
+  Input *in = bottomUpIn_;
   Array &bottomUpIn = in->getData();
   NTA_ASSERT(bottomUpIn.getType() == NTA_BasicType_SDR);
   SDR& activeColumns = bottomUpIn.getSDR();
 
   // Check for 'extra' inputs
   static SDR nullSDR({0});
-  Array &extraActive = getInput("extraActive")->getData();
+  Array &extraActive = extraActiveIn_->getData();
   SDR& extraActiveCells = (args_.extra)?(extraActive.getSDR()):nullSDR;
 
-  Array &extraWinners = getInput("extraWinners")->getData();
+  Array &extraWinners = extraWinnersIn_->getData();
   SDR& extraWinnerCells = (args_.extra)?(extraWinners.getSDR()):nullSDR;
 
   NTA_DEBUG << "compute " << *in << std::endl;
@@ -246,7 +251,7 @@ void TMRegion::compute() {
   //         numberOfCols * cellsPerColumn.
   //
   Output *out;
-  out = getOutput("bottomUpOut");
+  out = bottomUpOut_;
   if (out && (out->hasOutgoingLinks() || LogItem::isDebug())) {
     auto active = tm_->getActiveCells();         // sparse
     auto predictive = tm_->getPredictiveCells(); // sparse
@@ -261,12 +266,12 @@ void TMRegion::compute() {
 
     NTA_DEBUG << "compute " << *out << std::endl;
   }
-  out = getOutput("activeCells");
+  out = activeCellsOut_;
   if (out && (out->hasOutgoingLinks() || LogItem::isDebug())) {
     tm_->getActiveCells(out->getData().getSDR());
     NTA_DEBUG << "compute " << *out << std::endl;
   }
-  out = getOutput("predictedActiveCells");
+  out = predictedActiveCellsOut_;
   if (out && (out->hasOutgoingLinks() || LogItem::isDebug())) {
     tm_->getWinnerCells(out->getData().getSDR());
     NTA_DEBUG << "compute " << *out << std::endl;
@@ -129,6 +129,16 @@ private:
 
 
   computeCallbackFunc computeCallback_;
+
+  // Resolved by initialize(), so that compute() looks up no names.
+  Input *resetIn_ = nullptr;
+  Input *bottomUpIn_ = nullptr;
+  Input *extraActiveIn_ = nullptr;
+  Input *extraWinnersIn_ = nullptr;
+  Output *bottomUpOut_ = nullptr;
+  Output *activeCellsOut_ = nullptr;
+  Output *predictedActiveCellsOut_ = nullptr;
+
   std::unique_ptr<nupic::algorithms::temporal_memory::TemporalMemory> tm_;
 };
 
@@ -26,8 +26,68 @@
 #include <numeric>
 #include <algorithm> // std::sort
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 using namespace std;
 
+namespace {
+
+    using nupic::UInt64;
+
+    const size_t packedBits = 64u;
+
+    size_t packedWords(size_t size)
+        { return (size + packedBits - 1u) / packedBits; }
+
+    inline UInt64 popcount(UInt64 word) {
+    #ifdef _MSC_VER
+        return __popcnt64(word);
+    #else
+        return __builtin_popcountll(word);
+    #endif
+    }
+
+    // Index of the lowest set bit, word must not be zero.
+    inline UInt64 countTrailingZeros(UInt64 word) {
+    #ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, word);
+        return index;
+    #else
+        return __builtin_ctzll(word);
+    #endif
+    }
+
+    // Reads the 64 bits starting at the given bit, bits past the end are zero.
+    inline UInt64 readBits(const UInt64 *words, size_t numWords, size_t bit) {
+        const size_t word  = bit / packedBits;
+        const size_t shift = bit % packedBits;
+        UInt64 value = words[word] >> shift;
+        if( shift != 0u && word + 1u < numWords )
+            value |= words[word + 1u] << (packedBits - shift);
+        return value;
+    }
+
+    // ORs length bits of src, starting at srcBit, into dst starting at dstBit.
+    void copyBits(const UInt64 *src, size_t srcWords, size_t srcBit,
+                  UInt64 *dst, size_t dstBit, size_t length) {
+        while( length > 0u ) {
+            const size_t shift = dstBit % packedBits;
+            const size_t count = std::min(length, packedBits - shift);
+            UInt64 value = readBits(src, srcWords, srcBit);
+            if( count < packedBits )
+                value &= (UInt64(1u) << count) - 1u;
+            dst[dstBit / packedBits] |= value << shift;
+            srcBit += count;
+            dstBit += count;
+            length -= count;
+        }
+    }
+
+} // end anonymous namespace
+
 namespace nupic {
 namespace sdr {
 
@@ -35,6 +95,7 @@ namespace sdr {
         dense_valid       = false;
         sparse_valid      = false;
         coordinates_valid = false;
+        packed_valid      = false;
     }
 
     void SparseDistributedRepresentation::do_callbacks() const {
@@ -63,7 +124,25 @@ namespace sdr {
         #endif
         // Set the valid flags.
         clear();
-        sparse_valid = true;
+        sparse_valid  = true;
+        sparse_sorted = false;
+        do_callbacks();
+    }
+
+    void SparseDistributedRepresentation::setSparseSortedInplace() const {
+        // Check data is valid.
+        #ifdef NTA_ASSERTIONS_ON
+            NTA_ASSERT(sparse_.size() <= size);
+            for(size_t i = 0; i < sparse_.size(); i++) {
+                NTA_ASSERT(sparse_[i] < size);
+                NTA_ASSERT(i == 0 || sparse_[i - 1] < sparse_[i])
+                    << "SDR sparse data is not sorted!";
+            }
+        #endif
+        // Set the valid flags.
+        clear();
+        sparse_valid  = true;
+        sparse_sorted = true;
         do_callbacks();
     }
 
@@ -86,6 +165,18 @@ namespace sdr {
         do_callbacks();
     }
 
+    void SparseDistributedRepresentation::setPackedInplace() const {
+        // Check data is valid.
+        NTA_ASSERT( packed_.size() == packedWords(size) );
+        NTA_ASSERT( size % packedBits == 0u ||
+                    (packed_.back() >> (size % packedBits)) == 0u )
+                << "SDR packed data has bits set past the end of the SDR!";
+        // Set the valid flags.
+        clear();
+        packed_valid = true;
+        do_callbacks();
+    }
+
     void SparseDistributedRepresentation::deconstruct() {
         clear();
         size_ = 0;
@@ -121,10 +212,13 @@ namespace sdr {
         // Initialize the dense array storage, when it's needed.
         dense_valid = false;
         // Initialize the flatSparse array, nothing to do.
-        sparse_valid = true;
+        sparse_valid  = true;
+        sparse_sorted = true;
         // Initialize the index tuple.
         coordinates_.assign( dimensions.size(), {} );
         coordinates_valid = true;
+        // Initialize the packed words, when they're needed.
+        packed_valid = false;
     }
 
     SparseDistributedRepresentation::SparseDistributedRepresentation(
@@ -181,6 +275,8 @@ namespace sdr {
     SDR_sparse_t& SparseDistributedRepresentation::getSparse() const {
         if( !sparse_valid ) {
             sparse_.clear(); // Clear out any old data.
+            // Converting from dense or packed yields sorted indices.
+            sparse_sorted = !coordinates_valid;
             if( coordinates_valid ) {
                 // Convert from coordinates to flat-sparse.
                 const auto &coords = getCoordinates();
@@ -195,6 +291,16 @@ namespace sdr {
                     sparse_.push_back(flat);
                 }
             }
+            else if( packed_valid ) {
+                // Convert from packed to flatSparse, one set bit at a time.
+                for(size_t w = 0u; w < packed_.size(); w++) {
+                    UInt64 word = packed_[w];
+                    while( word != 0u ) {
+                        sparse_.push_back( (ElemSparse)(w * packedBits + countTrailingZeros(word)) );
+                        word &= word - 1u;
+                    }
+                }
+            }
             else if( dense_valid ) {
                 // Convert from dense to flatSparse.
                 const auto &dense = getDense();
@@ -210,6 +316,23 @@ namespace sdr {
     }
 
 
+    void SparseDistributedRepresentation::setSparseSorted( SDR_sparse_t &value ) {
+        sparse_.swap( value );
+        setSparseSortedInplace();
+    }
+
+    SDR_sparse_t& SparseDistributedRepresentation::getSparseSorted() const {
+        auto &sparse = getSparse();
+        if( !sparse_sorted ) {
+            std::sort( sparse.begin(), sparse.end() );
+            sparse_sorted = true;
+            // The coordinates are in the old order of the sparse indices.
+            coordinates_valid = false;
+        }
+        return sparse;
+    }
+
+
     void SparseDistributedRepresentation::setCoordinates( SDR_coordinate_t &value ) {
         coordinates_.swap( value );
         setCoordinatesInplace();
@@ -236,6 +359,24 @@ namespace sdr {
     }
 
 
+    void SparseDistributedRepresentation::setPacked( SDR_packed_t &value ) {
+        packed_.swap( value );
+        setPackedInplace();
+    }
+
+    SDR_packed_t& SparseDistributedRepresentation::getPacked() const {
+        if( !packed_valid ) {
+            // Convert from flatSparse to packed.
+            packed_.assign( packedWords(size), 0u );
+            for(const auto idx : getSparse()) {
+                packed_[idx / packedBits] |= UInt64(1u) << (idx % packedBits);
+            }
+            packed_valid = true;
+        }
+        return packed_;
+    }
+
+
     void SparseDistributedRepresentation::setSDR( const SparseDistributedRepresentation &value ) {
         NTA_ASSERT( value.dimensions == dimensions );
         clear();
@@ -247,17 +388,23 @@ namespace sdr {
         sparse_valid = value.sparse_valid;
         if( sparse_valid ) {
             sparse_.assign( value.sparse_.begin(), value.sparse_.end() );
+            sparse_sorted = value.sparse_sorted;
         }
         coordinates_valid = value.coordinates_valid;
         if( coordinates_valid ) {
             for(UInt dim = 0; dim < dimensions.size(); dim++)
                 coordinates_[dim].assign( value.coordinates_[dim].begin(), value.coordinates_[dim].end() );
         }
+        packed_valid = value.packed_valid;
+        if( packed_valid ) {
+            packed_.assign( value.packed_.begin(), value.packed_.end() );
+        }
         // Subclasses may override these getters and ignore the valid flags...
-        if( !dense_valid and !sparse_valid and !coordinates_valid ) {
+        if( !dense_valid and !sparse_valid and !coordinates_valid and !packed_valid ) {
             const auto data = value.getSparse();
             sparse_.assign( data.begin(), data.end() );
-            sparse_valid = true;
+            sparse_valid  = true;
+            sparse_sorted = false;
         }
         do_callbacks();
     }
@@ -267,10 +414,10 @@ namespace sdr {
         NTA_ASSERT( dimensions == sdr.dimensions );
 
         UInt ovlp = 0u;
-        const auto a = this->getDense();
-        const auto b = sdr.getDense();
-        for( UInt i = 0u; i < size; i++ )
-            ovlp += a[i] && b[i];
+        const auto &a = this->getPacked();
+        const auto &b = sdr.getPacked();
+        for( size_t w = 0u; w < a.size(); w++ )
+            ovlp += (UInt)popcount( a[w] & b[w] );
         return ovlp;
     }
 
@@ -328,6 +475,21 @@ namespace sdr {
     }
 
     void SparseDistributedRepresentation::intersection(vector<const SDR*> inputs) {
+        combine_( inputs, [](UInt64 a, UInt64 b) { return a & b; });
+    }
+
+    void SparseDistributedRepresentation::setUnion(
+            const SDR &input1,
+            const SDR &input2) {
+        setUnion( { &input1, &input2 } );
+    }
+
+    void SparseDistributedRepresentation::setUnion(vector<const SDR*> inputs) {
+        combine_( inputs, [](UInt64 a, UInt64 b) { return a | b; });
+    }
+
+    template<typename Op>
+    void SparseDistributedRepresentation::combine_(vector<const SDR*> inputs, Op op) {
         NTA_CHECK( inputs.size() >= 2u );
         bool inplace = false;
         for( size_t i = 0; i < inputs.size(); i++ ) {
@@ -341,22 +503,20 @@ namespace sdr {
             }
         }
         if( inplace ) {
-            getDense(); // Make sure that the dense data is valid.
+            getPacked(); // Make sure that the packed data is valid.
         }
         if( not inplace ) {
             // Copy one of the SDRs over to the output SDR.
-            const auto &denseIn = inputs.back()->getDense();
-            dense_.assign( denseIn.begin(), denseIn.end() );
+            packed_ = inputs.back()->getPacked();
             inputs.pop_back();
-            // inplace = true; // Now it's an inplace operation.
         }
         for(const auto &sdr_ptr : inputs) {
-            const auto &data = sdr_ptr->getDense();
-            for(auto z = 0u; z < data.size(); ++z) {
-                dense_[z] = dense_[z] && data[z];
+            const auto &data = sdr_ptr->getPacked();
+            for(size_t w = 0u; w < data.size(); ++w) {
+                packed_[w] = op( packed_[w], data[w] );
             }
         }
-        SDR::setDenseInplace();
+        SDR::setPackedInplace();
     }
 
     void SparseDistributedRepresentation::concatenate(const SDR &inp1, const SDR &inp2, UInt axis)
@@ -388,33 +548,34 @@ namespace sdr {
             << concat_axis_size << ", output expects " << dimensions[axis] << "!";
 
         // Setup for copying the data as rows & strides.
-        vector<ElemDense*> buffers;
-        vector<UInt>       row_lengths;
+        vector<const SDR_packed_t*> buffers;
+        vector<size_t>              row_lengths;
         for( const auto &sdr : inputs ) {
-            buffers.push_back( sdr->getDense().data() );
-            UInt row = 1u;
+            buffers.push_back( &sdr->getPacked() );
+            size_t row = 1u;
             for(UInt d = axis; d < dimensions.size(); ++d)
                 row *= sdr->dimensions[d];
             row_lengths.push_back( row );
         }
 
-        // Get the output buffer.
-        dense_.resize( size );
-              auto dense_data  = dense_.data();
-        const auto data_end    = dense_data + size;
-        const auto n_inputs    = inputs.size();
-        while( dense_data < data_end ) {
-            // Copy one row from each input SDR.
-            for( UInt i = 0u; i < n_inputs; ++i ) {
-                const auto &buf = buffers[i];
-                const auto &row = row_lengths[i];
-                std::copy( buf, buf + row, dense_data );
-                // Increment the pointers.
-                buffers[i] += row;
-                dense_data += row;
+        // Get the output buffer, and copy one row from each input SDR at a
+        // time, whole words at a time.
+        SDR_packed_t packed( packedWords(size), 0u );
+        const auto n_inputs = inputs.size();
+        vector<size_t> in_bits( n_inputs, 0u );
+        size_t out_bit = 0u;
+        while( out_bit < size ) {
+            for( size_t i = 0u; i < n_inputs; ++i ) {
+                const auto &buf = *buffers[i];
+                const auto  row = row_lengths[i];
+                copyBits( buf.data(), buf.size(), in_bits[i],
+                          packed.data(), out_bit, row );
+                in_bits[i] += row;
+                out_bit    += row;
             }
         }
-        SDR::setDenseInplace();
+        packed_.swap( packed );
+        SDR::setPackedInplace();
     }
 
     bool SparseDistributedRepresentation::operator==(const SparseDistributedRepresentation &sdr) const {
@@ -426,10 +587,7 @@ namespace sdr {
                 return false;
         }
         // Check data
-        return std::equal(
-            getDense().begin(),
-            getDense().end(), 
-            sdr.getDense().begin());
+        return getPacked() == sdr.getPacked();
     }
 
 
@@ -567,6 +725,16 @@ namespace sdr {
         return parent->getSparse();
     }
 
+    SDR_packed_t& Reshape::getPacked() const {
+        NTA_CHECK( parent != nullptr ) << "Parent SDR has been destroyed!";
+        return parent->getPacked();
+    }
+
+    SDR_sparse_t& Reshape::getSparseSorted() const {
+        NTA_CHECK( parent != nullptr ) << "Parent SDR has been destroyed!";
+        return parent->getSparseSorted();
+    }
+
     SDR_coordinate_t& Reshape::getCoordinates() const {
         NTA_CHECK( parent != nullptr ) << "Parent SDR has been destroyed!";
         if( dimensions.size() == parent->dimensions.size() &&
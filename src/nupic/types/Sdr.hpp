@@ -36,9 +36,11 @@ namespace sdr {
 
 using ElemDense        = Byte; //TODO allow changing this
 using ElemSparse       = UInt32; //must match with connections::CellIdx 
+using ElemPacked       = UInt64;
 
 using SDR_dense_t      = std::vector<ElemDense>;
 using SDR_sparse_t     = std::vector<ElemSparse>;
+using SDR_packed_t     = std::vector<ElemPacked>;
 using SDR_coordinate_t = std::vector<std::vector<UInt>>;
 using SDR_callback_t   = std::function<void()>;
 
@@ -52,7 +54,7 @@ using SDR_callback_t   = std::function<void()>;
  * represent the state of a group of neurons or their associated processes. 
  *
  * This class automatically converts between the commonly used SDR data formats:
- * which are dense, sparse, and coordinates.  Converted values are cached by
+ * which are dense, sparse, coordinates, and packed.  Converted values are cached by
  * this class, so getting a value in one format many times incurs no extra
  * performance cost.  Assigning to the SDR via a setter method will clear these
  * cached values and cause them to be recomputed as needed.
@@ -72,6 +74,12 @@ using SDR_callback_t   = std::function<void()>;
  *    useful because it contains the location of each true bit inside of the
  *    SDR's dimensional space.
  *
+ *    Packed Format: The dense format stored as one bit per value, in 64-bit
+ *    words.  Bit (i % 64) of word (i / 64) holds the value at flat index i,
+ *    and the unused bits of the last word are zero.  This format is an eighth
+ *    of the size of the dense format, and it is what getOverlap, intersection,
+ *    setUnion and concatenate work on, a whole word at a time.
+ *
  * Array Memory Layout: This class uses C-order throughout, meaning that when
  * iterating through the SDR, the last/right-most index changes fastest.
  *
@@ -108,6 +116,7 @@ using SDR_callback_t   = std::function<void()>;
  *     vector<Byte>            aka SDR_dense_t
  *     vector<UInt>            aka SDR_sparse_t
  *     vector<vector<UInt>>    aka SDR_coordinate_t
+ *     vector<UInt64>          aka SDR_packed_t
  *
  * Example Usage With Out Copying:
  *    SDR  X( {3, 3} );
@@ -137,6 +146,7 @@ protected:
     mutable SDR_dense_t      dense_;
     mutable SDR_sparse_t     sparse_;
     mutable SDR_coordinate_t coordinates_;
+    mutable SDR_packed_t     packed_;
 
     /**
      * These flags remember which data formats are up-to-date and which formats
@@ -145,6 +155,14 @@ protected:
     mutable bool dense_valid;
     mutable bool sparse_valid;
     mutable bool coordinates_valid;
+    mutable bool packed_valid;
+
+    /**
+     * True if the sparse vector is known to be sorted.  Only meaningful while
+     * sparse_valid is set.  Sparse data converted from the dense or packed
+     * formats is sorted for free, see also getSparseSorted.
+     */
+    mutable bool sparse_sorted;
 
 private:
     /**
@@ -187,6 +205,12 @@ protected:
      */
     virtual void setSparseInplace() const;
 
+    /**
+     * Like setSparseInplace, for a flatSparse vector which the caller has
+     * already sorted.
+     */
+    virtual void setSparseSortedInplace() const;
+
     /**
      * Update the SDR to reflect the value currently inside of the sparse
      * vector. Use this method after modifying the sparse vector inplace, in
@@ -194,6 +218,13 @@ protected:
      */
     virtual void setCoordinatesInplace() const;
 
+    /**
+     * Update the SDR to reflect the value currently inside of the packed
+     * vector. Use this method after modifying the packed vector inplace, in
+     * order to propigate any changes to the other formats.
+     */
+    virtual void setPackedInplace() const;
+
     /**
      * Destroy this SDR.  Makes SDR unusable, should error or clearly fail if
      * used.  Also sends notification to all watchers via destroyCallbacks.
@@ -202,6 +233,14 @@ protected:
      */
     virtual void deconstruct();
 
+private:
+    /**
+     * Implements intersection and setUnion: combines the packed words of the
+     * inputs with op, and stores the result in this SDR.
+     */
+    template<typename Op>
+    void combine_(std::vector<const SparseDistributedRepresentation*> inputs, Op op);
+
 public:
     /**
      * Use this method only in conjuction with sdr.initialize() or sdr.load().
@@ -345,6 +384,44 @@ public:
      */
     virtual SDR_sparse_t& getSparse() const;
 
+    /**
+     * Swap a new value into the SDR, like setSparse, for indices which are
+     * already sorted in ascending order.  The SDR remembers this, so that
+     * getSparseSorted does not need to sort them again.
+     *
+     * @param value A sorted sparse vector<UInt> to swap into the SDR.
+     */
+    void setSparseSorted( SDR_sparse_t &value );
+
+    /**
+     * Copy a sorted vector of sparse indices into the SDR, see setSparseSorted.
+     *
+     * @param value A sorted vector of flat indices to copy into the SDR.
+     */
+    template<typename T>
+    void setSparseSorted( const std::vector<T> &value ) {
+      sparse_.assign( value.begin(), value.end() );
+      setSparseSortedInplace();
+    }
+
+    /**
+     * Gets the current value of the SDR, like getSparse, with the indices
+     * sorted in ascending order.  The indices are only sorted if the SDR does
+     * not already know them to be sorted: sparse data which was converted
+     * from the dense or packed formats, or which was set by setSparseSorted,
+     * is returned as is.  Sorting reorders the SDR's own sparse vector, so the
+     * result is also what getSparse returns afterwards, and the coordinates
+     * are converted again in the new order when next asked for.
+     *
+     * This is not thread safe: although it is const, it may sort the SDR's
+     * data in place, so it must not run while another thread reads the same
+     * SDR.
+     *
+     * @returns A reference to a sorted vector of the indices of the true
+     * values in the flattened SDR.
+     */
+    virtual SDR_sparse_t& getSparseSorted() const;
+
     /**
      * Swap a list of coordinates into the SDR, replacing the SDRs current
      * value.  These are indices into the SDR space with dimensions.  This
@@ -394,6 +471,26 @@ public:
      */
     virtual SDR_coordinate_t& getCoordinates() const;
 
+    /**
+     * Swap a packed bit vector into the SDR, replacing the SDRs current value.
+     * This method is fast since it copies no data.  This method modifies its
+     * argument!
+     *
+     * @param value A vector of (size + 63) / 64 words, see "Packed Format"
+     * above.  The unused bits of the last word must be zero.
+     */
+    void setPacked( SDR_packed_t &value );
+
+    /**
+     * Gets the current value of the SDR.  The result of this method call is
+     * saved inside of this SDR until the SDRs value changes.  After modifying
+     * the packed vector you MUST call sdr.setPacked() in order to notify the
+     * SDR that its packed vector has changed.
+     *
+     * @returns A reference to the values of the SDR packed 64 to a word.
+     */
+    virtual SDR_packed_t& getPacked() const;
+
     /**
      * Deep Copy the given SDR to this SDR.  This overwrites the current value of
      * this SDR.  This SDR and the given SDR will have no shared data and they
@@ -490,6 +587,24 @@ public:
 
     void intersection(std::vector<const SparseDistributedRepresentation*> inputs);
 
+    /**
+     * This method calculates the set union of the active bits in each input
+     * SDR.  It has the same overloads as intersection.
+     *
+     * Example Usage:
+     *     SDR A({ 10 });
+     *     SDR B({ 10 });
+     *     SDR C({ 10 });
+     *     A.setSparse({0, 1, 2, 3});
+     *     B.setSparse(      {2, 3, 4, 5});
+     *     C.setUnion(A, B);
+     *     C.getSparse() -> {0, 1, 2, 3, 4, 5}
+     */
+    void setUnion(const SparseDistributedRepresentation &input1,
+                  const SparseDistributedRepresentation &input2);
+
+    void setUnion(std::vector<const SparseDistributedRepresentation*> inputs);
+
     /**
      * Concatenates SDRs and stores the result in this SDR.
      *
@@ -532,8 +647,15 @@ public:
                 stream << ", ";
         }
         stream << " ) ";
-        auto data = sdr.getSparse();
-        std::sort( data.begin(), data.end() );
+        // Print the indices in order without reordering the SDR's own data,
+        // which getSparseSorted would do.
+        const auto &sparse = sdr.getSparse();
+        SDR_sparse_t copy;
+        if( !sdr.sparse_sorted ) {
+            copy = sparse;
+            std::sort( copy.begin(), copy.end() );
+        }
+        const auto &data = sdr.sparse_sorted ? sparse : copy;
         for( UInt i = 0; i < data.size(); i++ ) {
             stream << data[i];
             if( i + 1 != data.size() )
@@ -678,8 +800,12 @@ public:
 
     SDR_sparse_t& getSparse() const override;
 
+    SDR_sparse_t& getSparseSorted() const override;
+
     SDR_coordinate_t& getCoordinates() const override;
 
+    SDR_packed_t& getPacked() const override;
+
     void save(std::ostream &outStream) const override;
 
     ~Reshape() override
@@ -702,8 +828,12 @@ private:
         { NTA_THROW << _error_message; }
     void setSparseInplace() const override
         { NTA_THROW << _error_message; }
+    void setSparseSortedInplace() const override
+        { NTA_THROW << _error_message; }
     void setCoordinatesInplace() const override
         { NTA_THROW << _error_message; }
+    void setPackedInplace() const override
+        { NTA_THROW << _error_message; }
     void setSDR( const SparseDistributedRepresentation &value ) override
         { NTA_THROW << _error_message; }
     void load(std::istream &inStream) override
@@ -4,6 +4,8 @@
 
 #include "MurmurHash3.hpp"
 
+#include <cstring> // memcpy
+
 namespace nupic {
 
 /*
@@ -105,4 +107,41 @@ UInt32 MurmurHash3_x86_32( const void * key, int len, UInt32 seed )
 
   return h1;
 }
+
+//-----------------------------------------------------------------------------
+void MurmurHash3_x86_32_sequence( UInt first, UInt count, UInt32 seed,
+                                  UInt32 * hashes )
+{
+  // The body of MurmurHash3_x86_32 for keys of a fixed size, which are a
+  // whole number of blocks, so there is no tail.
+  const int nblocks = sizeof(UInt) / 4;
+  static_assert( sizeof(UInt) % 4 == 0, "Keys must be a whole number of blocks." );
+
+  const UInt32 c1 = 0xcc9e2d51;
+  const UInt32 c2 = 0x1b873593;
+
+  for(UInt i = 0; i < count; i++)
+  {
+    const UInt key = first + i;
+    UInt32 blocks[nblocks];
+    std::memcpy( blocks, &key, sizeof(key) );
+
+    UInt32 h1 = seed;
+    for(int b = 0; b < nblocks; b++)
+    {
+      UInt32 k1 = getblock32(blocks,b);
+
+      k1 *= c1;
+      k1 = rotl32(k1,15);
+      k1 *= c2;
+
+      h1 ^= k1;
+      h1 = rotl32(h1,13);
+      h1 = h1 * 5 + 0xe6546b64;
+    }
+
+    h1 ^= (UInt32) sizeof(key);
+    hashes[i] = fmix32(h1);
+  }
+}
 } // End namespace nupic
@@ -11,5 +11,14 @@ namespace nupic {
 
   UInt32 MurmurHash3_x86_32( const void * key, int len, UInt32 seed );
 
+  /**
+   * Hashes the count consecutive integers first, first + 1, ..., the same
+   * way as MurmurHash3_x86_32( &key, sizeof(key), seed ), into hashes.  The
+   * keys have a fixed size and no tail, so this is a plain scalar loop over
+   * the block mixing and finalization, without the general length handling.
+   */
+  void MurmurHash3_x86_32_sequence( UInt first, UInt count, UInt32 seed,
+                                    UInt32 * hashes );
+
 }      // End namespace nupic
 #endif // _MURMURHASH3_H_
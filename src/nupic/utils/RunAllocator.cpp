@@ -0,0 +1,225 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2019, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of RunAllocator
+ */
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include <nupic/utils/Log.hpp>
+#include <nupic/utils/RunAllocator.hpp>
+
+using namespace std;
+using namespace nupic;
+using namespace nupic::util;
+
+namespace {
+
+const UInt32 MIN_CAPACITY = 4u;
+
+// Compacting to reclaim only a few elements is never worth it.
+const size_t MIN_FRAGMENTED_SIZE = 1024u;
+
+// Capacities are 4, 6, 8, 12, 16, 24, ...: powers of two, and the numbers
+// half way between them.  Size class 2k holds runs of 2^k elements, and
+// class 2k + 1 holds runs of 3 * 2^(k-1) elements.
+bool isCapacity(UInt32 capacity) {
+  if (capacity < MIN_CAPACITY) return false;
+  const UInt32 power = (capacity % 3u == 0u) ? capacity / 3u : capacity;
+  return (power & (power - 1u)) == 0u;
+}
+
+size_t sizeClass(UInt32 capacity) {
+  NTA_ASSERT(isCapacity(capacity));
+  size_t log2 = 0u;
+  while (((size_t)2u << log2) <= capacity) log2++;
+  return 2u * log2 + (capacity == (1u << log2) ? 0u : 1u);
+}
+
+size_t classCapacity(size_t cls) {
+  return (cls % 2u == 0u) ? (size_t)1u << (cls / 2u) : (size_t)3u << (cls / 2u - 1u);
+}
+
+UInt32 nextCapacity(UInt32 capacity) {
+  if (capacity < MIN_CAPACITY) return MIN_CAPACITY;
+  return (capacity & (capacity - 1u)) == 0u ? capacity + capacity / 2u
+                                            : capacity + capacity / 3u;
+}
+
+// Extents are (offset, capacity) pairs.  Throws unless they are disjoint
+// and lie within an arena of the given size.
+void checkDisjoint(vector<pair<size_t, size_t>> &extents, size_t size) {
+  sort(extents.begin(), extents.end());
+  size_t end = 0u;
+  for (const auto &extent : extents) {
+    NTA_CHECK(extent.first >= end && extent.first + extent.second <= size)
+        << "RunAllocator: runs overlap or are outside of the arena.";
+    end = extent.first + extent.second;
+  }
+}
+
+void addFreeRuns(vector<pair<size_t, size_t>> &extents,
+                 const vector<vector<UInt32>> &freeRuns) {
+  for (size_t cls = 0; cls < freeRuns.size(); cls++) {
+    for (const UInt32 offset : freeRuns[cls]) {
+      extents.emplace_back(offset, classCapacity(cls));
+    }
+  }
+}
+
+} // namespace
+
+
+void RunAllocator::clear() {
+  size_     = 0u;
+  freeSize_ = 0u;
+  freeRuns_.clear();
+}
+
+
+UInt32 RunAllocator::allocate_(UInt32 capacity) {
+  const size_t cls = sizeClass(capacity);
+  if (cls < freeRuns_.size() && !freeRuns_[cls].empty()) {
+    const UInt32 offset = freeRuns_[cls].back();
+    freeRuns_[cls].pop_back();
+    freeSize_ -= capacity;
+    return offset;
+  }
+  NTA_CHECK(size_ + capacity <= numeric_limits<UInt32>::max())
+      << "RunAllocator: arena is full.";
+  const UInt32 offset = static_cast<UInt32>(size_);
+  size_ += capacity;
+  return offset;
+}
+
+
+UInt32 RunAllocator::grow(Run &run) {
+  if (run.size < run.capacity) return run.offset;
+  return resize_(run, nextCapacity(run.capacity));
+}
+
+
+UInt32 RunAllocator::reserve(Run &run, UInt32 capacity) {
+  if (capacity <= run.capacity) return run.offset;
+  UInt32 newCapacity = run.capacity;
+  while (newCapacity < capacity) {
+    NTA_CHECK(newCapacity < numeric_limits<UInt32>::max() / 2u)
+        << "RunAllocator: run is too long.";
+    newCapacity = nextCapacity(newCapacity);
+  }
+  return resize_(run, newCapacity);
+}
+
+
+UInt32 RunAllocator::resize_(Run &run, UInt32 capacity) {
+  const UInt32 offset = run.offset;
+
+  // The last run of the arena grows in place, which is the common case
+  // while a list is being filled right after it was created.
+  if (run.capacity > 0u && run.offset + run.capacity == size_) {
+    NTA_CHECK((size_t)run.offset + capacity <= numeric_limits<UInt32>::max())
+        << "RunAllocator: arena is full.";
+    size_ = (size_t)run.offset + capacity;
+    run.capacity = capacity;
+    return offset;
+  }
+
+  const UInt32 size      = run.size;
+  const UInt32 newOffset = allocate_(capacity);
+  release(run);
+  run.offset   = newOffset;
+  run.size     = size;
+  run.capacity = capacity;
+  return offset;
+}
+
+
+void RunAllocator::release(Run &run) {
+  if (run.capacity > 0u) {
+    const size_t cls = sizeClass(run.capacity);
+    if (cls >= freeRuns_.size()) {
+      freeRuns_.resize(cls + 1u);
+    }
+    freeRuns_[cls].push_back(run.offset);
+    freeSize_ += run.capacity;
+  }
+  run.offset   = 0u;
+  run.size     = 0u;
+  run.capacity = 0u;
+}
+
+
+bool RunAllocator::fragmented(size_t numRuns) const {
+  return freeSize_ >= MIN_FRAGMENTED_SIZE && 8u * freeSize_ > size_ &&
+         freeSize_ > numRuns;
+}
+
+
+void RunAllocator::packed(size_t size) {
+  NTA_ASSERT(size <= size_);
+  size_     = size;
+  freeSize_ = 0u;
+  freeRuns_.clear();
+}
+
+
+void RunAllocator::restore(size_t size, const vector<vector<UInt32>> &freeRuns) {
+  NTA_CHECK(size <= numeric_limits<UInt32>::max())
+      << "RunAllocator: arena is too long.";
+  size_t freeSize = 0u;
+  for (size_t cls = 0; cls < freeRuns.size(); cls++) {
+    if (freeRuns[cls].empty()) continue;
+    // Only the classes from MIN_CAPACITY up to the largest UInt32 capacity
+    // exist, see sizeClass.
+    NTA_CHECK(cls >= sizeClass(MIN_CAPACITY) && cls < 64u)
+        << "RunAllocator: released run has no valid capacity.";
+    freeSize += freeRuns[cls].size() * classCapacity(cls);
+  }
+  vector<pair<size_t, size_t>> extents;
+  addFreeRuns(extents, freeRuns);
+  checkDisjoint(extents, size);
+
+  size_     = size;
+  freeSize_ = freeSize;
+  freeRuns_ = freeRuns;
+}
+
+
+void RunAllocator::check(const vector<Run> &runs) const {
+  vector<pair<size_t, size_t>> extents;
+  for (const Run &run : runs) {
+    NTA_CHECK(run.size <= run.capacity)
+        << "RunAllocator: run is longer than its capacity.";
+    // sizeClass only asserts this, so it must hold before a restored run is
+    // grown or released.
+    NTA_CHECK(run.capacity == 0u || isCapacity(run.capacity))
+        << "RunAllocator: run has no valid capacity.";
+    if (run.capacity > 0u) {
+      extents.emplace_back(run.offset, run.capacity);
+    }
+  }
+  addFreeRuns(extents, freeRuns_);
+  checkDisjoint(extents, size_);
+}
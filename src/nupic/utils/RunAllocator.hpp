@@ -0,0 +1,153 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2019, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definition of the RunAllocator, which packs many small lists into one array
+ */
+
+#ifndef NUPIC_UTIL_RUN_ALLOCATOR_HPP
+#define NUPIC_UTIL_RUN_ALLOCATOR_HPP
+
+#include <vector>
+
+#include <nupic/types/Types.hpp>
+
+namespace nupic {
+namespace util {
+
+/**
+ * A list stored as a contiguous run of elements in an arena array.  The list
+ * is the elements [offset, offset + size) of the arena, and it has room for
+ * capacity elements before it must move.
+ */
+struct Run {
+  UInt32 offset;
+  UInt32 size;
+  UInt32 capacity;
+};
+
+/**
+ * Hands out runs of an arena, for storing many small growable lists in one
+ * (or several parallel) std::vector instead of one heap allocation per list.
+ *
+ * The allocator only does the bookkeeping: it tracks the length of the
+ * arena and which parts of it are free.  The owner keeps the arena arrays,
+ * resizes them to size() after each call which may grow the arena, and
+ * moves the elements of a run when it is moved.
+ *
+ * Run capacities are powers of two and the numbers half way between them,
+ * starting at 4.  A full run grows to the next capacity, in place when it
+ * is the last run in the arena, and otherwise by moving to a new run.
+ * Released runs are kept in a free list per capacity and handed out again
+ * before the arena grows.  Freeing everything is O(1), since the arenas and
+ * free lists are a fixed number of flat arrays.
+ *
+ * When many lists grow at the same pace, the runs they leave behind are
+ * rarely reused.  Once fragmented() says so, the owner should move all of
+ * its runs to the front of the arena, in order of offset, and then call
+ * packed().  The released space pays for the compaction, so it is cheap
+ * when amortized over the releases.
+ */
+class RunAllocator {
+public:
+  RunAllocator() : size_(0u), freeSize_(0u) {}
+
+  /**
+   * Forget all runs.
+   */
+  void clear();
+
+  /**
+   * Length of the arena, which all arena arrays must be resized to.
+   */
+  size_t size() const { return size_; }
+
+  /**
+   * Makes room for one more element at the end of the run, so that the
+   * element run.offset + run.size may be written, after resizing the arena
+   * arrays to size().
+   *
+   * @returns the offset of the run before this call.  If it differs from
+   * run.offset, the run has moved and the owner must copy the run.size
+   * elements at the old offset to the new one.  The old run is already
+   * released, but is not reused before the next call.
+   */
+  UInt32 grow(Run &run);
+
+  /**
+   * Makes room for at least capacity elements in the run, in one step
+   * instead of growing it one element at a time.  Same contract as grow().
+   */
+  UInt32 reserve(Run &run, UInt32 capacity);
+
+  /**
+   * Releases the run for reuse.  The run is left empty, with no capacity.
+   */
+  void release(Run &run);
+
+  /**
+   * True if the released runs take up enough of the arena that compacting
+   * it is worth the cost.
+   *
+   * @param numRuns Number of runs the owner must visit to compact the arena.
+   */
+  bool fragmented(size_t numRuns) const;
+
+  /**
+   * Forgets all released runs, after the owner moved its runs to the front
+   * of the arena.
+   *
+   * @param size The new length of the arena: the end of the last run.
+   */
+  void packed(size_t size);
+
+  /**
+   * Offsets of the released runs, one list per size class (the index of
+   * their capacity in the sequence above).  For serialization, together
+   * with size().
+   */
+  const std::vector<std::vector<UInt32>> &freeRuns() const { return freeRuns_; }
+  // Throws if a size class does not exist, if a released run does not fit in
+  // the arena, or if two overlap.
+  void restore(size_t size, const std::vector<std::vector<UInt32>> &freeRuns);
+
+  /**
+   * Throws unless the given runs and the released runs lie within the arena
+   * and do not overlap, so that growing one run can never overwrite another,
+   * and unless every run has one of the capacities above.  For checking the
+   * runs of a restored allocator.  Runs without capacity are skipped.
+   */
+  void check(const std::vector<Run> &runs) const;
+
+private:
+  UInt32 allocate_(UInt32 capacity);
+  UInt32 resize_(Run &run, UInt32 capacity);
+
+  size_t size_;
+  size_t freeSize_; // Total capacity of the released runs.
+  std::vector<std::vector<UInt32>> freeRuns_;
+};
+
+} // end namespace util
+} // end namespace nupic
+
+#endif // NUPIC_UTIL_RUN_ALLOCATOR_HPP
@@ -0,0 +1,126 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2019, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of ThreadPool
+ */
+
+#include <nupic/utils/ThreadPool.hpp>
+#include <nupic/utils/Log.hpp>
+
+using namespace std;
+using namespace nupic;
+using namespace nupic::util;
+
+
+ThreadPool::ThreadPool(UInt numThreads)
+    : numThreads_(numThreads == 0u ? 1u : numThreads) {
+  threads_.reserve(numThreads_ - 1u);
+  for (UInt worker = 1u; worker < numThreads_; worker++) {
+    threads_.emplace_back(&ThreadPool::workerLoop_, this, worker);
+  }
+}
+
+
+ThreadPool::~ThreadPool() {
+  {
+    lock_guard<mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_.notify_all();
+  for (auto &t : threads_) {
+    t.join();
+  }
+}
+
+
+void ThreadPool::range(size_t n, UInt worker, size_t &begin, size_t &end) const {
+  NTA_ASSERT(worker < numThreads_);
+  const size_t chunk = (n + numThreads_ - 1u) / numThreads_;
+  begin = min(n, chunk * worker);
+  end   = min(n, begin + chunk);
+}
+
+
+void ThreadPool::parallelFor(size_t n, const RangeFunction &fn) {
+  if (n == 0u) return;
+  if (numThreads_ == 1u || n == 1u) {
+    fn(0u, n, 0u);
+    return;
+  }
+
+  lock_guard<mutex> loop(loop_);
+  {
+    lock_guard<mutex> lock(mutex_);
+    n_       = n;
+    fn_      = &fn;
+    error_   = nullptr;
+    pending_ = numThreads_ - 1u;
+    generation_++;
+  }
+  start_.notify_all();
+
+  runRange_(0u);
+
+  unique_lock<mutex> lock(mutex_);
+  done_.wait(lock, [this] { return pending_ == 0u; });
+  fn_ = nullptr;
+  if (error_) {
+    exception_ptr error = error_;
+    error_ = nullptr;
+    rethrow_exception(error);
+  }
+}
+
+
+void ThreadPool::runRange_(UInt worker) {
+  size_t begin, end;
+  range(n_, worker, begin, end);
+  if (begin >= end) return;
+  try {
+    (*fn_)(begin, end, worker);
+  } catch (...) {
+    lock_guard<mutex> lock(mutex_);
+    if (!error_) error_ = current_exception();
+  }
+}
+
+
+void ThreadPool::workerLoop_(UInt worker) {
+  UInt64 seen = 0u;
+  while (true) {
+    {
+      unique_lock<mutex> lock(mutex_);
+      start_.wait(lock, [&] { return stop_ || generation_ != seen; });
+      if (stop_) return;
+      seen = generation_;
+    }
+
+    runRange_(worker);
+
+    {
+      lock_guard<mutex> lock(mutex_);
+      pending_--;
+      if (pending_ == 0u) done_.notify_one();
+    }
+  }
+}
@@ -0,0 +1,113 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2019, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definition of a small fork-join thread pool
+ */
+
+#ifndef NUPIC_UTIL_THREAD_POOL_HPP
+#define NUPIC_UTIL_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <nupic/types/Types.hpp>
+
+namespace nupic {
+namespace util {
+
+/**
+ * Fixed size pool of worker threads for data parallel loops.
+ *
+ * The calling thread takes part in every loop as worker 0, so a pool of size
+ * 1 starts no threads at all and runs everything inline.  Work is split into
+ * contiguous, equally sized ranges, and range i is always given to worker i.
+ * Algorithms can therefore keep per-worker scratch buffers and merge them in
+ * worker order to get results which do not depend on thread timing.
+ *
+ * A pool runs one loop at a time.  Loops submitted from several threads are
+ * run one after the other, so a pool can be shared, but fn must not start
+ * another loop on the same pool.
+ */
+class ThreadPool {
+public:
+  /**
+   * Function called on each range: fn(begin, end, worker).
+   */
+  typedef std::function<void(size_t, size_t, UInt)> RangeFunction;
+
+  /**
+   * @param numThreads Total number of threads which run a loop, including the
+   *        calling thread.  Zero is treated as one.
+   */
+  explicit ThreadPool(UInt numThreads = 1u);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * Number of threads which run a loop, including the calling thread.
+   */
+  UInt size() const { return numThreads_; }
+
+  /**
+   * Split [0, n) into size() contiguous ranges and call fn once per non-empty
+   * range, in parallel.  Blocks until every range is done.  If fn throws, the
+   * first exception is rethrown here once all workers have stopped.
+   */
+  void parallelFor(size_t n, const RangeFunction &fn);
+
+  /**
+   * The range [begin, end) given to the worker when splitting n items.
+   */
+  void range(size_t n, UInt worker, size_t &begin, size_t &end) const;
+
+private:
+  void workerLoop_(UInt worker);
+  void runRange_(UInt worker);
+
+  const UInt numThreads_;
+  std::vector<std::thread> threads_;
+
+  std::mutex loop_;  // held for the duration of a parallelFor
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  UInt64 generation_ = 0u;
+  UInt pending_ = 0u;
+  bool stop_ = false;
+
+  // The loop currently being run.
+  size_t n_ = 0u;
+  const RangeFunction *fn_ = nullptr;
+  std::exception_ptr error_;
+};
+
+} // end namespace util
+} // end namespace nupic
+
+#endif // NUPIC_UTIL_THREAD_POOL_HPP
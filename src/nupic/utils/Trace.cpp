@@ -0,0 +1,202 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2019, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of Trace
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <nupic/utils/Trace.hpp>
+
+using namespace std;
+using namespace nupic;
+using namespace nupic::util;
+
+std::atomic<bool> Trace::enabled_(false);
+
+namespace {
+
+const chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+
+// The events of one thread, oldest first once the buffer has wrapped around
+// at next.  The lock is only contended while writing or clearing the trace.
+struct ThreadBuffer {
+  mutex lock;
+  vector<Trace::Event> events;
+  size_t capacity;
+  size_t next = 0u;
+  UInt32 thread;
+};
+
+// Every thread's buffer, kept after the thread exits.
+struct Registry {
+  mutex lock;
+  vector<shared_ptr<ThreadBuffer>> buffers;
+  size_t capacity = 65536u;
+};
+
+Registry &registry() {
+  static Registry instance;
+  return instance;
+}
+
+ThreadBuffer &localBuffer() {
+  thread_local shared_ptr<ThreadBuffer> buffer;
+  if (!buffer) {
+    Registry &reg = registry();
+    lock_guard<mutex> guard(reg.lock);
+    buffer = make_shared<ThreadBuffer>();
+    buffer->capacity = reg.capacity;
+    buffer->thread = (UInt32)reg.buffers.size();
+    reg.buffers.push_back(buffer);
+  }
+  return *buffer;
+}
+
+void writeJsonString(ostream &out, const char *text) {
+  out << '"';
+  for (const char *c = text; *c != '\0'; c++) {
+    if (*c == '"' || *c == '\\')
+      out << '\\' << *c;
+    else if ((unsigned char)*c < 0x20u)
+      out << "\\u" << hex << setw(4) << setfill('0') << (int)*c << dec << setfill(' ');
+    else
+      out << *c;
+  }
+  out << '"';
+}
+
+// Nanoseconds to the microseconds of the trace format.
+void writeMicroseconds(ostream &out, UInt64 ns) {
+  out << ns / 1000u << '.' << setw(3) << setfill('0') << ns % 1000u << setfill(' ');
+}
+
+} // namespace
+
+
+void Trace::enable(size_t eventsPerThread) {
+  eventsPerThread = std::max<size_t>(eventsPerThread, 1u);
+  Registry &reg = registry();
+  {
+    lock_guard<mutex> guard(reg.lock);
+    if (eventsPerThread != reg.capacity) {
+      reg.capacity = eventsPerThread;
+      for (const auto &buffer : reg.buffers) {
+        lock_guard<mutex> bufferGuard(buffer->lock);
+        buffer->events.clear();
+        buffer->events.shrink_to_fit();
+        buffer->capacity = eventsPerThread;
+        buffer->next = 0u;
+      }
+    }
+  }
+  enabled_.store(true);
+}
+
+
+void Trace::disable() { enabled_.store(false); }
+
+
+void Trace::clear() {
+  Registry &reg = registry();
+  lock_guard<mutex> guard(reg.lock);
+  for (const auto &buffer : reg.buffers) {
+    lock_guard<mutex> bufferGuard(buffer->lock);
+    buffer->events.clear();
+    buffer->next = 0u;
+  }
+}
+
+
+UInt64 Trace::now() {
+  return (UInt64)chrono::duration_cast<chrono::nanoseconds>(
+             chrono::steady_clock::now() - epoch).count();
+}
+
+
+void Trace::record(const Event &event) {
+  ThreadBuffer &buffer = localBuffer();
+  lock_guard<mutex> guard(buffer.lock);
+  if (buffer.events.size() < buffer.capacity) {
+    buffer.events.push_back(event);
+  } else {
+    buffer.events[buffer.next] = event;
+    buffer.next = (buffer.next + 1u) % buffer.capacity;
+  }
+}
+
+
+void Trace::writeJson(ostream &out) {
+  Registry &reg = registry();
+  lock_guard<mutex> guard(reg.lock);
+  out << "{\"traceEvents\":[";
+  bool first = true;
+  for (const auto &buffer : reg.buffers) {
+    lock_guard<mutex> bufferGuard(buffer->lock);
+    const size_t size = buffer->events.size();
+    for (size_t i = 0u; i < size; i++) {
+      const Event &event = buffer->events[(buffer->next + i) % size];
+      out << (first ? "\n" : ",\n");
+      first = false;
+      out << "{\"name\":";
+      if (event.object[0] != '\0') {
+        const string name = string(event.object) + "." + event.name;
+        writeJsonString(out, name.c_str());
+      } else {
+        writeJsonString(out, event.name);
+      }
+      out << ",\"cat\":";
+      writeJsonString(out, event.category);
+      out << ",\"ph\":\"X\",\"ts\":";
+      writeMicroseconds(out, event.start);
+      out << ",\"dur\":";
+      writeMicroseconds(out, event.duration);
+      out << ",\"pid\":1,\"tid\":" << buffer->thread << "}";
+    }
+  }
+  out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+
+void TraceScope::begin_(const char *category, const char *name, const char *object) {
+  event_.category = category;
+  event_.name = name;
+  event_.object[0] = '\0';
+  if (object != nullptr) {
+    strncpy(event_.object, object, sizeof(event_.object) - 1u);
+    event_.object[sizeof(event_.object) - 1u] = '\0';
+  }
+  event_.start = Trace::now();
+}
+
+
+void TraceScope::end_() {
+  event_.duration = Trace::now() - event_.start;
+  Trace::record(event_);
+}
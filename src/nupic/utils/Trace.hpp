@@ -0,0 +1,148 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2019, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definition of timeline tracing in the Chrome trace event format
+ */
+
+#ifndef NUPIC_UTIL_TRACE_HPP
+#define NUPIC_UTIL_TRACE_HPP
+
+#include <atomic>
+#include <ostream>
+#include <string>
+
+#include <nupic/types/Types.hpp>
+
+namespace nupic {
+namespace util {
+
+/**
+ * Records when each step of a computation started and how long it took, and
+ * writes them as a Chrome trace, which chrome://tracing and
+ * https://ui.perfetto.dev display as a timeline per thread.
+ *
+ * Usage:
+ *   Trace::enable();
+ *   net.run(1000);
+ *   Trace::disable();
+ *   std::ofstream file("trace.json");
+ *   Trace::writeJson(file);
+ *
+ * Events are recorded by TraceScope.  The Network records every iteration of
+ * run(), the regions record prepareInputs and compute, the links record their
+ * copies, and the SpatialPooler and TemporalMemory record their phases.
+ *
+ * Each thread records into its own ring buffer, which keeps the most recent
+ * events when it is full.  While tracing is disabled a TraceScope only reads
+ * one atomic flag.
+ */
+class Trace {
+public:
+  /**
+   * One timed step.  category and name must be string literals, object is a
+   * copy, truncated to fit.
+   */
+  struct Event {
+    const char *category;
+    const char *name;
+    char object[32];
+    UInt64 start;    // nanoseconds since the program started
+    UInt64 duration; // nanoseconds
+  };
+
+  /**
+   * Start recording.  Discards the recorded events if the size of the
+   * buffers changes.
+   *
+   * @param eventsPerThread Size of each thread's ring buffer.
+   */
+  static void enable(size_t eventsPerThread = 65536u);
+
+  /** Stop recording, and keep the recorded events. */
+  static void disable();
+
+  static bool isEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  /** Discard the recorded events. */
+  static void clear();
+
+  /**
+   * Write the recorded events as a Chrome trace JSON object.  Threads may
+   * keep recording meanwhile.
+   */
+  static void writeJson(std::ostream &out);
+
+  /** Nanoseconds since the program started. */
+  static UInt64 now();
+
+  /** Add an event to the calling thread's buffer. */
+  static void record(const Event &event);
+
+private:
+  static std::atomic<bool> enabled_;
+};
+
+/**
+ * Records the lifetime of this object as one Trace event, if tracing is
+ * enabled when it is created.
+ *
+ * Usage:
+ *   {
+ *     TraceScope scope("spatial_pooler", "inhibit");
+ *     ...
+ *   }
+ */
+class TraceScope {
+public:
+  TraceScope(const char *category, const char *name)
+      : active_(Trace::isEnabled()) {
+    if (active_)
+      begin_(category, name, nullptr);
+  }
+
+  TraceScope(const char *category, const char *name, const std::string &object)
+      : active_(Trace::isEnabled()) {
+    if (active_)
+      begin_(category, name, object.c_str());
+  }
+
+  ~TraceScope() {
+    if (active_)
+      end_();
+  }
+
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+  void begin_(const char *category, const char *name, const char *object);
+  void end_();
+
+  const bool active_;
+  Trace::Event event_;
+};
+
+} // namespace util
+} // namespace nupic
+
+#endif // NUPIC_UTIL_TRACE_HPP
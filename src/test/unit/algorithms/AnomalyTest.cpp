@@ -21,6 +21,7 @@
  */
 
 #include <algorithm>
+#include <cmath>
 #include <vector>
 #include <sstream>
 
@@ -28,6 +29,7 @@
 
 #include "nupic/algorithms/Anomaly.hpp"
 #include "nupic/types/Types.hpp"
+#include "nupic/utils/Random.hpp"
 
 namespace testing {
 
@@ -194,4 +196,78 @@ TEST(AnomalyLikelihood, SerializationLikelihood)
   EXPECT_EQ(a, b);
 }
 
+
+/**
+ * The likelihood is computed from running sums over the historic window.
+ * These reference values were produced by the original implementation,
+ * which recomputed the statistics over the whole window on every step.
+ */
+TEST(AnomalyLikelihood, MatchesFullWindowComputation)
+{
+  AnomalyLikelihood al(288, 100, 1000, 100, 10);
+  AnomalyLikelihood alDefault;
+  Random rng(42);
+  const std::vector<std::vector<Real>> expected = {
+    // step, likelihood, likelihood with default parameters
+    {  400, 0.5f,         0.5f },
+    { 1500, 0.793374836f, 0.999992788f },
+    { 5050, 0.500027776f, 0.999996185f },
+    { 5200, 0.500017047f, 0.999996185f },
+    {20000, 0.500044823f, 0.500124216f },
+  };
+  size_t next = 0;
+  for(int i = 0; i <= 20000; i++) {
+    Real score = (Real)rng.getReal64();
+    if(i % 7 == 0) score *= 0.1f;
+    if(i > 5000 && i < 5100) score = 0.99f;
+    const Real l1 = al.anomalyProbability(score);
+    const Real l2 = alDefault.anomalyProbability(score * 0.5f);
+    if(i == (int)expected[next][0]) {
+      EXPECT_NEAR(l1, expected[next][1], 1e-6f) << "step " << i;
+      EXPECT_NEAR(l2, expected[next][2], 1e-6f) << "step " << i;
+      next++;
+    }
+  }
+  ASSERT_EQ(next, expected.size());
+}
+
+
+/**
+ * A long stream of bursts followed by a constant score has zero variance
+ * over most windows.  The running sums must not drift into a negative
+ * variance, which would make the likelihood NaN.
+ */
+TEST(AnomalyLikelihood, ConstantStreamStaysFinite)
+{
+  AnomalyLikelihood al(50, 20, 100, 10, 5);
+  for(int i = 0; i < 100000; i++) {
+    const Real score = (i % 1000 < 100) ? 0.97f : 0.1f;
+    const Real likelihood = al.anomalyProbability(score);
+    ASSERT_FALSE(std::isnan(likelihood)) << "step " << i;
+    ASSERT_GE(likelihood, 0.0f) << "step " << i;
+    ASSERT_LE(likelihood, 1.0f) << "step " << i;
+  }
+}
+
+
+TEST(AnomalyLikelihood, SerializationContinues)
+{
+  AnomalyLikelihood a(50, 20, 200, 30, 5);
+  AnomalyLikelihood b(50, 20, 200, 30, 5);
+  Random rng(1);
+  for(int i = 0; i < 500; i++) {
+    a.anomalyProbability((Real)rng.getReal64());
+  }
+
+  std::stringstream ss;
+  a.saveToStream_ar(ss);
+  b.loadFromStream_ar(ss);
+
+  // The restored instance must rebuild its running statistics.
+  for(int i = 0; i < 500; i++) {
+    const Real score = (Real)rng.getReal64();
+    ASSERT_FLOAT_EQ(a.anomalyProbability(score), b.anomalyProbability(score));
+  }
+}
+
 }
\ No newline at end of file
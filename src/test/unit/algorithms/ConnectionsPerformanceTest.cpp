@@ -32,6 +32,8 @@
 #include <nupic/algorithms/SpatialPooler.hpp>
 #include <nupic/algorithms/TemporalMemory.hpp>
 #include <nupic/algorithms/Anomaly.hpp>
+#include <nupic/math/Simd.hpp>
+#include <nupic/math/Topology.hpp>
 #include <nupic/utils/Random.hpp>
 #include <nupic/os/Timer.hpp>
 #include <nupic/types/Types.hpp> // macro "UNUSED"
@@ -45,6 +47,8 @@ using namespace nupic::algorithms::connections;
 using ::nupic::algorithms::spatial_pooler::SpatialPooler;
 using ::nupic::algorithms::temporal_memory::TemporalMemory;
 using namespace nupic::algorithms::anomaly;
+namespace simd = nupic::math::simd;
+using namespace nupic::math::topology;
 
 #define SEED 42
 
@@ -152,6 +156,171 @@ float runSpatialPoolerTest(
 
 
 
+/**
+ * Microbenchmark of the segment learning methods, against the previous
+ * implementation which updated one synapse at a time.
+ */
+float runAdaptSegmentTest(UInt numSegments, UInt numSynapses, UInt rounds) {
+  const UInt numInputs = 4 * numSynapses;
+  Connections fast(numSegments), slow(numSegments);
+  for (UInt cell = 0; cell < numSegments; cell++) {
+    const auto a = fast.createSegment(cell);
+    const auto b = slow.createSegment(cell);
+    for (UInt i = 0; i < numSynapses; i++) {
+      const Permanence p = (Permanence)rng.getReal64();
+      fast.createSynapse(a, i * 4, p);
+      slow.createSynapse(b, i * 4, p);
+    }
+  }
+  vector<SDR> inputs(16, SDR({numInputs}));
+  for (auto &input : inputs) {
+    input.randomize(0.25f, rng);
+  }
+
+  Timer fastTimer, slowTimer;
+  for (UInt round = 0; round < rounds; round++) {
+    const SDR &input = inputs[round % inputs.size()];
+    fastTimer.start();
+    for (Segment seg = 0; seg < numSegments; seg++) {
+      fast.adaptSegment(seg, input, 0.05f, 0.03f);
+      fast.raisePermanencesToThreshold(seg, numSynapses / 2);
+    }
+    fastTimer.stop();
+
+    slowTimer.start();
+    const auto &dense = input.getDense();
+    for (Segment seg = 0; seg < numSegments; seg++) {
+      for (const auto syn : slow.synapsesForSegment(seg)) {
+        const auto &data = slow.dataForSynapse(syn);
+        slow.updateSynapsePermanence(syn, data.permanence +
+            (dense[data.presynapticCell] ? 0.05f : -0.03f));
+      }
+      slow.raisePermanencesToThreshold(seg, numSynapses / 2);
+    }
+    slowTimer.stop();
+  }
+  EXPECT_EQ(fast, slow);
+  cout << (float)fastTimer.getElapsed() << " in adaptSegment ("
+       << simd::name(simd::best()) << "), "
+       << (float)slowTimer.getElapsed() << " per synapse" << endl;
+
+  // The kernel alone, for each instruction set.
+  vector<Real32> values(numSynapses), deltas(numSynapses);
+  for (UInt i = 0; i < numSynapses; i++) {
+    deltas[i] = (i % 3 == 0) ? 0.05f : -0.03f;
+  }
+  for (const auto isa : {simd::Isa::SCALAR, simd::Isa::SSE2, simd::Isa::AVX}) {
+    if (!simd::supported(isa)) continue;
+    std::fill(values.begin(), values.end(), 0.5f);
+    Timer timer(true);
+    for (UInt round = 0; round < rounds * numSegments; round++) {
+      simd::addClamped(values.data(), deltas.data(), values.size(), 0.0f, 1.0f, isa);
+    }
+    timer.stop();
+    cout << (float)timer.getElapsed() << " in addClamped (" << simd::name(isa) << ")" << endl;
+  }
+  return (float)fastTimer.getElapsed();
+}
+
+
+
+/**
+ * Times local inhibition by scanning each neighborhood against counting
+ * neighbors by rank, over a sweep of inhibition radii.  Returns the total
+ * time in the method which SpatialPooler picks for each radius.
+ */
+float runLocalInhibitionTest(const vector<UInt> &columnDimensions,
+                             const vector<UInt> &radii, UInt rounds) {
+  using LocalInhibition = SpatialPooler::LocalInhibition;
+  SpatialPooler sp(
+      /*inputDimensions*/ columnDimensions,
+      /*columnDimensions*/ columnDimensions,
+      /*potentialRadius*/ 1,
+      /*potentialPct*/ 0.5f,
+      /*globalInhibition*/ false,
+      /*localAreaDensity*/ 0.05f,
+      /*numActiveColumnsPerInhArea*/ -1);
+  vector<vector<Real>> overlaps(4, vector<Real>(sp.getNumColumns()));
+  for (auto &overlap : overlaps) {
+    for (auto &x : overlap) {
+      x = (Real)rng.getUInt32(40u) * (Real)(0.5 + rng.getReal64());
+    }
+  }
+
+  float total = 0.0f;
+  vector<UInt> scanned, ranked, picked;
+  for (const UInt radius : radii) {
+    sp.setInhibitionRadius(radius);
+    Timer scanTimer, rankTimer, autoTimer;
+    for (UInt round = 0; round < rounds; round++) {
+      const auto &overlap = overlaps[round % overlaps.size()];
+      scanTimer.start();
+      sp.inhibitColumnsLocal_(overlap, 0.05f, scanned, LocalInhibition::Scan);
+      scanTimer.stop();
+      rankTimer.start();
+      sp.inhibitColumnsLocal_(overlap, 0.05f, ranked, LocalInhibition::Rank);
+      rankTimer.stop();
+      autoTimer.start();
+      sp.inhibitColumnsLocal_(overlap, 0.05f, picked);
+      autoTimer.stop();
+      EXPECT_EQ(scanned, ranked);
+    }
+    cout << "local inhibition, " << columnDimensions.size() << "-D, radius "
+         << radius << ": " << (float)scanTimer.getElapsed() << " scan, "
+         << (float)rankTimer.getElapsed() << " rank, "
+         << (float)autoTimer.getElapsed() << " auto" << endl;
+    total += (float)autoTimer.getElapsed();
+  }
+  return total;
+}
+
+
+/**
+ * Times visiting every neighborhood with the Neighborhood iterators against a
+ * NeighborhoodTable.  Returns the time with the table.
+ */
+float runNeighborhoodTest(const vector<UInt> &dimensions, UInt radius,
+                          bool wrapAround, UInt rounds) {
+  UInt size = 1;
+  for (const auto dim : dimensions) {
+    size *= dim;
+  }
+  UInt64 iterated = 0;
+  UInt64 tabulated = 0;
+  Timer iteratorTimer(true);
+  for (UInt round = 0; round < rounds; round++) {
+    for (UInt center = 0; center < size; center++) {
+      if (wrapAround) {
+        for (const auto neighbor : WrappingNeighborhood(center, radius, dimensions)) {
+          iterated += neighbor;
+        }
+      } else {
+        for (const auto neighbor : Neighborhood(center, radius, dimensions)) {
+          iterated += neighbor;
+        }
+      }
+    }
+  }
+  iteratorTimer.stop();
+
+  Timer tableTimer(true);
+  const NeighborhoodTable table(radius, dimensions, wrapAround);
+  for (UInt round = 0; round < rounds; round++) {
+    for (UInt center = 0; center < size; center++) {
+      table.forEach(center, [&](UInt neighbor) { tabulated += neighbor; });
+    }
+  }
+  tableTimer.stop();
+
+  EXPECT_EQ(iterated, tabulated);
+  cout << "neighborhoods, " << dimensions.size() << "-D, radius " << radius
+       << (wrapAround ? ", wrapping: " : ": ")
+       << (float)iteratorTimer.getElapsed() << " iterator, "
+       << (float)tableTimer.getElapsed() << " table" << endl;
+  return (float)tableTimer.getElapsed();
+}
+
+
 // TESTS
 #if defined( NDEBUG) && !defined(NTA_OS_WINDOWS)
   const UInt COLS 	= 2048; //standard num of columns in SP/TM
@@ -206,4 +375,34 @@ TEST(ConnectionsPerformanceTest, testSP) {
   UNUSED(tim);
 }
 
+/**
+ * Microbenchmark of Connections::adaptSegment & raisePermanencesToThreshold.
+ */
+TEST(ConnectionsPerformanceTest, testAdaptSegment) {
+  auto tim = runAdaptSegmentTest(COLS, 8 * W, 2 * EPOCHS);
+  UNUSED(tim);
+}
+
+/**
+ * Local inhibition over a sweep of inhibition radii, for 1-D and 2-D
+ * topologies.
+ */
+TEST(ConnectionsPerformanceTest, testLocalInhibition) {
+  const vector<UInt> radii = {1, 2, 4, 8, 16, 32};
+  auto tim = runLocalInhibitionTest({COLS * 2}, radii, EPOCHS / 4);
+  tim += runLocalInhibitionTest({COLS / 32, 64}, radii, EPOCHS / 4);
+  UNUSED(tim);
+}
+
+/**
+ * Microbenchmark of the Neighborhood iterators against NeighborhoodTable.
+ */
+TEST(ConnectionsPerformanceTest, testNeighborhoods) {
+  auto tim = runNeighborhoodTest({COLS * 2}, 16, false, EPOCHS);
+  tim += runNeighborhoodTest({64, 64}, 4, false, EPOCHS);
+  tim += runNeighborhoodTest({64, 64}, 4, true, EPOCHS);
+  tim += runNeighborhoodTest({16, 16, 16}, 2, true, EPOCHS);
+  UNUSED(tim);
+}
+
 } // end namespace
@@ -25,8 +25,11 @@
  */
 
 #include "gtest/gtest.h"
+#include <cstddef>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <numeric>
 #include <nupic/algorithms/Connections.hpp>
 
 namespace testing {
@@ -137,6 +140,55 @@ TEST(ConnectionsTest, testCreateSynapse) {
   ASSERT_NEAR((Permanence)0.48, synapseData2.permanence, EPSILON);
 }
 
+/**
+ * Creating a segment's synapses in bulk gives the same connections as creating
+ * them one at a time, and the same activity.
+ */
+TEST(ConnectionsTest, testCreateSynapses) {
+  Connections bulk(1024);
+  Connections single(1024);
+  const vector<CellIdx> presynapticCells = {3, 50, 51, 150, 1000};
+  const vector<Permanence> permanences = {0.85f, 0.15f, 1.5f, 0.5f, -1.0f};
+
+  // Also covers a segment whose synapses move when its run grows.
+  const Segment other = bulk.createSegment(20);
+  bulk.createSynapse(other, 7, 0.6f);
+  const Segment segment = bulk.createSegment(10, presynapticCells, permanences);
+  bulk.createSynapses(other, presynapticCells, permanences);
+
+  const Segment otherSingle = single.createSegment(20);
+  single.createSynapse(otherSingle, 7, 0.6f);
+  const Segment segmentSingle = single.createSegment(10);
+  for (size_t i = 0; i < presynapticCells.size(); i++) {
+    single.createSynapse(segmentSingle, presynapticCells[i], permanences[i]);
+  }
+  for (size_t i = 0; i < presynapticCells.size(); i++) {
+    single.createSynapse(otherSingle, presynapticCells[i], permanences[i]);
+  }
+  ASSERT_EQ(single, bulk);
+  ASSERT_EQ(3u, bulk.dataForSegment(segment).numConnected);
+  ASSERT_EQ(4u, bulk.dataForSegment(other).numConnected);
+
+  const vector<Synapse> synapses = bulk.synapsesForSegment(segment);
+  ASSERT_EQ(presynapticCells.size(), synapses.size());
+  for (size_t i = 0; i < synapses.size(); i++) {
+    ASSERT_EQ(segment, bulk.segmentForSynapse(synapses[i]));
+    ASSERT_EQ(presynapticCells[i], bulk.dataForSynapse(synapses[i]).presynapticCell);
+  }
+
+  const vector<CellIdx> input = {3, 7, 51, 150, 1000};
+  vector<SynapseIdx> connectedBulk(bulk.segmentFlatListLength(), 0);
+  vector<SynapseIdx> potentialBulk(bulk.segmentFlatListLength(), 0);
+  bulk.computeActivity(connectedBulk, potentialBulk, input);
+  vector<SynapseIdx> connectedSingle(single.segmentFlatListLength(), 0);
+  vector<SynapseIdx> potentialSingle(single.segmentFlatListLength(), 0);
+  single.computeActivity(connectedSingle, potentialSingle, input);
+  ASSERT_EQ(connectedSingle, connectedBulk);
+  ASSERT_EQ(potentialSingle, potentialBulk);
+  ASSERT_EQ(3u, connectedBulk[segment]);
+  ASSERT_EQ(4u, potentialBulk[segment]);
+}
+
 /**
  * Creates a segment, destroys it, and makes sure it got destroyed along with
  * all of its synapses.
@@ -364,6 +416,89 @@ TEST(ConnectionsTest, testComputeActivity) {
   ASSERT_EQ(3ul, numActivePotentialSynapsesForSegment[segment2_1]);
 }
 
+/**
+ * The touched-segment overload only reports segments with an active synapse,
+ * and resets only the counters of the segments it reported last time.
+ */
+TEST(ConnectionsTest, testComputeActivityTouchedSegments) {
+  Connections connections(1024);
+  setupSampleConnections(connections);
+  const Segment segment1_1 = connections.getSegment(10, 0);
+  const Segment segment2_1 = connections.getSegment(20, 0);
+  const Segment segment2_2 = connections.getSegment(20, 1);
+  const Segment segment3_1 = connections.getSegment(30, 0);
+
+  vector<SynapseIdx> numConnected(connections.segmentFlatListLength(), 0);
+  vector<SynapseIdx> numPotential(connections.segmentFlatListLength(), 0);
+  vector<Segment> touched;
+  connections.computeActivity(numConnected, numPotential, touched,
+                              {80, 81, 82, 150});
+  sort(touched.begin(), touched.end());
+  ASSERT_EQ(vector<Segment>({segment1_1, segment2_1}), touched);
+  ASSERT_EQ(1ul, numConnected[segment1_1]);
+  ASSERT_EQ(1ul, numPotential[segment1_1]);
+  ASSERT_EQ(2ul, numConnected[segment2_1]);
+  ASSERT_EQ(3ul, numPotential[segment2_1]);
+
+  // A new segment extends the vectors with zeros.
+  const Segment segment4_1 = connections.createSegment(40);
+  connections.createSynapse(segment4_1, 53, 0.85f);
+  numConnected.resize(connections.segmentFlatListLength(), 0);
+  numPotential.resize(connections.segmentFlatListLength(), 0);
+
+  // The previous counts are cleared without clearing the vectors.
+  connections.computeActivity(numConnected, numPotential, touched, {52, 53});
+  sort(touched.begin(), touched.end());
+  ASSERT_EQ(vector<Segment>({segment2_2, segment3_1, segment4_1}), touched);
+
+  vector<SynapseIdx> expectedConnected(numConnected.size(), 0);
+  vector<SynapseIdx> expectedPotential(numPotential.size(), 0);
+  connections.computeActivity(expectedConnected, expectedPotential, {52, 53});
+  ASSERT_EQ(expectedConnected, numConnected);
+  ASSERT_EQ(expectedPotential, numPotential);
+  ASSERT_EQ(0ul, numConnected[segment2_2]);
+  ASSERT_EQ(2ul, numPotential[segment2_2]);
+  ASSERT_EQ(1ul, numConnected[segment4_1]);
+}
+
+/**
+ * The presynaptic index is indexed by cell. Make sure that active inputs which
+ * have never had a synapse (including ones beyond numCells) are ignored, and
+ * that the index stays consistent as synapses move between the connected and
+ * potential lists.
+ */
+TEST(ConnectionsTest, testPresynapticIndex) {
+  Connections connections(10);
+  const Segment segment = connections.createSegment(5);
+  const Synapse syn1 = connections.createSynapse(segment, 3,    0.85f);
+  const Synapse syn2 = connections.createSynapse(segment, 2000, 0.15f);
+
+  ASSERT_EQ(vector<Synapse>({syn1}), connections.synapsesForPresynapticCell(3));
+  ASSERT_EQ(vector<Synapse>({syn2}), connections.synapsesForPresynapticCell(2000));
+  ASSERT_TRUE(connections.synapsesForPresynapticCell(4).empty());
+  ASSERT_TRUE(connections.synapsesForPresynapticCell(5000).empty());
+
+  vector<SynapseIdx> numConnected(connections.segmentFlatListLength(), 0);
+  vector<SynapseIdx> numPotential(connections.segmentFlatListLength(), 0);
+  connections.computeActivity(numConnected, numPotential, {1, 3, 2000, 5000});
+  ASSERT_EQ(1ul, numConnected[segment]);
+  ASSERT_EQ(2ul, numPotential[segment]);
+
+  connections.updateSynapsePermanence(syn1, 0.1f);
+  connections.updateSynapsePermanence(syn2, 0.9f);
+  fill(numConnected.begin(), numConnected.end(), 0);
+  connections.computeActivity(numConnected, numPotential, {2000});
+  ASSERT_EQ(1ul, numConnected[segment]);
+  ASSERT_EQ(1ul, numPotential[segment]);
+
+  connections.destroySynapse(syn2);
+  ASSERT_TRUE(connections.synapsesForPresynapticCell(2000).empty());
+  fill(numConnected.begin(), numConnected.end(), 0);
+  connections.computeActivity(numConnected, numPotential, {3, 2000});
+  ASSERT_EQ(0ul, numConnected[segment]);
+  ASSERT_EQ(1ul, numPotential[segment]);
+}
+
 TEST(ConnectionsTest, testAdaptSynapses) {
   UInt numCells = 4;
   // NOTE: One segment per cell.
@@ -676,6 +811,261 @@ TEST(ConnectionsTest, testSaveLoad) {
   ASSERT_EQ(c1, c2);
 }
 
+/**
+ * A checkpoint restores the exact state, including destroyed segments and
+ * synapses waiting to be reused, so both copies keep evolving identically.
+ */
+TEST(ConnectionsTest, testCheckpoint) {
+  Connections c1(1024), c2;
+  setupSampleConnections(c1);
+
+  auto segment = c1.createSegment(10);
+  c1.createSynapse(segment, 400, 0.5);
+  c1.destroySegment(segment);
+  c1.destroySynapse(c1.synapsesForSegment(c1.segmentsForCell(20)[0])[0]);
+
+  computeSampleActivity(c1);
+
+  stringstream ss;
+  c1.saveCheckpoint(ss);
+  c2.loadCheckpoint(ss);
+
+  ASSERT_EQ(c1, c2);
+  EXPECT_EQ(c1.numSegments(), c2.numSegments());
+  EXPECT_EQ(c1.numSynapses(), c2.numSynapses());
+  EXPECT_EQ(c1.segmentFlatListLength(), c2.segmentFlatListLength());
+
+  for (auto c : {&c1, &c2}) {
+    const auto seg = c->createSegment(30);
+    c->createSynapse(seg, 50, 0.6f);
+    c->createSynapse(seg, 51, 0.3f);
+  }
+  EXPECT_EQ(c1, c2);
+  EXPECT_EQ(vector<Segment>(c1.segmentsForCell(30)),
+            vector<Segment>(c2.segmentsForCell(30)));
+
+  vector<CellIdx> input = {50, 51, 80, 81};
+  vector<SynapseIdx> active1(c1.segmentFlatListLength()), active2(c2.segmentFlatListLength());
+  vector<SynapseIdx> potential1(c1.segmentFlatListLength()), potential2(c2.segmentFlatListLength());
+  c1.computeActivity(active1, potential1, input);
+  c2.computeActivity(active2, potential2, input);
+  EXPECT_EQ(active1, active2);
+  EXPECT_EQ(potential1, potential2);
+
+  stringstream garbage("Connections 2");
+  EXPECT_ANY_THROW(c2.loadCheckpoint(garbage));
+}
+
+/**
+ * Corrupts each byte of a checkpoint in turn.  Loading must either throw and
+ * leave the target unchanged, or give a Connections whose indexes are all
+ * usable.
+ */
+TEST(ConnectionsTest, testCheckpointCorrupt) {
+  for (const bool presynapticArenas : {false, true}) {
+    SCOPED_TRACE(presynapticArenas);
+    Connections c1(1024, 0.5f, false, presynapticArenas);
+    setupSampleConnections(c1);
+    c1.destroySynapse(c1.synapsesForSegment(c1.segmentsForCell(20)[0])[0]);
+    stringstream ss;
+    c1.saveCheckpoint(ss);
+    const string image = ss.str();
+
+    Connections target(16);
+    const Segment segment = target.createSegment(3);
+    target.createSynapse(segment, 7, 0.6f);
+    const Connections before = target;
+
+    UInt numRejected = 0;
+    for (size_t i = 0; i < image.size(); i++) {
+      string corrupt = image;
+      corrupt[i] = (char)(corrupt[i] ^ 0x5A);
+      stringstream in(corrupt);
+      try {
+        target.loadCheckpoint(in);
+      } catch (const std::exception &) {
+        numRejected++;
+        ASSERT_EQ(before, target) << "byte " << i;
+        continue;
+      }
+      // Accepted, so every index must be in range.
+      vector<CellIdx> allInputs(1024);
+      std::iota(allInputs.begin(), allInputs.end(), 0u);
+      vector<SynapseIdx> connected(target.segmentFlatListLength(), 0u);
+      vector<SynapseIdx> potential(target.segmentFlatListLength(), 0u);
+      target.computeActivity(connected, potential, allInputs);
+      for (CellIdx cell = 0; cell < target.numCells(); cell++) {
+        for (Segment seg : target.segmentsForCell(cell)) {
+          for (Synapse synapse : target.synapsesForSegment(seg)) {
+            ASSERT_EQ(seg, target.dataForSynapse(synapse).segment);
+          }
+        }
+      }
+      target = before;
+    }
+    EXPECT_GT(numRejected, 0u);
+  }
+}
+
+/**
+ * Replaces the only copy of the bytes of from in the image with the bytes of
+ * to.  Returns false unless there is exactly one copy.
+ */
+template <typename T>
+bool replaceBytes(string &image, const vector<T> &from, const vector<T> &to) {
+  const string before(reinterpret_cast<const char *>(from.data()), from.size() * sizeof(T));
+  const string after(reinterpret_cast<const char *>(to.data()), to.size() * sizeof(T));
+  const size_t at = image.find(before);
+  if (at == string::npos || image.find(before, at + 1u) != string::npos) {
+    return false;
+  }
+  image.replace(at, before.size(), after);
+  return true;
+}
+
+/**
+ * Checkpoints which index correctly but whose segments disagree with their
+ * synapses or with each other are rejected as well.
+ */
+TEST(ConnectionsTest, testCheckpointInconsistentSegments) {
+  Connections c(1024);
+  // Interleave the segments of cell 777 with others, so that its segments
+  // are listed as {50, 99}, which occurs nowhere else in the image.
+  for (CellIdx cell = 100u; cell < 150u; cell++) {
+    c.createSegment(cell);
+  }
+  const Segment first = c.createSegment(777);
+  for (CellIdx cell = 200u; cell < 248u; cell++) {
+    c.createSegment(cell);
+  }
+  const Segment second = c.createSegment(777);
+  ASSERT_EQ(50u, first);
+  ASSERT_EQ(99u, second);
+  c.createSynapse(first, 500, 0.6f);
+  c.createSynapse(first, 501, 0.6f);
+  c.createSynapse(first, 502, 0.2f);
+  stringstream ss;
+  c.saveCheckpoint(ss);
+  const string image = ss.str();
+
+  // Sanity check: the unchanged image loads.
+  {
+    stringstream in(image);
+    Connections loaded;
+    EXPECT_NO_THROW(loaded.loadCheckpoint(in));
+  }
+
+  const auto expectRejected = [&](const string &corrupt) {
+    stringstream in(corrupt);
+    Connections loaded;
+    EXPECT_ANY_THROW(loaded.loadCheckpoint(in));
+  };
+
+  // The count of connected synapses of a segment is wrong.
+  {
+    const SegmentData &data = c.dataForSegment(first);
+    ASSERT_EQ(2u, data.numConnected);
+    vector<Byte> from(offsetof(SegmentData, numConnected) + sizeof(SynapseIdx));
+    std::memcpy(from.data(), &data, from.size());
+    vector<Byte> to = from;
+    const SynapseIdx wrong = 3u;
+    std::memcpy(to.data() + offsetof(SegmentData, numConnected), &wrong, sizeof(wrong));
+    string corrupt = image;
+    ASSERT_TRUE(replaceBytes(corrupt, from, to));
+    expectRejected(corrupt);
+  }
+
+  // The segments on the cell are out of order.
+  {
+    string corrupt = image;
+    ASSERT_TRUE(replaceBytes(corrupt, vector<Segment>{first, second},
+                             vector<Segment>{second, first}));
+    expectRejected(corrupt);
+  }
+
+  // The same segment is listed twice on the cell.
+  for (const Segment twice : {first, second}) {
+    string corrupt = image;
+    ASSERT_TRUE(replaceBytes(corrupt, vector<Segment>{first, second},
+                             vector<Segment>{twice, twice}));
+    expectRejected(corrupt);
+  }
+}
+
+/**
+ * Grows many presynaptic lists in lockstep while destroying segments, which
+ * makes the arenas move and compact their runs, and checks the indexes
+ * against the synapses on the segments.  The presynaptic index is checked
+ * both with and without arenas.
+ */
+TEST(ConnectionsTest, testArenasStayConsistent) {
+  for (const bool presynapticArenas : {false, true}) {
+    const CellIdx numCells = 200u;
+    const CellIdx numInputs = 300u;
+    SCOPED_TRACE(presynapticArenas);
+    Connections c(numCells, 0.5f, false, presynapticArenas);
+    vector<vector<Segment>> expectedSegments(numCells);
+
+    for (UInt round = 0; round < 20u; round++) {
+      for (CellIdx cell = 0; cell < numCells; cell++) {
+        const Segment segment = c.createSegment(cell);
+        expectedSegments[cell].push_back(segment);
+        for (UInt k = 0; k < 12u; k++) {
+          c.createSynapse(segment, (cell * 7u + k * 13u + round) % numInputs,
+                          k % 2u == 0u ? 0.3f : 0.7f);
+        }
+        if (round % 2u == 1u && cell % 2u == 0u) {
+          c.destroySegment(expectedSegments[cell].front());
+          expectedSegments[cell].erase(expectedSegments[cell].begin());
+        }
+      }
+    }
+
+    vector<SynapseIdx> expectedConnected(c.segmentFlatListLength(), 0u);
+    vector<SynapseIdx> expectedPotential(c.segmentFlatListLength(), 0u);
+    vector<vector<Synapse>> expectedPresynaptic(numInputs);
+    for (CellIdx cell = 0; cell < numCells; cell++) {
+      ASSERT_EQ(expectedSegments[cell], vector<Segment>(c.segmentsForCell(cell)));
+      for (Segment segment : c.segmentsForCell(cell)) {
+        for (Synapse synapse : c.synapsesForSegment(segment)) {
+          const SynapseData data = c.dataForSynapse(synapse);
+          ASSERT_EQ(segment, data.segment);
+          expectedPotential[segment]++;
+          if (data.permanence >= 0.5f) expectedConnected[segment]++;
+          expectedPresynaptic[data.presynapticCell].push_back(synapse);
+        }
+      }
+    }
+
+    for (CellIdx input = 0; input < numInputs; input++) {
+      vector<Synapse> synapses = c.synapsesForPresynapticCell(input);
+      std::sort(synapses.begin(), synapses.end());
+      std::sort(expectedPresynaptic[input].begin(), expectedPresynaptic[input].end());
+      ASSERT_EQ(expectedPresynaptic[input], synapses);
+    }
+
+    vector<CellIdx> allInputs(numInputs);
+    std::iota(allInputs.begin(), allInputs.end(), 0u);
+    vector<SynapseIdx> connected(c.segmentFlatListLength(), 0u);
+    vector<SynapseIdx> potential(c.segmentFlatListLength(), 0u);
+    c.computeActivity(connected, potential, allInputs);
+    EXPECT_EQ(expectedConnected, connected);
+    EXPECT_EQ(expectedPotential, potential);
+
+    stringstream ss;
+    c.saveCheckpoint(ss);
+    Connections copy;
+    copy.loadCheckpoint(ss);
+    EXPECT_EQ(c, copy);
+
+    vector<SynapseIdx> copyConnected(copy.segmentFlatListLength(), 0u);
+    vector<SynapseIdx> copyPotential(copy.segmentFlatListLength(), 0u);
+    copy.computeActivity(copyConnected, copyPotential, allInputs);
+    EXPECT_EQ(expectedConnected, copyConnected);
+    EXPECT_EQ(expectedPotential, copyPotential);
+  }
+}
+
 TEST(ConnectionsTest, testCreateSegmentOverflow) {
     const auto LIMIT = std::numeric_limits<Segment>::max();
     if(LIMIT <= 256) { //connections::Segment is too large (likely uint32), so this test would run, but memory 
@@ -311,6 +311,30 @@ TEST_F(SDRClassifierTest, SaveLoad) {
 }
 
 
+TEST_F(SDRClassifierTest, GrowingWeights) {
+  // Learn a small pattern first, then grow the weights to many more input
+  // bits and buckets.  What was learned before must survive the growth.
+  SDRClassifier c = SDRClassifier({0u}, 0.1f, 0.1f, 0u);
+  const vector<UInt> smallInput{ 1u, 5u, 9u };
+  const vector<UInt> largeInput{ 700u, 850u, 999u };
+  ClassifierResult result;
+  UInt recordNum = 0u;
+  for(UInt i = 0; i < 10u; i++) {
+    c.compute(recordNum++, smallInput, {3u}, {3.0f}, false, true, false, result);
+  }
+  for(UInt bucket = 4u; bucket <= 200u; bucket++) {
+    c.compute(recordNum++, largeInput, {bucket}, {(Real64)bucket}, false, true, false, result);
+  }
+
+  c.compute(recordNum++, smallInput, {}, {0.0f}, false, false, true, result);
+  ASSERT_EQ(result[0u].size(), 201u);
+  ASSERT_EQ(c.getClassification(result[0u]), 3u);
+
+  c.compute(recordNum++, largeInput, {}, {0.0f}, false, false, true, result);
+  ASSERT_GT(c.getClassification(result[0u]), 3u);
+}
+
+
 TEST_F(SDRClassifierTest, testSoftmaxOverflow) {
   SDRClassifier c = SDRClassifier({1u}, 0.5f, 0.5f, 0u);
   std::vector<Real64> values = {numeric_limits<Real64>::max()};
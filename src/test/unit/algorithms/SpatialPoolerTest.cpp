@@ -36,6 +36,7 @@
 #include <nupic/math/StlIo.hpp>
 #include <nupic/types/Types.hpp>
 #include <nupic/utils/Log.hpp>
+#include <nupic/utils/VectorHelpers.hpp>
 #include <nupic/os/Timer.hpp>
 
 namespace testing {
@@ -46,6 +47,7 @@ using namespace nupic::algorithms::spatial_pooler;
 using nupic::sdr::SDR;
 using nupic::sdr::SDR_dense_t;
 using nupic::sdr::SDR_sparse_t;
+using nupic::utils::VectorHelpers;
 
 UInt countNonzero(const vector<UInt> &vec) {
   UInt count = 0;
@@ -1233,6 +1235,62 @@ TEST(SpatialPoolerTest, testInhibitColumnsGlobal) {
   ASSERT_TRUE(check_vector_eq(trueActive, active));
 }
 
+/**
+ * Global inhibition must pick the same winners, in the same order, as
+ * sorting every column by its overlap plus tie breaker.  Exact ties go to
+ * the lower column index.
+ */
+class TieBreakerSpatialPooler : public SpatialPooler {
+public:
+  const vector<Real> &tieBreaker() const { return tieBreaker_; }
+  void clearTieBreaker() { tieBreaker_.assign(tieBreaker_.size(), 0.0f); }
+};
+
+TEST(SpatialPoolerTest, testInhibitColumnsGlobalMatchesSort) {
+  TieBreakerSpatialPooler sp;
+  const UInt numColumns = 5000;
+  setup(sp, 100, numColumns);
+
+  Random rng(42);
+  vector<Real> overlaps(numColumns);
+  vector<UInt> activeColumns;
+  for (UInt trial = 0; trial < 20; trial++) {
+    // Small integers scaled by boost factors, with many ties.
+    for (auto &overlap : overlaps) {
+      overlap = (Real)rng.getUInt32(20u);
+      if (trial % 2 == 1) {
+        overlap *= (Real)(0.5 + rng.getReal64());
+      }
+    }
+    const Real density = (trial < 10) ? 0.02f : 0.5f;
+
+    vector<Real> keys(numColumns);
+    vector<UInt> expected(numColumns);
+    for (UInt i = 0; i < numColumns; i++) {
+      keys[i] = overlaps[i] + sp.tieBreaker()[i];
+      expected[i] = i;
+    }
+    stable_sort(expected.begin(), expected.end(),
+                [&](UInt a, UInt b) { return keys[a] > keys[b]; });
+    expected.resize((UInt)(density * numColumns));
+    while (!expected.empty() &&
+           overlaps[expected.back()] < sp.getStimulusThreshold()) {
+      expected.pop_back();
+    }
+
+    sp.inhibitColumnsGlobal_(overlaps, density, activeColumns);
+    ASSERT_EQ(expected, activeColumns) << "Trial " << trial;
+  }
+
+  // Exact ties in the overlap plus tie breaker.
+  sp.clearTieBreaker();
+  overlaps.assign(numColumns, 3.0f);
+  sp.inhibitColumnsGlobal_(overlaps, 0.02f, activeColumns);
+  vector<UInt> lowest(100);
+  iota(lowest.begin(), lowest.end(), 0u);
+  ASSERT_EQ(lowest, activeColumns);
+}
+
 TEST(SpatialPoolerTest, testValidateGlobalInhibitionParameters) {
   // With 10 columns the minimum sparsity for global inhibition is 10%
   // Setting sparsity to 2% should throw an exception
@@ -1398,6 +1456,65 @@ TEST(SpatialPoolerTest, testInhibitColumnsLocal) {
   }
 }
 
+/**
+ * Counting neighbors by rank must select exactly the columns which scanning
+ * the neighborhoods selects, including how ties are broken.
+ */
+TEST(SpatialPoolerTest, testInhibitColumnsLocalRankMatchesScan) {
+  const vector<vector<UInt>> topologies = {{500}, {20, 30}, {7, 60}, {1, 50}};
+  Random rng(42);
+  for (const auto &columnDimensions : topologies) {
+    for (const bool wrapAround : {false, true}) {
+      SpatialPooler sp(
+          /*inputDimensions*/ columnDimensions,
+          /*columnDimensions*/ columnDimensions,
+          /*potentialRadius*/ 1,
+          /*potentialPct*/ 0.5f,
+          /*globalInhibition*/ false,
+          /*localAreaDensity*/ 0.1f,
+          /*numActiveColumnsPerInhArea*/ -1,
+          /*stimulusThreshold*/ 1,
+          /*synPermInactiveDec*/ 0.008f,
+          /*synPermActiveInc*/ 0.05f,
+          /*synPermConnected*/ 0.1f,
+          /*minPctOverlapDutyCycles*/ 0.001f,
+          /*dutyCyclePeriod*/ 1000,
+          /*boostStrength*/ 0.0f,
+          /*seed*/ 1,
+          /*spVerbosity*/ 0,
+          /*wrapAround*/ wrapAround);
+      // Threads split the rows, so that the rank counts start mid-row.
+      sp.setNumThreads(wrapAround ? 3u : 1u);
+      vector<Real> overlaps(sp.getNumColumns());
+      vector<UInt> scanned;
+      vector<UInt> ranked;
+      for (const UInt radius : {1u, 2u, 5u, 13u, 35u}) {
+        sp.setInhibitionRadius(radius);
+        for (UInt trial = 0; trial < 4; trial++) {
+          // Small integers tie a lot, boosted overlaps mostly don't.
+          for (auto &overlap : overlaps) {
+            overlap = (Real)rng.getUInt32(trial < 2 ? 4u : 50u);
+            if (trial % 2 == 1) {
+              overlap *= (Real)(0.5 + rng.getReal64());
+            }
+          }
+          for (const Real density : {0.02f, 0.1f, 0.5f}) {
+            sp.inhibitColumnsLocal_(overlaps, density, scanned,
+                                    SpatialPooler::LocalInhibition::Scan);
+            sp.inhibitColumnsLocal_(overlaps, density, ranked,
+                                    SpatialPooler::LocalInhibition::Rank);
+            ASSERT_EQ(scanned, ranked)
+                << "Columns " << columnDimensions.front() << "x"
+                << columnDimensions.back() << " wrap " << wrapAround
+                << " radius " << radius << " trial " << trial
+                << " density " << density;
+          }
+        }
+      }
+    }
+  }
+}
+
 TEST(SpatialPoolerTest, testIsUpdateRound) {
   SpatialPooler sp;
   sp.setUpdatePeriod(50);
@@ -1491,21 +1608,16 @@ TEST(SpatialPoolerTest, testInitPermanence) {
                 synPermConnected);
   sp.setSynPermActiveInc(synPermActiveInc);
 
-  UInt arr[8] = {0, 1, 1, 0, 0, 1, 0, 1};
-  vector<UInt> potential(&arr[0], &arr[8]);
+  vector<UInt> potential = {1, 2, 5, 7};
   vector<Real> perm = sp.initPermanence_(potential, 1.0);
-  for (UInt i = 0; i < 8; i++)
-    if (potential[i])
-      ASSERT_TRUE(perm[i] >= synPermConnected);
-    else
-      ASSERT_TRUE(perm[i] < 1e-5);
+  ASSERT_EQ(potential.size(), perm.size());
+  for (UInt i = 0; i < potential.size(); i++)
+    ASSERT_TRUE(perm[i] >= synPermConnected);
 
   perm = sp.initPermanence_(potential, 0);
-  for (UInt i = 0; i < 8; i++)
-    if (potential[i])
-      ASSERT_LE(perm[i], synPermConnected);
-    else
-      ASSERT_LT(perm[i], 1e-5);
+  ASSERT_EQ(potential.size(), perm.size());
+  for (UInt i = 0; i < potential.size(); i++)
+    ASSERT_LE(perm[i], synPermConnected);
 
   inputDim[0] = 100;
   sp.initialize(inputDim, columnDim, 16u, 0.5f, true, -1, 10u, 0u, 0.01f, 0.1f,
@@ -1514,7 +1626,7 @@ TEST(SpatialPoolerTest, testInitPermanence) {
   potential.clear();
 
   for (UInt i = 0; i < 100; i++)
-    potential.push_back(1);
+    potential.push_back(i);
 
   perm = sp.initPermanence_(potential, 0.5);
   int count = 0;
@@ -1625,28 +1737,33 @@ TEST(SpatialPoolerTest, testinitMapPotential1D) {
   sp.setPotentialPct(1.0);
 
   UInt expectedMask1[12] = {1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0};
-  mask = sp.initMapPotential_(0, false);
+  mask = VectorHelpers::sparseToBinary<UInt>(
+      sp.initMapPotential_(0, false), sp.getNumInputs());
   ASSERT_TRUE(check_vector_eq(expectedMask1, mask));
 
   UInt expectedMask2[12] = {0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 0, 0};
-  mask = sp.initMapPotential_(2, false);
+  mask = VectorHelpers::sparseToBinary<UInt>(
+      sp.initMapPotential_(2, false), sp.getNumInputs());
   ASSERT_TRUE(check_vector_eq(expectedMask2, mask));
 
   // Test with wrapAround and potentialPct = 1
   sp.setPotentialPct(1.0);
 
   UInt expectedMask3[12] = {1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1};
-  mask = sp.initMapPotential_(0, true);
+  mask = VectorHelpers::sparseToBinary<UInt>(
+      sp.initMapPotential_(0, true), sp.getNumInputs());
   ASSERT_TRUE(check_vector_eq(expectedMask3, mask));
 
   UInt expectedMask4[12] = {1, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1};
-  mask = sp.initMapPotential_(3, true);
+  mask = VectorHelpers::sparseToBinary<UInt>(
+      sp.initMapPotential_(3, true), sp.getNumInputs());
   ASSERT_TRUE(check_vector_eq(expectedMask4, mask));
 
   // Test with potentialPct < 1
   sp.setPotentialPct(0.5);
   UInt supersetMask1[12] = {1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1};
-  mask = sp.initMapPotential_(0, true);
+  mask = VectorHelpers::sparseToBinary<UInt>(
+      sp.initMapPotential_(0, true), sp.getNumInputs());
   ASSERT_TRUE(accumulate(mask.begin(), mask.end(), 0.0f) == 3u);
 
   UInt unionMask1[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
@@ -1678,14 +1795,16 @@ TEST(SpatialPoolerTest, testinitMapPotential2D) {
       1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0,
       1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
       0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-  mask = sp.initMapPotential_(0, false);
+  mask = VectorHelpers::sparseToBinary<UInt>(
+      sp.initMapPotential_(0, false), sp.getNumInputs());
   ASSERT_TRUE(check_vector_eq(expectedMask1, mask));
 
   UInt expectedMask2[72] = {
       0, 0, 0, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 0, 0, 0,
       0, 0, 0, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
       0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-  mask = sp.initMapPotential_(2, false);
+  mask = VectorHelpers::sparseToBinary<UInt>(
+      sp.initMapPotential_(2, false), sp.getNumInputs());
   ASSERT_TRUE(check_vector_eq(expectedMask2, mask));
 
   // Test with wrapAround
@@ -1695,14 +1814,16 @@ TEST(SpatialPoolerTest, testinitMapPotential2D) {
       1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1,
       1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1,
       0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1};
-  mask = sp.initMapPotential_(0, true);
+  mask = VectorHelpers::sparseToBinary<UInt>(
+      sp.initMapPotential_(0, true), sp.getNumInputs());
   ASSERT_TRUE(check_vector_eq(expectedMask3, mask));
 
   UInt expectedMask4[72] = {
       1, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1,
       1, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1,
       0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1};
-  mask = sp.initMapPotential_(3, true);
+  mask = VectorHelpers::sparseToBinary<UInt>(
+      sp.initMapPotential_(3, true), sp.getNumInputs());
   ASSERT_TRUE(check_vector_eq(expectedMask4, mask));
 }
 
@@ -2156,4 +2277,46 @@ TEST(SpatialPoolerTest, ExactOutput) {
   ASSERT_EQ( columns, gold_sdr );
 }
 
+
+TEST(SpatialPoolerTest, MultiThreadedMatchesSerial) {
+  for(const bool globalInhibition : {true, false}) {
+    SDR inputs({ 32, 32 });
+    SDR columns({ 32, 32 });
+    SDR columnsMT({ 32, 32 });
+    SpatialPooler sp({inputs.dimensions}, {columns.dimensions},
+                     /*potentialRadius*/ 8,
+                     /*potentialPct*/ 0.5f,
+                     /*globalInhibition*/ globalInhibition,
+                     /*localAreaDensity*/ 0.05f,
+                     /*numActiveColumnsPerInhArea*/ -1,
+                     /*stimulusThreshold*/ 1u,
+                     /*synPermInactiveDec*/ 0.01f,
+                     /*synPermActiveInc*/ 0.05f,
+                     /*synPermConnected*/ 0.1f,
+                     /*minPctOverlapDutyCycles*/ 0.01f,
+                     /*dutyCyclePeriod*/ 50,
+                     /*boostStrength*/ 2.0f,
+                     /*seed*/ 42,
+                     /*spVerbosity*/ 0,
+                     /*wrapAround*/ globalInhibition);
+    SpatialPooler spMT;
+    stringstream ss;
+    sp.save(ss);
+    spMT.load(ss);
+    spMT.setNumThreads(4);
+    ASSERT_EQ(spMT.getNumThreads(), 4u);
+
+    Random rng(7);
+    for(UInt i = 0; i < 200; i++) {
+      inputs.randomize( 0.1f, rng );
+      const bool learn = (i % 10) != 9;
+      sp.compute(inputs, learn, columns);
+      spMT.compute(inputs, learn, columnsMT);
+      ASSERT_EQ( columns, columnsMT ) << "Iteration " << i;
+    }
+    ASSERT_EQ( sp.getBoostedOverlaps(), spMT.getBoostedOverlaps() );
+    ASSERT_TRUE( sp == spMT );
+  }
+}
+
 } // end anonymous namespace
@@ -0,0 +1,183 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2019, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ----------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of unit tests for TemporalMemoryBatch
+ */
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include <nupic/algorithms/TemporalMemoryBatch.hpp>
+#include <nupic/types/Sdr.hpp>
+#include <nupic/utils/Random.hpp>
+
+namespace testing {
+
+using namespace std;
+using namespace nupic;
+using namespace nupic::algorithms::temporal_memory;
+using nupic::sdr::SDR;
+
+
+TEST(TemporalMemoryBatchTest, MatchesIndependentStreams) {
+  const UInt numStreams = 7u;
+  const vector<CellIdx> columnDimensions{ 200u };
+  TemporalMemory prototype(columnDimensions, /*cellsPerColumn*/ 8,
+                           /*activationThreshold*/ 3, /*initialPermanence*/ 0.21f,
+                           /*connectedPermanence*/ 0.5f, /*minThreshold*/ 2,
+                           /*maxNewSynapseCount*/ 6);
+
+  TemporalMemoryBatch batch(numStreams, prototype, /*numThreads*/ 3u);
+  ASSERT_EQ(batch.size(), numStreams);
+  ASSERT_EQ(batch.getNumThreads(), 3u);
+  vector<TemporalMemory> reference(numStreams, prototype);
+  for (UInt s = 1u; s < numStreams; s++) {
+    reference[s].setSeed(prototype.getSeed() + s);
+  }
+
+  // Each stream sees its own repeating sequence.
+  vector<vector<SDR>> sequences(numStreams);
+  Random rng(11);
+  for (auto &sequence : sequences) {
+    for (UInt i = 0; i < 5u; i++) {
+      sequence.emplace_back(columnDimensions);
+      sequence.back().randomize(0.05f, rng);
+    }
+  }
+
+  vector<SDR> activeColumns(numStreams, SDR(columnDimensions));
+  for (UInt t = 0; t < 60u; t++) {
+    if (t == 30u) {
+      batch.setNumThreads(2u);
+    }
+    for (UInt s = 0; s < numStreams; s++) {
+      activeColumns[s].setSDR(sequences[s][t % sequences[s].size()]);
+      reference[s].compute(activeColumns[s], true);
+    }
+    batch.computeBatch(activeColumns, true);
+
+    for (UInt s = 0; s < numStreams; s++) {
+      ASSERT_EQ(batch.stream(s).getActiveCells(), reference[s].getActiveCells())
+          << "Stream " << s << ", time step " << t;
+      ASSERT_EQ(batch.stream(s).getWinnerCells(), reference[s].getWinnerCells())
+          << "Stream " << s << ", time step " << t;
+    }
+  }
+  for (UInt s = 0; s < numStreams; s++) {
+    ASSERT_TRUE(batch.stream(s) == reference[s]) << "Stream " << s;
+  }
+
+  // The streams learned different sequences.
+  ASSERT_FALSE(batch.stream(0u) == batch.stream(1u));
+}
+
+
+TEST(TemporalMemoryBatchTest, StreamsHaveDistinctSeeds) {
+  const vector<CellIdx> columnDimensions{ 200u };
+  TemporalMemory prototype(columnDimensions, /*cellsPerColumn*/ 8,
+                           /*activationThreshold*/ 3, /*initialPermanence*/ 0.21f,
+                           /*connectedPermanence*/ 0.5f, /*minThreshold*/ 2,
+                           /*maxNewSynapseCount*/ 6);
+  TemporalMemoryBatch batch(2u, prototype);
+  ASSERT_EQ(batch.stream(0u).getSeed(), prototype.getSeed());
+  ASSERT_EQ(batch.stream(1u).getSeed(), prototype.getSeed() + 1u);
+
+  // Both streams see the same sequence, but burst onto different cells.
+  vector<SDR> sequence;
+  Random rng(11);
+  for (UInt i = 0; i < 5u; i++) {
+    sequence.emplace_back(columnDimensions);
+    sequence.back().randomize(0.05f, rng);
+  }
+  vector<SDR> activeColumns(2u, SDR(columnDimensions));
+  for (UInt t = 0; t < 20u; t++) {
+    activeColumns[0].setSDR(sequence[t % sequence.size()]);
+    activeColumns[1].setSDR(sequence[t % sequence.size()]);
+    batch.computeBatch(activeColumns, true);
+  }
+  ASSERT_NE(batch.stream(0u).getWinnerCells(), batch.stream(1u).getWinnerCells());
+  ASSERT_FALSE(batch.stream(0u) == batch.stream(1u));
+}
+
+
+/**
+ * A prototype which has already run keeps its random state in stream 0, and
+ * only the other streams restart their generators.
+ */
+TEST(TemporalMemoryBatchTest, PrototypeAlreadyComputed) {
+  const UInt numStreams = 3u;
+  const vector<CellIdx> columnDimensions{ 200u };
+  TemporalMemory prototype(columnDimensions, /*cellsPerColumn*/ 8,
+                           /*activationThreshold*/ 3, /*initialPermanence*/ 0.21f,
+                           /*connectedPermanence*/ 0.5f, /*minThreshold*/ 2,
+                           /*maxNewSynapseCount*/ 6);
+  vector<SDR> sequence;
+  Random rng(11);
+  for (UInt i = 0; i < 5u; i++) {
+    sequence.emplace_back(columnDimensions);
+    sequence.back().randomize(0.05f, rng);
+  }
+  for (UInt t = 0; t < 7u; t++) {
+    prototype.compute(sequence[t % sequence.size()], true);
+  }
+
+  TemporalMemoryBatch batch(numStreams, prototype);
+  ASSERT_TRUE(batch.stream(0u) == prototype);
+  vector<TemporalMemory> reference(numStreams, prototype);
+  for (UInt s = 1u; s < numStreams; s++) {
+    reference[s].setSeed(prototype.getSeed() + s);
+  }
+
+  vector<SDR> activeColumns(numStreams, SDR(columnDimensions));
+  for (UInt t = 7u; t < 30u; t++) {
+    for (UInt s = 0; s < numStreams; s++) {
+      activeColumns[s].setSDR(sequence[t % sequence.size()]);
+      reference[s].compute(activeColumns[s], true);
+    }
+    batch.computeBatch(activeColumns, true);
+    for (UInt s = 0; s < numStreams; s++) {
+      ASSERT_EQ(batch.stream(s).getWinnerCells(), reference[s].getWinnerCells())
+          << "Stream " << s << ", time step " << t;
+    }
+  }
+
+  // Stream 0 grew the same synapses as the prototype would have.
+  for (UInt t = 7u; t < 30u; t++) {
+    prototype.compute(sequence[t % sequence.size()], true);
+  }
+  ASSERT_TRUE(batch.stream(0u) == prototype);
+  ASSERT_FALSE(batch.stream(1u) == prototype);
+}
+
+
+TEST(TemporalMemoryBatchTest, CheckInputs) {
+  TemporalMemory prototype({ 100u }, 4);
+  TemporalMemoryBatch batch(3u, prototype);
+
+  vector<SDR> tooFew(2u, SDR({ 100u }));
+  EXPECT_ANY_THROW(batch.computeBatch(tooFew, true));
+  EXPECT_ANY_THROW(batch.stream(3u));
+  EXPECT_ANY_THROW(TemporalMemoryBatch(0u, prototype));
+}
+
+} // end namespace testing
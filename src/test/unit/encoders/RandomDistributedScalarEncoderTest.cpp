@@ -24,6 +24,8 @@
 #include "gtest/gtest.h"
 #include <nupic/types/Sdr.hpp>
 #include <nupic/encoders/RandomDistributedScalarEncoder.hpp>
+#include <nupic/utils/MurmurHash3.hpp>
+#include <cmath>
 #include <string>
 #include <vector>
 
@@ -61,3 +63,36 @@ TEST(RDSE, testSerialize) {
 
   ASSERT_EQ( A, B );
 }
+
+TEST(RDSE, testHashSequence) {
+  const UInt first = 1000u;
+  std::vector<UInt32> hashes( 10u );
+  MurmurHash3_x86_32_sequence( first, 10u, 42u, hashes.data() );
+  for( UInt i = 0; i < 10u; i++ ) {
+    UInt key = first + i;
+    ASSERT_EQ( hashes[i], MurmurHash3_x86_32( &key, sizeof(key), 42u ));
+  }
+}
+
+TEST(RDSE, testEncodeBatch) {
+  RDSE_Parameters P;
+  P.size       = 1000;
+  P.sparsity   = 0.05f;
+  P.resolution = 1.0f;
+  P.seed       = 7u;
+  RDSE R( P );
+
+  const std::vector<Real64> inputs = { 3.0, 3.5, 4.0, NAN, 4.2, 1000.0 };
+  std::vector<SDR> outputs( inputs.size(), SDR( R.dimensions ));
+  R.encodeBatch( inputs.data(), inputs.size(), outputs.data() );
+
+  SDR expected( R.dimensions );
+  for( size_t i = 0; i < inputs.size(); i++ ) {
+    R.encode( inputs[i], expected );
+    ASSERT_EQ( outputs[i], expected );
+  }
+  ASSERT_EQ( outputs[0], outputs[1] );
+  ASSERT_EQ( outputs[3].getSum(), 0u );
+  ASSERT_GE( outputs[0].getSum(), 45u );
+  ASSERT_LE( outputs[0].getSum(), 50u );
+}
@@ -174,6 +174,28 @@ TEST(ScalarEncoder, PeriodicRoundNearestMultipleOfResolution) {
   doScalarValueCases(encoder, cases);
 }
 
+TEST(ScalarEncoder, EncodeBatch) {
+  ScalarEncoderParameters p;
+  p.activeBits = 3;
+  p.minimum    = 10.0;
+  p.maximum    = 20.0;
+  p.resolution = 1;
+  p.periodic   = true;
+  ScalarEncoder encoder( p );
+
+  const std::vector<Real64> inputs = { 10.0, 19.49, 15.5, 15.5, NAN, 20.0 };
+  std::vector<SDR> outputs( inputs.size(), SDR( encoder.dimensions ));
+  encoder.encodeBatch( inputs.data(), inputs.size(), outputs.data() );
+
+  SDR expected( encoder.dimensions );
+  for( size_t i = 0; i < inputs.size(); i++ ) {
+    encoder.encode( inputs[i], expected );
+    EXPECT_EQ( outputs[i], expected );
+  }
+  // Bits which wrap around are still sorted.
+  EXPECT_EQ( outputs[1].getSparse(), std::vector<UInt>({ 0, 1, 9 }));
+}
+
 TEST(ScalarEncoder, Serialization) {
   std::vector<ScalarEncoder*> inputs;
   ScalarEncoderParameters p;
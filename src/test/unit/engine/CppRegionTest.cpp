@@ -113,6 +113,42 @@ TEST(CppRegionTest, testCppLinkingFanIn) {
 }
 
 
+TEST(CppRegionTest, testCppLinkingFanInAliasing) {
+  Network net;
+  net.setFanInAliasing(true);
+
+  std::shared_ptr<Region> region1 = net.addRegion("region1", "TestNode", "{count: 64}");
+  std::shared_ptr<Region> region2 = net.addRegion("region2", "TestNode", "{count: 64}");
+  std::shared_ptr<Region> region3 = net.addRegion("region3", "TestNode", "");
+
+  net.link("region1", "region3");
+  net.link("region2", "region3");
+
+  net.initialize();
+
+  // The outputs are the two halves of the input buffer.
+  const Array r1OutputArray = region1->getOutputData("bottomUpOut");
+  const Array r2OutputArray = region2->getOutputData("bottomUpOut");
+  const Array r3InputArray  = region3->getInputData("bottomUpIn");
+  ASSERT_EQ(r3InputArray.getCount(), 128u);
+  const Real64 *buffer3 = (const Real64 *)r3InputArray.getBuffer();
+  EXPECT_EQ(buffer3, (const Real64 *)r1OutputArray.getBuffer());
+  EXPECT_EQ(buffer3 + 64, (const Real64 *)r2OutputArray.getBuffer());
+
+  net.run(2);
+  const Real64 *buffer1 = (const Real64 *)region1->getOutputData("bottomUpOut").getBuffer();
+  const Real64 *buffer2 = (const Real64 *)region2->getOutputData("bottomUpOut").getBuffer();
+  buffer3 = (const Real64 *)region3->getInputData("bottomUpIn").getBuffer();
+  for (size_t i = 0; i < 64; i++) {
+    ASSERT_EQ(buffer3[i], buffer1[i]);
+    ASSERT_EQ(buffer3[i + 64], buffer2[i]);
+  }
+  ASSERT_EQ(buffer1[0], 1);
+  for (size_t i = 1; i < 64; i++) {
+    ASSERT_EQ(buffer1[i], (Real64)(i - 1));
+  }
+}
+
 TEST(CppRegionTest, testCppLinkingSDR) {
   Network net;
 
@@ -163,6 +199,78 @@ TEST(CppRegionTest, testCppLinkingSDR) {
 }
 
 
+TEST(CppRegionTest, testCppLinkingSDRFanIn) {
+  Network net;
+
+  std::shared_ptr<Region> region1 = net.addRegion("region1", "ScalarSensor", "{dim: [6], n: 6, w: 2}");
+  std::shared_ptr<Region> region2 = net.addRegion("region2", "ScalarSensor", "{dim: [6], n: 6, w: 2}");
+  std::shared_ptr<Region> region3 = net.addRegion("region3", "SPRegion", "{dim: [2,3]}");
+
+  net.link("region1", "region3");
+  net.link("region2", "region3");
+
+  net.initialize();
+
+  for (const Real64 value : {0.8, -0.8}) {
+    region1->setParameterReal64("sensedValue", value);
+    region2->setParameterReal64("sensedValue", -value);
+    region1->compute();
+    region2->compute();
+    region3->prepareInputs();
+
+    // The active bits of both sensors are concatenated into the SDR input.
+    const Array r1OutputArray = region1->getOutputData("encoded");
+    const Array r2OutputArray = region2->getOutputData("encoded");
+    const Array r3InputArray = region3->getInputData("bottomUpIn");
+    VERBOSE << r3InputArray << "\n";
+    ASSERT_EQ(r3InputArray.getType(), NTA_BasicType_SDR);
+    ASSERT_EQ(r3InputArray.getCount(), 12u);
+    std::vector<Byte> expected(r1OutputArray.getSDR().getDense());
+    const auto &dense2 = r2OutputArray.getSDR().getDense();
+    expected.insert(expected.end(), dense2.begin(), dense2.end());
+    EXPECT_TRUE(r3InputArray == expected);
+  }
+}
+
+TEST(CppRegionTest, testCppLinkingMixedFanIn) {
+  Network net;
+
+  // A Real64 output at offset 0 and an SDR output after it.
+  std::shared_ptr<Region> region1 = net.addRegion("region1", "TestNode", "{count: 6}");
+  std::shared_ptr<Region> region2 = net.addRegion("region2", "ScalarSensor", "{dim: [6], n: 6, w: 2}");
+  std::shared_ptr<Region> region3 = net.addRegion("region3", "SPRegion", "{dim: [2,3]}");
+
+  net.link("region1", "region3", "", "", "bottomUpOut", "bottomUpIn");
+  net.link("region2", "region3");
+
+  net.initialize();
+
+  for (const Real64 value : {0.8, -0.8, 0.0, 0.8}) {
+    region1->compute();
+    region2->setParameterReal64("sensedValue", value);
+    region2->compute();
+    region3->prepareInputs();
+
+    // Each slice holds only the current bits of its own source.
+    const Array r1OutputArray = region1->getOutputData("bottomUpOut");
+    const Array r2OutputArray = region2->getOutputData("encoded");
+    const Array r3InputArray = region3->getInputData("bottomUpIn");
+    VERBOSE << r3InputArray << "\n";
+    ASSERT_EQ(r3InputArray.getCount(), 12u);
+    std::vector<Byte> expected;
+    const Real64 *values = (const Real64 *)r1OutputArray.getBuffer();
+    for (size_t i = 0; i < r1OutputArray.getCount(); i++) {
+      expected.push_back(values[i] != 0.0 ? 1u : 0u);
+    }
+    const auto &dense2 = r2OutputArray.getSDR().getDense();
+    expected.insert(expected.end(), dense2.begin(), dense2.end());
+    EXPECT_TRUE(r3InputArray == expected);
+    EXPECT_EQ(r3InputArray.getSDR().getSum(),
+              (UInt)std::count(expected.begin(), expected.end(), (Byte)1u));
+  }
+}
+
+
 
 TEST(CppRegionTest, testYAML) {
   const char *params = "{count: 42, int32Param: 1234, real64Param: 23.1}";
@@ -515,6 +515,95 @@ TEST(NetworkTest, Callback) {
   EXPECT_STREQ("level3", mydata[5].c_str());
 }
 
+/**
+ * Several independent chains in shared phases, with fan out from one sensor
+ * and a delayed link, must compute the same with and without threads.
+ */
+static void buildParallelNetwork(Network &net) {
+  std::set<UInt32> sensorPhase = {0u}, spPhase = {1u}, tmPhase = {2u};
+  for (int i = 0; i < 3; i++) {
+    const std::string id = std::to_string(i);
+    net.addRegion("sensor" + id, "ScalarSensor", "{n: 100,w: 10,minValue: 0,maxValue: 10}");
+    net.addRegion("sp" + id, "SPRegion", "{columnCount: 200, seed: " + std::to_string(i + 1) + "}");
+    net.addRegion("tm" + id, "TMRegion", "{numberOfCols: 200}");
+    net.link("sensor" + id, "sp" + id, "", "", "encoded", "bottomUpIn");
+    net.link("sp" + id, "tm" + id, "", "", "bottomUpOut", "bottomUpIn");
+    net.setPhases("sensor" + id, sensorPhase);
+    net.setPhases("sp" + id, spPhase);
+    net.setPhases("tm" + id, tmPhase);
+  }
+  // Reads the same output as sp0, and the previous value of sensor1.
+  net.addRegion("spShared", "SPRegion", "{columnCount: 100}");
+  net.link("sensor0", "spShared", "", "", "encoded", "bottomUpIn");
+  net.addRegion("spDelayed", "SPRegion", "{columnCount: 100}");
+  net.link("sensor1", "spDelayed", "", "", "encoded", "bottomUpIn", 1);
+  net.setPhases("spShared", spPhase);
+  net.setPhases("spDelayed", spPhase);
+}
+
+TEST(NetworkTest, MultiThreadedMatchesSerial) {
+  Network serial, parallel;
+  buildParallelNetwork(serial);
+  buildParallelNetwork(parallel);
+  parallel.setNumThreads(3u);
+  ASSERT_EQ(3u, parallel.getNumThreads());
+
+  const std::vector<std::string> outputs = {"sp0", "sp1", "sp2", "tm0", "tm1", "tm2",
+                                            "spShared", "spDelayed"};
+  for (int iter = 0; iter < 20; iter++) {
+    for (int i = 0; i < 3; i++) {
+      const std::string sensor = "sensor" + std::to_string(i);
+      const Real64 value = (iter * (i + 2)) % 10;
+      serial.getRegion(sensor)->setParameterReal64("sensedValue", value);
+      parallel.getRegion(sensor)->setParameterReal64("sensedValue", value);
+    }
+    serial.run(1);
+    parallel.run(1);
+
+    for (const auto &name : outputs) {
+      EXPECT_EQ(serial.getRegion(name)->getOutputData("bottomUpOut").getSDR(),
+                parallel.getRegion(name)->getOutputData("bottomUpOut").getSDR())
+          << name << " differs at iteration " << iter;
+    }
+  }
+
+  parallel.setNumThreads(1u);
+  EXPECT_EQ(1u, parallel.getNumThreads());
+  EXPECT_ANY_THROW(parallel.setNumThreads(0u));
+}
+
+/**
+ * Links added and removed after the network has run are part of the next
+ * run, with the serial and the parallel executor alike.
+ */
+TEST(NetworkTest, LinkAfterRun) {
+  for (const UInt32 numThreads : {1u, 3u}) {
+    Network net;
+    net.setNumThreads(numThreads);
+    net.addRegion("sensor", "ScalarSensor", "{n: 100,w: 10,minValue: 0,maxValue: 10}");
+    net.addRegion("other", "ScalarSensor", "{n: 100,w: 10,minValue: 0,maxValue: 10}");
+    net.getRegion("sensor")->setParameterReal64("sensedValue", 3.0);
+    net.getRegion("other")->setParameterReal64("sensedValue", 8.0);
+    net.run(1);
+
+    // Link a new region to one sensor, then move the link to the other.
+    net.addRegion("sp", "SPRegion", "{columnCount: 100}");
+    net.link("other", "sp", "", "", "encoded", "bottomUpIn");
+    net.removeLink("other", "sp", "encoded", "bottomUpIn");
+    net.link("sensor", "sp", "", "", "encoded", "bottomUpIn");
+    net.run(1);
+    EXPECT_EQ(net.getRegion("sensor")->getOutputData("encoded").getSDR().getSparse(),
+              net.getRegion("sp")->getInputData("bottomUpIn").getSDR().getSparse())
+        << numThreads << " threads";
+
+    net.getRegion("sensor")->setParameterReal64("sensedValue", 6.0);
+    net.run(1);
+    EXPECT_EQ(net.getRegion("sensor")->getOutputData("encoded").getSDR().getSparse(),
+              net.getRegion("sp")->getInputData("bottomUpIn").getSDR().getSparse())
+        << numThreads << " threads";
+  }
+}
+
 /**
  * Test operator '=='
  */
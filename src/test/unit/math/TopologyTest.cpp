@@ -24,6 +24,8 @@
  * Unit tests for Topology.hpp
  */
 
+#include <algorithm>
+
 #include "gtest/gtest.h"
 #include <nupic/math/Topology.hpp>
 
@@ -376,4 +378,103 @@ TEST(TopologyTest, WrappingNeighborhoodDimensionOne) {
       /*radius*/ 1,
       /*expected*/ {{4, 0, 0}, {5, 0, 0}, {6, 0, 0}});
 }
+
+void expectNeighborhoodTable(const vector<UInt> &dimensions, UInt radius,
+                             bool wrapAround) {
+  UInt size = 1;
+  for (auto dim : dimensions) {
+    size *= dim;
+  }
+  const NeighborhoodTable table(radius, dimensions, wrapAround);
+  for (UInt i = 0; i < size; i++) {
+    vector<UInt> expected;
+    if (wrapAround) {
+      for (auto neighbor : WrappingNeighborhood(i, radius, dimensions)) {
+        expected.push_back(neighbor);
+      }
+    } else {
+      for (auto neighbor : Neighborhood(i, radius, dimensions)) {
+        expected.push_back(neighbor);
+      }
+    }
+    vector<UInt> actual;
+    table.forEach(i, [&](UInt neighbor) { actual.push_back(neighbor); });
+    EXPECT_EQ(expected, actual) << "point " << i;
+    EXPECT_EQ(expected.size(), table.size(i)) << "point " << i;
+  }
+}
+
+TEST(TopologyTest, NeighborhoodTable) {
+  for (bool wrapAround : {false, true}) {
+    for (UInt radius : {0u, 1u, 2u, 7u}) {
+      expectNeighborhoodTable({30}, radius, wrapAround);
+      expectNeighborhoodTable({7, 9}, radius, wrapAround);
+      expectNeighborhoodTable({10, 1}, radius, wrapAround);
+      expectNeighborhoodTable({4, 5, 6}, radius, wrapAround);
+      expectNeighborhoodTable({3, 4, 2, 5}, radius, wrapAround);
+    }
+  }
+}
+
+TEST(TopologyTest, NeighborhoodTableUpdate) {
+  NeighborhoodTable table;
+  table.update(1, {10}, false);
+  EXPECT_EQ(2u, table.size(0));
+  table.update(1, {10}, true);
+  EXPECT_EQ(3u, table.size(0));
+  table.update(2, {10, 10}, true);
+  EXPECT_EQ(25u, table.size(0));
+}
+
+
+void expectNeighborhoodReductions(const vector<UInt> &dimensions, UInt radius,
+                                  bool wrapAround) {
+  UInt size = 1;
+  for (auto dim : dimensions) {
+    size *= dim;
+  }
+  vector<Real> values(size);
+  for (UInt i = 0; i < size; i++) {
+    values[i] = (Real)((i * 37u + 11u) % 101u) / 100.0f;
+  }
+
+  vector<Real> max, mean;
+  neighborhoodMax(values, radius, dimensions, wrapAround, max);
+  neighborhoodMean(values, radius, dimensions, wrapAround, mean);
+  ASSERT_EQ(size, max.size());
+  ASSERT_EQ(size, mean.size());
+
+  for (UInt i = 0; i < size; i++) {
+    Real expectedMax = 0.0f;
+    Real expectedSum = 0.0f;
+    UInt count = 0;
+    auto visit = [&](UInt neighbor) {
+      expectedMax = std::max(expectedMax, values[neighbor]);
+      expectedSum += values[neighbor];
+      count++;
+    };
+    if (wrapAround) {
+      for (auto neighbor : WrappingNeighborhood(i, radius, dimensions)) {
+        visit(neighbor);
+      }
+    } else {
+      for (auto neighbor : Neighborhood(i, radius, dimensions)) {
+        visit(neighbor);
+      }
+    }
+    EXPECT_EQ(expectedMax, max[i]) << "point " << i;
+    EXPECT_NEAR(expectedSum / count, mean[i], 1e-5f) << "point " << i;
+  }
+}
+
+TEST(TopologyTest, NeighborhoodMaxAndMean) {
+  for (bool wrapAround : {false, true}) {
+    for (UInt radius : {0u, 1u, 2u, 5u, 40u}) {
+      expectNeighborhoodReductions({30}, radius, wrapAround);
+      expectNeighborhoodReductions({7, 9}, radius, wrapAround);
+      expectNeighborhoodReductions({10, 1}, radius, wrapAround);
+      expectNeighborhoodReductions({4, 5, 6}, radius, wrapAround);
+    }
+  }
+}
 } // namespace
@@ -24,9 +24,12 @@
  * Implementation of BasicType test
  */
 
+#include <cmath>
 #include <limits>
+#include <vector>
 
 #include <gtest/gtest.h>
+#include <nupic/math/Simd.hpp>
 #include <nupic/ntypes/BasicType.hpp>
 
 namespace testing {
@@ -586,4 +589,71 @@ TEST(BasicTypeTest, convertArray) {
                           NTA_BasicType_Bool, 8);
   ASSERT_TRUE(ca.checkArrayBool<bool>(ca.dest)) << "bool to bool conversion";
 }
+
+// Long enough for the vector loops, with a tail for the scalar loops.
+template <typename T, typename F>
+static void checkConversion(const std::vector<F> &from) {
+  namespace simd = nupic::math::simd;
+  for (const auto isa : {simd::Isa::SCALAR, simd::Isa::SSE2, simd::Isa::AVX}) {
+    if (!simd::supported(isa)) continue;
+    std::vector<T> to(from.size());
+    simd::convert(to.data(), from.data(), from.size(), isa);
+    for (size_t i = 0; i < from.size(); i++) {
+      ASSERT_EQ(static_cast<T>(from[i]), to[i])
+          << "index " << i << ", " << simd::name(isa);
+    }
+  }
+}
+
+TEST(BasicTypeTest, convertArrayVectorized) {
+  const size_t n = 37u;
+  std::vector<Byte> bytes(n);
+  std::vector<Int32> ints(n);
+  std::vector<Real32> reals32(n);
+  std::vector<Real64> reals64(n);
+  for (size_t i = 0; i < n; i++) {
+    bytes[i]   = static_cast<Byte>(i * 7u - 100u);
+    ints[i]    = static_cast<Int32>(i * 123457u) - 1000000;
+    reals32[i] = static_cast<Real32>(i) * -1.37f + 3.0f;
+    reals64[i] = static_cast<Real64>(i) * 0.1 - 1.0e10;
+  }
+  checkConversion<Real32>(bytes);
+  checkConversion<Real32>(ints);
+  checkConversion<Real64>(reals32);
+  checkConversion<Real32>(reals64);
+
+  std::vector<Real64> dest(n);
+  BasicType::convertArray(dest.data(), NTA_BasicType_Real64, reals32.data(),
+                          NTA_BasicType_Real32, n);
+  for (size_t i = 0; i < n; i++) {
+    ASSERT_EQ(static_cast<Real64>(reals32[i]), dest[i]);
+  }
+
+  // The range is checked before anything is converted.
+  std::vector<Byte> small(n, 0);
+  std::vector<Real32> values(n, 1.0f);
+  values[n - 1u] = 1000.0f;
+  EXPECT_THROW(BasicType::convertArray(small.data(), NTA_BasicType_Byte, values.data(),
+                                       NTA_BasicType_Real32, n), std::exception);
+  EXPECT_EQ(std::vector<Byte>(n, 0), small);
+  values[n - 1u] = std::nan("");
+  EXPECT_THROW(BasicType::convertArray(small.data(), NTA_BasicType_Byte, values.data(),
+                                       NTA_BasicType_Real32, n), std::exception);
+  values[n - 1u] = 1.0f;
+  BasicType::convertArray(small.data(), NTA_BasicType_Byte, values.data(),
+                          NTA_BasicType_Real32, n);
+  EXPECT_EQ(std::vector<Byte>(n, 1), small);
+
+  namespace simd = nupic::math::simd;
+  for (const auto isa : {simd::Isa::SCALAR, simd::Isa::SSE2, simd::Isa::AVX}) {
+    if (!simd::supported(isa)) continue;
+    EXPECT_TRUE(simd::inRange(reals64.data(), n, -1.0e10, 0.0, isa));
+    EXPECT_FALSE(simd::inRange(reals64.data(), n, -1.0e9, 0.0, isa));
+    EXPECT_FALSE(simd::inRange(values.data(), n, 2.0f, 3.0f, isa));
+    values[3] = std::nanf("");
+    EXPECT_FALSE(simd::inRange(values.data(), n, 0.0f, 2.0f, isa));
+    values[3] = 1.0f;
+    EXPECT_TRUE(simd::inRange(values.data(), n, 0.0f, 2.0f, isa));
+  }
+}
 }
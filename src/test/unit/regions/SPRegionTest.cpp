@@ -77,7 +77,7 @@
 static bool verbose = false;  // turn this on to print extra stuff for debugging the test.
 
 // The following string should contain a valid expected Spec - manually verified. 
-#define EXPECTED_SPEC_COUNT  22  // The number of parameters expected in the SPRegion Spec
+#define EXPECTED_SPEC_COUNT  23  // The number of parameters expected in the SPRegion Spec
 
 using namespace nupic;
 namespace testing 
@@ -220,6 +220,36 @@ TEST(SdrTest, TestSetSparseInplace) {
     ASSERT_EQ( a.getDense(), vector<Byte>(a.size, 0) );
 }
 
+TEST(SdrTest, TestGetSparseSorted) {
+    SDR a({ 10 });
+    a.setSparse(SDR_sparse_t({ 7, 2, 5 }));
+    ASSERT_EQ( a.getSparseSorted(), SDR_sparse_t({ 2, 5, 7 }));
+    // The SDR's own sparse vector is sorted now.
+    ASSERT_EQ( a.getSparse(), SDR_sparse_t({ 2, 5, 7 }));
+
+    // Already sorted data is returned as is, not sorted again.
+    SDR_sparse_t sorted({ 1, 3, 9 });
+    a.setSparseSorted( sorted );
+    auto &data = a.getSparse();
+    std::swap( data[0], data[1] ); // Not notifying the SDR, for the test only.
+    ASSERT_EQ( a.getSparseSorted(), SDR_sparse_t({ 3, 1, 9 }));
+
+    a.setSparseSorted(vector<UInt>({ 0, 4 }));
+    ASSERT_EQ( a.getSparseSorted(), SDR_sparse_t({ 0, 4 }));
+
+    // Sparse data converted from dense is sorted.
+    a.setDense(SDR_dense_t({ 0, 1, 0, 0, 1, 0, 0, 1, 0, 1 }));
+    ASSERT_EQ( a.getSparseSorted(), SDR_sparse_t({ 1, 4, 7, 9 }));
+
+    // Coordinates are converted in their own order, and sorted when asked.
+    SDR b({ 3, 3 });
+    b.setCoordinates(SDR_coordinate_t({{ 2, 0, 1 }, { 1, 1, 2 }}));
+    ASSERT_EQ( b.getSparse(), SDR_sparse_t({ 7, 1, 5 }));
+    ASSERT_EQ( b.getSparseSorted(), SDR_sparse_t({ 1, 5, 7 }));
+    // The coordinates follow the sorted order.
+    ASSERT_EQ( b.getCoordinates(), SDR_coordinate_t({{ 0, 1, 2 }, { 1, 2, 1 }}));
+}
+
 TEST(SdrTest, TestSetCoordinates) {
     SDR a({4, 1, 3});
     void *before = a.getCoordinates().data();
@@ -425,6 +455,27 @@ TEST(SdrTest, TestGetCoordinatesFromDense) {
     ASSERT_EQ( a.getCoordinates()[1].size(), 0ul );
 }
 
+TEST(SdrTest, TestGetPacked) {
+    SDR a({ 10, 13 });
+    a.setSparse(SDR_sparse_t({ 0, 63, 64, 100, 129 }));
+    SDR_packed_t expected({ 1ull | (1ull << 63), 1ull | (1ull << 36), 2ull });
+    ASSERT_EQ( a.getPacked(), expected );
+
+    // Swap the packed words back in, and convert to the other formats.
+    SDR b({ 10, 13 });
+    b.setPacked( expected );
+    ASSERT_EQ( b.getSparse(), SDR_sparse_t({ 0, 63, 64, 100, 129 }));
+    ASSERT_EQ( b.getDense(), a.getDense() );
+    ASSERT_EQ( b.getCoordinates(), a.getCoordinates() );
+    ASSERT_EQ( a, b );
+
+    // Modify the packed words inplace.
+    auto &packed = b.getPacked();
+    packed[1] = 0u;
+    b.setPacked( packed );
+    ASSERT_EQ( b.getSparse(), SDR_sparse_t({ 0, 63, 129 }));
+}
+
 TEST(SdrTest, TestAt) {
     SDR a({3, 3});
     a.setSparse(SDR_sparse_t( {4, 5, 8} ));
@@ -470,6 +521,14 @@ TEST(SdrTest, TestPrint) {
     str3 << sdr3;
     ASSERT_NE( str3.str().find( "SDR( 3, 3 ) 1, 4, 8" ), std::string::npos);
 
+    // Unsorted data is printed in order, and the SDR keeps its own order.
+    stringstream str4;
+    SDR sdr4({ 10 });
+    sdr4.setSparse(SDR_sparse_t({ 7, 2, 5 }));
+    str4 << sdr4;
+    ASSERT_NE( str4.str().find( "SDR( 10 ) 2, 5, 7" ), std::string::npos);
+    ASSERT_EQ( sdr4.getSparse(), SDR_sparse_t({ 7, 2, 5 }));
+
     // Check that default aruments don't crash.
     cout << "PRINTING \"SDR( 3, 3 ) 1, 4, 8\" TO STDOUT: ";
     cout << sdr3;
@@ -488,6 +547,20 @@ TEST(SdrTest, TestGetOverlap) {
     ASSERT_EQ( a.getOverlap( b ), 0ul );
 }
 
+TEST(SdrTest, TestGetOverlapLarge) {
+    Random rng(42);
+    SDR a({ 1000 });
+    SDR b({ 1000 });
+    for( UInt i = 0u; i < 10u; i++ ) {
+        a.randomize( 0.3f, rng );
+        b.randomize( 0.3f, rng );
+        UInt expected = 0u;
+        for( UInt j = 0u; j < a.size; j++ )
+            expected += a.getDense()[j] && b.getDense()[j];
+        ASSERT_EQ( a.getOverlap( b ), expected );
+    }
+}
+
 TEST(SdrTest, TestRandomize) {
     // Test sparsity is OK
     SDR a({1000});
@@ -617,6 +690,21 @@ TEST(SdrTest, TestIntersection) {
     ASSERT_EQ( X.getSum(), 0u );
 }
 
+TEST(SdrTest, TestUnion) {
+    SDR A({ 10 });
+    SDR B({ 10 });
+    SDR C({ 10 });
+    A.setSparse(SDR_sparse_t{0, 1, 2, 3});
+    B.setSparse(SDR_sparse_t      {2, 3, 4, 5});
+    C.setUnion(A, B);
+    ASSERT_EQ(C.getSparse(), SDR_sparse_t({0, 1, 2, 3, 4, 5}));
+
+    // Inplace, and with more than two inputs.
+    C.setSparse(SDR_sparse_t{9});
+    C.setUnion({ &A, &C, &B });
+    ASSERT_EQ(C.getSparse(), SDR_sparse_t({0, 1, 2, 3, 4, 5, 9}));
+}
+
 TEST(SdrTest, TestConcatenationExampleUsage) {
     SDR A({ 10 });
     SDR B({ 10 });
@@ -640,6 +728,23 @@ TEST(SdrTest, TestConcatenation) {
     ASSERT_EQ( D.getSum(), 10u );
 }
 
+TEST(SdrTest, TestConcatenationRows) {
+    // Rows of 3 and 70 bits, which do not line up with the packed words.
+    SDR A({ 5, 3 });
+    SDR B({ 5, 70 });
+    SDR C({ 5, 73 });
+    A.randomize( 0.5f );
+    B.randomize( 0.2f );
+    C.concatenate( A, B, 1u );
+    for( UInt row = 0u; row < 5u; row++ ) {
+        for( UInt col = 0u; col < 73u; col++ ) {
+            const auto expected = col < 3u ? A.at({ row, col })
+                                           : B.at({ row, col - 3u });
+            ASSERT_EQ( C.at({ row, col }), expected );
+        }
+    }
+}
+
 TEST(SdrTest, TestEquality) {
     vector<SDR*> test_cases;
     // Test different dimensions
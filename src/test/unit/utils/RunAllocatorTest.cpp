@@ -0,0 +1,210 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2019, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+#include "gtest/gtest.h"
+
+#include "nupic/utils/RunAllocator.hpp"
+
+namespace testing {
+
+using nupic::UInt32;
+namespace util = nupic::util;
+using nupic::util::RunAllocator;
+
+TEST(RunAllocator, GrowInPlaceAtEnd) {
+  RunAllocator runs;
+  util::Run run = {0u, 0u, 0u};
+
+  EXPECT_EQ(0u, runs.grow(run));
+  EXPECT_EQ(4u, run.capacity);
+  EXPECT_EQ(4u, runs.size());
+
+  // Room left, nothing changes.
+  run.size = 3u;
+  runs.grow(run);
+  EXPECT_EQ(4u, run.capacity);
+
+  // The last run grows in place: 4, 6, 8, 12, 16, ...
+  const UInt32 expected[] = {6u, 8u, 12u, 16u, 24u, 32u};
+  for (UInt32 capacity : expected) {
+    run.size = run.capacity;
+    EXPECT_EQ(0u, runs.grow(run));
+    EXPECT_EQ(0u, run.offset);
+    EXPECT_EQ(capacity, run.capacity);
+    EXPECT_EQ(capacity, runs.size());
+  }
+}
+
+TEST(RunAllocator, Reserve) {
+  RunAllocator runs;
+  util::Run a = {0u, 0u, 0u};
+  util::Run b = {0u, 0u, 0u};
+
+  // Rounds up to a run capacity.
+  EXPECT_EQ(0u, runs.reserve(a, 10u));
+  EXPECT_EQ(12u, a.capacity);
+  EXPECT_EQ(12u, runs.size());
+
+  // Enough room already.
+  runs.reserve(a, 12u);
+  EXPECT_EQ(12u, a.capacity);
+
+  runs.reserve(b, 3u);
+  EXPECT_EQ(12u, b.offset);
+  EXPECT_EQ(4u, b.capacity);
+
+  // a moves, and keeps its size.
+  a.size = 5u;
+  EXPECT_EQ(0u, runs.reserve(a, 13u));
+  EXPECT_EQ(16u, a.offset);
+  EXPECT_EQ(5u, a.size);
+  EXPECT_EQ(16u, a.capacity);
+  EXPECT_EQ(32u, runs.size());
+}
+
+TEST(RunAllocator, MoveAndReuse) {
+  RunAllocator runs;
+  util::Run a = {0u, 0u, 0u};
+  util::Run b = {0u, 0u, 0u};
+  runs.grow(a);
+  runs.grow(b);
+  EXPECT_EQ(0u, a.offset);
+  EXPECT_EQ(4u, b.offset);
+
+  // a is not at the end of the arena, so it moves and keeps its size.
+  a.size = 4u;
+  EXPECT_EQ(0u, runs.grow(a));
+  EXPECT_EQ(8u, a.offset);
+  EXPECT_EQ(4u, a.size);
+  EXPECT_EQ(6u, a.capacity);
+  EXPECT_EQ(14u, runs.size());
+  ASSERT_EQ(5u, runs.freeRuns().size());
+  EXPECT_EQ(std::vector<UInt32>({0u}), runs.freeRuns()[4]);
+
+  // A new run reuses the released one.
+  util::Run c = {0u, 0u, 0u};
+  runs.grow(c);
+  EXPECT_EQ(0u, c.offset);
+  EXPECT_EQ(14u, runs.size());
+  EXPECT_TRUE(runs.freeRuns()[4].empty());
+
+  runs.release(b);
+  EXPECT_EQ(0u, b.capacity);
+  EXPECT_EQ(std::vector<UInt32>({4u}), runs.freeRuns()[4]);
+
+  runs.clear();
+  EXPECT_EQ(0u, runs.size());
+  EXPECT_TRUE(runs.freeRuns().empty());
+}
+
+TEST(RunAllocator, Fragmented) {
+  RunAllocator runs;
+  std::vector<util::Run> lists(1000u, util::Run{0u, 0u, 0u});
+  for (auto &run : lists) {
+    runs.grow(run);
+  }
+  EXPECT_FALSE(runs.fragmented(lists.size()));
+
+  // Every list outgrows its run at the same time, leaving the old runs
+  // behind.
+  for (auto &run : lists) {
+    run.size = run.capacity;
+    runs.grow(run);
+  }
+  EXPECT_EQ(10000u, runs.size());
+  EXPECT_TRUE(runs.fragmented(lists.size()));
+  EXPECT_FALSE(runs.fragmented(10u * lists.size()));
+
+  runs.packed(6000u);
+  EXPECT_EQ(6000u, runs.size());
+  EXPECT_FALSE(runs.fragmented(lists.size()));
+  EXPECT_TRUE(runs.freeRuns().empty());
+
+  // Restoring the free lists restores the released space.
+  RunAllocator copy;
+  std::vector<std::vector<UInt32>> freeRuns(5u);
+  for (UInt32 i = 0; i < 1000u; i++) {
+    freeRuns[4].push_back(4u * i);
+  }
+  copy.restore(10000u, freeRuns);
+  EXPECT_TRUE(copy.fragmented(lists.size()));
+}
+
+TEST(RunAllocator, CheckOverlap) {
+  RunAllocator runs;
+  std::vector<std::vector<UInt32>> freeRuns(5u);
+  freeRuns[4].push_back(8u);
+  runs.restore(16u, freeRuns);
+
+  // Disjoint runs pass, and empty runs are skipped.
+  EXPECT_NO_THROW(runs.check({{0u, 4u, 4u}, {4u, 0u, 4u}, {12u, 0u, 0u}}));
+
+  // Two live runs overlap.
+  EXPECT_ANY_THROW(runs.check({{0u, 4u, 4u}, {2u, 0u, 4u}}));
+  // A live run overlaps a released run.
+  EXPECT_ANY_THROW(runs.check({{6u, 1u, 4u}}));
+  // A live run is past the end of the arena, or longer than its capacity.
+  EXPECT_ANY_THROW(runs.check({{0u, 4u, 4u}, {16u, 0u, 4u}}));
+  EXPECT_ANY_THROW(runs.check({{0u, 6u, 4u}}));
+
+  // Released runs may not overlap each other either.
+  freeRuns[4].push_back(10u);
+  RunAllocator corrupt;
+  EXPECT_ANY_THROW(corrupt.restore(16u, freeRuns));
+}
+
+TEST(RunAllocator, CheckCapacity) {
+  RunAllocator runs;
+  runs.restore(64u, {});
+
+  // Every capacity in the sequence passes.
+  EXPECT_NO_THROW(runs.check({{0u, 0u, 4u}, {4u, 0u, 6u}, {10u, 0u, 8u},
+                              {18u, 0u, 12u}, {30u, 0u, 16u}}));
+
+  // Below the smallest capacity, or between two capacities.
+  EXPECT_ANY_THROW(runs.check({{0u, 1u, 1u}}));
+  EXPECT_ANY_THROW(runs.check({{0u, 0u, 3u}}));
+  EXPECT_ANY_THROW(runs.check({{0u, 5u, 5u}}));
+  EXPECT_ANY_THROW(runs.check({{0u, 0u, 9u}}));
+}
+
+TEST(RunAllocator, RestoreSizeClass) {
+  // The classes below the smallest capacity hold no runs.
+  for (size_t cls = 0u; cls < 4u; cls++) {
+    std::vector<std::vector<UInt32>> freeRuns(cls + 1u);
+    freeRuns[cls].push_back(0u);
+    RunAllocator runs;
+    EXPECT_ANY_THROW(runs.restore(16u, freeRuns)) << cls;
+  }
+
+  // Nor do the classes past the largest capacity.
+  std::vector<std::vector<UInt32>> freeRuns(65u);
+  freeRuns[64].push_back(0u);
+  RunAllocator runs;
+  EXPECT_ANY_THROW(runs.restore(16u, freeRuns));
+
+  std::vector<std::vector<UInt32>> valid(5u);
+  valid[4].push_back(0u);
+  EXPECT_NO_THROW(runs.restore(16u, valid));
+}
+
+} // namespace testing
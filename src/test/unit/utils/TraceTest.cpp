@@ -0,0 +1,117 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2019, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "nupic/engine/Network.hpp"
+#include "nupic/engine/Region.hpp"
+#include "nupic/utils/Trace.hpp"
+
+namespace testing {
+
+using std::string;
+using nupic::Network;
+using nupic::util::Trace;
+using nupic::util::TraceScope;
+
+static size_t countOf(const string &text, const string &pattern) {
+  size_t count = 0u;
+  for (size_t at = text.find(pattern); at != string::npos;
+       at = text.find(pattern, at + 1u)) {
+    count++;
+  }
+  return count;
+}
+
+static string traceJson() {
+  std::stringstream json;
+  Trace::writeJson(json);
+  return json.str();
+}
+
+TEST(TraceTest, Disabled) {
+  Trace::disable();
+  Trace::clear();
+  { TraceScope scope("test", "disabled"); }
+  ASSERT_EQ(0u, countOf(traceJson(), "\"disabled\""));
+}
+
+TEST(TraceTest, Scopes) {
+  Trace::enable();
+  Trace::clear();
+  {
+    TraceScope outer("test", "outer", string("obj\"ect"));
+    TraceScope inner("test", "inner");
+  }
+  std::thread([] { TraceScope scope("test", "thread"); }).join();
+  Trace::disable();
+
+  const string json = traceJson();
+  EXPECT_EQ(0u, json.find("{\"traceEvents\":["));
+  EXPECT_EQ(1u, countOf(json, "\"name\":\"obj\\\"ect.outer\",\"cat\":\"test\",\"ph\":\"X\""));
+  EXPECT_EQ(1u, countOf(json, "\"name\":\"inner\""));
+  EXPECT_EQ(1u, countOf(json, "\"name\":\"thread\""));
+  Trace::clear();
+}
+
+TEST(TraceTest, RingBufferKeepsNewest) {
+  Trace::enable(4u);
+  for (int i = 0; i < 3; i++) {
+    TraceScope scope("test", "old");
+  }
+  for (int i = 0; i < 4; i++) {
+    TraceScope scope("test", "new");
+  }
+  Trace::disable();
+  const string json = traceJson();
+  EXPECT_EQ(0u, countOf(json, "\"old\""));
+  EXPECT_EQ(4u, countOf(json, "\"new\""));
+  Trace::enable();  // back to the default size, which discards the events
+  Trace::disable();
+  EXPECT_EQ(0u, countOf(traceJson(), "\"new\""));
+}
+
+TEST(TraceTest, Network) {
+  Network net;
+  net.addRegion("region1", "TestNode", "{count: 8}");
+  net.addRegion("region2", "TestNode", "");
+  net.link("region1", "region2");
+  net.initialize();
+
+  Trace::enable();
+  Trace::clear();
+  net.run(3);
+  Trace::disable();
+
+  const string json = traceJson();
+  EXPECT_EQ(3u, countOf(json, "\"name\":\"iteration\""));
+  EXPECT_EQ(3u, countOf(json, "\"name\":\"region1.compute\""));
+  EXPECT_EQ(3u, countOf(json, "\"name\":\"region2.compute\""));
+  EXPECT_EQ(3u, countOf(json, "\"name\":\"region2.prepareInputs\""));
+  Trace::clear();
+}
+
+} // namespace testing